@@ -3,6 +3,7 @@
 #include "nda/lapack/geqp3.hpp"
 #include "nda/layout/policies.hpp"
 #include <cppdlr/cppdlr.hpp>
+#include <fmt/format.h>
 
 using namespace dlr2d;
 
@@ -11,9 +12,6 @@ int main() {
   int n      = 1000; // Matrix size
   double eps = 1e-8;
 
-  double alpha = 2;
-  int nvec     = 100;
-
   double rate = 1.05;
 
   // Random matrix with decaying singular values
@@ -37,46 +35,32 @@ int main() {
   auto tau = nda::vector<dcomplex>(n);
   nda::lapack::geqp3(a, piv, tau);
 
-  // Estimate rank the old-fashioned way
-  int rank1 = 0;
-  for (int k = 0; k < n; ++k) {
-    if (abs(a(k, k)) < eps) {
-      rank1 = k;
-      break;
-    }
-  }
-
-  // Estimate rank using randomized algorithm
-  int rank2 = estimate_rank(a, eps, alpha, nvec);
-
-  PRINT(rank1);
-  PRINT(rank2);
   PRINT(log(1 / eps) / log(rate));
 
-  // Compute the true spectral norm of R22 for each rank
+  // Compare rank estimation strategies: estimated rank, runtime, and true
+  // spectral norm of R22 = R(rank:, rank:), which should be below eps
+  for (auto rankmethod : {DiagThreshold, FrobeniusTail, Randomized}) {
+    auto start = std::chrono::high_resolution_clock::now();
+    int rank   = qr_rank(a, eps, rankmethod);
+    auto end   = std::chrono::high_resolution_clock::now();
 
-  auto r22_1 = fmatrix(n - rank1, n - rank1);
-  auto r22_2 = fmatrix(n - rank2, n - rank2);
-  r22_1      = 0;
-  r22_2      = 0;
-  for (int i = rank1 + 1; i < n; i++) {
-    for (int j = i; j < n; j++) { r22_1(i - rank1 - 1, j - rank1 - 1) = a(i, j); }
-  }
-  for (int i = rank2 + 1; i < n; i++) {
-    for (int j = i; j < n; j++) { r22_2(i - rank2 - 1, j - rank2 - 1) = a(i, j); }
-  }
-
-  auto u1  = fmatrix(n - rank1, n - rank1);
-  auto vt1 = fmatrix(n - rank1, n - rank1);
-  auto s1  = nda::vector<double>(n - rank1);
-  nda::lapack::gesvd(r22_1, s1, u1, vt1);
+    if (rank == n) {
+      fmt::print("{}: rank = {}, time = {}\n", rankmethod_name(rankmethod), rank, std::chrono::duration<double>(end - start).count());
+      continue;
+    }
 
-  PRINT(s1(0));
+    auto r22 = fmatrix(n - rank, n - rank);
+    r22      = 0;
+    for (int i = rank; i < n; i++) {
+      for (int j = i; j < n; j++) { r22(i - rank, j - rank) = a(i, j); }
+    }
 
-  auto u2  = fmatrix(n - rank2, n - rank2);
-  auto vt2 = fmatrix(n - rank2, n - rank2);
-  auto s2  = nda::vector<double>(n - rank2);
-  nda::lapack::gesvd(r22_2, s2, u2, vt2);
+    auto u22  = fmatrix(n - rank, n - rank);
+    auto vt22 = fmatrix(n - rank, n - rank);
+    auto s22  = nda::vector<double>(n - rank);
+    nda::lapack::gesvd(r22, s22, u22, vt22);
 
-  PRINT(s2(0));
+    fmt::print("{}: rank = {}, time = {}, ||R22||_2 = {}\n", rankmethod_name(rankmethod), rank,
+               std::chrono::duration<double>(end - start).count(), s22(0));
+  }
 }
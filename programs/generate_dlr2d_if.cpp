@@ -19,13 +19,29 @@ using namespace dlr2d;
  * Matsubara frequency grid from combinations of 1D DLR grid points. If
  * threeterm is set to true, it uses a three-term version of the Lehmann
  * representation, obtained by absorbing one of the terms into the others,
- * rather than the one presented in that paper.
+ * rather than the one presented in that paper. If tournament is set to true,
+ * the grid is selected by tournament pivoting over nchunk chunks of the fine
+ * grid in parallel, rather than by a single pivoted QR decomposition. If
+ * streaming is set to true, the fine grid is instead processed in tiles with
+ * bounded memory, optionally using a Gaussian sketch of dimension nsketch
+ * (=0 for none). If nested is set to true, the grids for the (increasing) list
+ * of lambdas are generated as a nested family, each containing the previous
+ * one, so that data sampled for a smaller lambda remains usable for the
+ * larger ones. The numerical rank of the fine grid system is determined by
+ * rankmethod (see qr_rank).
  */
 int main() {
 
   double eps         = 1e-12;                  // DLR tolerance
   bool threeterm     = false;                  // 2+1 or 3+1-term 2D DLR
   bool compressbasis = true;                   // Overcomplete or compressed basis
+  bool tournament    = false;                  // Tournament pivoting for grid selection
+  int nchunk         = 8;                      // # chunks for tournament pivoting
+  bool streaming     = false;                  // Bounded-memory streaming pivoting
+  int tilesize       = 1024;                   // # fine grid nodes per tile for streaming pivoting
+  int nsketch        = 0;                      // Sketch dimension for streaming pivoting
+  bool nested        = false;                  // Nested grids across lambdas
+  auto rankmethod    = DiagThreshold;          // Rank estimation strategy
   auto path          = "../../dlr2d_if_data/"; // Path for DLR 2D grid data
 
   // auto lambdas = nda::vector<double>(
@@ -34,19 +50,34 @@ int main() {
   //     nda::vector<double>({1.0, 2.0, 4.0, 8.0, 16.0, 32.0, 64.0, 128.0});
   auto lambdas = nda::vector<double>({64.0});
 
+  if (nested) {
+    fmt::print("Obtaining nested 2D imag freq DLR grids...\n");
+    auto start = std::chrono::high_resolution_clock::now();
+    build_dlr2d_if_ladder(lambdas, eps, path, rankmethod);
+    auto end = std::chrono::high_resolution_clock::now();
+    fmt::print("Time: {}\n", std::chrono::duration<double>(end - start).count());
+    return 0;
+  }
+
   for (int i = 0; i < lambdas.size(); i++) {
 
     fmt::print("Obtaining 2D imag freq DLR grid...\n");
     auto start = std::chrono::high_resolution_clock::now();
     if (threeterm) {
       auto filename = get_filename_3term(lambdas(i), eps);
-      build_dlr2d_if_3term(lambdas(i), eps, path, filename);
+      build_dlr2d_if_3term(lambdas(i), eps, path, filename, rankmethod);
     } else if (compressbasis) {
       auto filename = get_filename(lambdas(i), eps, true);
-      build_dlr2d_ifrf(lambdas(i), eps, path, filename);
+      build_dlr2d_ifrf(lambdas(i), eps, path, filename, rankmethod);
+    } else if (streaming) {
+      auto filename = get_filename(lambdas(i), eps);
+      build_dlr2d_if_streaming(lambdas(i), eps, tilesize, nsketch, path, filename, rankmethod);
+    } else if (tournament) {
+      auto filename = get_filename(lambdas(i), eps);
+      build_dlr2d_if_tournament(lambdas(i), eps, nchunk, path, filename, rankmethod);
     } else {
       auto filename = get_filename(lambdas(i), eps);
-      build_dlr2d_if(lambdas(i), eps, path, filename);
+      build_dlr2d_if(lambdas(i), eps, path, filename, rankmethod);
     }
     auto end = std::chrono::high_resolution_clock::now();
     fmt::print("Time: {}\n", std::chrono::duration<double>(end - start).count());
@@ -63,7 +63,7 @@ nda::vector<double> hubatom_allfuncs(double beta, double u, double lambda, doubl
   auto dlr_if_bos = ifops_bos.get_ifnodes();
 
   // Evaluate Green's function on 1D DLR grid and obtain its DLR coefficients
-  std::complex<double> nu1 = 0, nu2 = 0;
+  std::complex<double> nu1 = 0;
   auto g  = nda::vector<dcomplex>(r);
   auto gr = nda::vector<dcomplex>(r); // G reversed: G(-i nu_n)
   for (int k = 0; k < r; ++k) {
@@ -76,28 +76,13 @@ nda::vector<double> hubatom_allfuncs(double beta, double u, double lambda, doubl
 
   // Evaluate correlation and vertex functions on 2D DLR grid and obtain DLR
   // coefficients
-  auto chi_s = nda::vector<dcomplex>(niom);
-  auto chi_d = nda::vector<dcomplex>(niom);
-  auto chi_m = nda::vector<dcomplex>(niom);
-  auto lam_s = nda::vector<dcomplex>(niom);
-  auto lam_d = nda::vector<dcomplex>(niom);
-  auto lam_m = nda::vector<dcomplex>(niom);
-  for (int k = 0; k < niom; ++k) {
-    nu1      = (2 * dlr2d_if(k, 0) + 1) * pi * 1i / beta;
-    nu2      = (2 * dlr2d_if(k, 1) + 1) * pi * 1i / beta;
-    chi_s(k) = chi_s_fun(u, beta, nu1, nu2);
-    lam_s(k) = lam_s_fun(u, beta, nu1, nu2);
-  }
-  for (int k = 0; k < niom; ++k) {
-    nu1      = (2 * dlr2d_if_ph(k, 0) + 1) * pi * 1i / beta;
-    nu2      = (2 * dlr2d_if_ph(k, 1) + 1) * pi * 1i / beta;
-    chi_d(k) = chi_d_fun(u, beta, nu1, nu2);
-    chi_m(k) = chi_m_fun(u, beta, nu1, nu2);
-    lam_d(k) = lam_d_fun(u, beta, nu1, nu2);
-    lam_m(k) = lam_m_fun(u, beta, nu1, nu2);
-  }
+  auto chi_s = chi_s_fun_batch(u, beta, dlr2d_if);
+  auto chi_d = chi_d_fun_batch(u, beta, dlr2d_if_ph);
+  auto chi_m = chi_m_fun_batch(u, beta, dlr2d_if_ph);
+  auto lam_s = lam_s_fun_batch(u, beta, dlr2d_if);
+  auto lam_d = lam_d_fun_batch(u, beta, dlr2d_if_ph);
+  auto lam_m = lam_m_fun_batch(u, beta, dlr2d_if_ph);
 
-  fmt::print("Obtaining DLR coefficients of chi, lambda...\n");
   auto chi_s_c     = nda::array<dcomplex, 3>();
   auto chi_d_c     = nda::array<dcomplex, 3>();
   auto chi_m_c     = nda::array<dcomplex, 3>();
@@ -111,122 +96,117 @@ nda::vector<double> hubatom_allfuncs(double beta, double u, double lambda, doubl
   auto lam_d_csing = nda::array<dcomplex, 1>();
   auto lam_m_csing = nda::array<dcomplex, 1>();
 
+  // Evaluators of expansions and true functions on tiles of the test grid
+  auto eval = [&](auto const &c, auto const &csing, int channel) {
+    return [&, channel](nda::array_const_view<int, 2> idx) { return coefs2eval_if(beta, dlr_rf, c, csing, idx, channel); };
+  };
+  auto tru = [&](auto f) {
+    return [&, f](nda::array_const_view<int, 2> idx) { return f(u, beta, idx); };
+  };
+  auto itops = imtime_ops(lambda, dlr_rf);
+
+  // Fitting, error measurement and polarization as a graph of OpenMP tasks.
+  // Each channel's fit depends only on the system matrix, its error
+  // measurement and polarization depend only on its fit, and the singular
+  // coefficients are written together with the regular ones, so the
+  // dependences are tracked through the latter.
+  double chi_s_l2 = 0, chi_s_linf = 0, chi_s_l2err = 0, chi_s_linferr = 0;
+  double chi_d_l2 = 0, chi_d_linf = 0, chi_d_l2err = 0, chi_d_linferr = 0;
+  double chi_m_l2 = 0, chi_m_linf = 0, chi_m_l2err = 0, chi_m_linferr = 0;
+  double lam_s_l2 = 0, lam_s_linf = 0, lam_s_l2err = 0, lam_s_linferr = 0;
+  double lam_d_l2 = 0, lam_d_linf = 0, lam_d_l2err = 0, lam_d_linferr = 0;
+  double lam_m_l2 = 0, lam_m_linf = 0, lam_m_l2err = 0, lam_m_linferr = 0;
+  auto pol_s   = nda::vector<dcomplex>();
+  auto pol_d   = nda::vector<dcomplex>();
+  auto pol_m   = nda::vector<dcomplex>();
+  auto pol_s_c = nda::array<dcomplex, 1>();
+  auto pol_d_c = nda::array<dcomplex, 1>();
+  auto pol_m_c = nda::array<dcomplex, 1>();
+
+  fmt::print("Fitting chi, lambda, testing expansions and computing polarization...\n");
   auto start = std::chrono::high_resolution_clock::now();
-  if (!compressbasis) {
-    auto valsall  = fmatrix(niom, 6);
-    valsall(_, 0) = chi_s;
-    valsall(_, 1) = chi_d;
-    valsall(_, 2) = chi_m;
-    valsall(_, 3) = lam_s;
-    valsall(_, 4) = lam_d;
-    valsall(_, 5) = lam_m;
-
-    auto [coefsall, coefsingall] = vals2coefs_if_many(kmat, valsall, r);
-
-    chi_s_c     = coefsall(0, _, _, _);
-    chi_d_c     = coefsall(1, _, _, _);
-    chi_m_c     = coefsall(2, _, _, _);
-    lam_s_c     = coefsall(3, _, _, _);
-    lam_d_c     = coefsall(4, _, _, _);
-    lam_m_c     = coefsall(5, _, _, _);
-    chi_s_csing = coefsingall(0, _);
-    chi_d_csing = coefsingall(1, _);
-    chi_m_csing = coefsingall(2, _);
-    lam_s_csing = coefsingall(3, _);
-    lam_d_csing = coefsingall(4, _);
-    lam_m_csing = coefsingall(5, _);
+  blas_thread_scope blas(1); // Tasks run concurrently, one BLAS thread each
+#pragma omp parallel
+#pragma omp single
+  {
+    // Fits
+    if (!compressbasis) {
+#pragma omp task depend(out : chi_s_c, chi_d_c, chi_m_c, lam_s_c, lam_d_c, lam_m_c)
+      {
+        auto valsall  = fmatrix(niom, 6);
+        valsall(_, 0) = chi_s;
+        valsall(_, 1) = chi_d;
+        valsall(_, 2) = chi_m;
+        valsall(_, 3) = lam_s;
+        valsall(_, 4) = lam_d;
+        valsall(_, 5) = lam_m;
+
+        auto [coefsall, coefsingall] = vals2coefs_if_many(kmat, valsall, r);
+
+        chi_s_c     = coefsall(0, _, _, _);
+        chi_d_c     = coefsall(1, _, _, _);
+        chi_m_c     = coefsall(2, _, _, _);
+        lam_s_c     = coefsall(3, _, _, _);
+        lam_d_c     = coefsall(4, _, _, _);
+        lam_m_c     = coefsall(5, _, _, _);
+        chi_s_csing = coefsingall(0, _);
+        chi_d_csing = coefsingall(1, _);
+        chi_m_csing = coefsingall(2, _);
+        lam_s_csing = coefsingall(3, _);
+        lam_d_csing = coefsingall(4, _);
+        lam_m_csing = coefsingall(5, _);
+      }
+    } else {
+#pragma omp task depend(out : chi_s_c)
+      std::tie(chi_s_c, chi_s_csing) = uncompress_basis(r, dlr2d_rfidx, vals2coefs_if_square(kmat, chi_s));
+#pragma omp task depend(out : chi_d_c)
+      std::tie(chi_d_c, chi_d_csing) = uncompress_basis(r, dlr2d_rfidx, vals2coefs_if_square(kmat, chi_d));
+#pragma omp task depend(out : chi_m_c)
+      std::tie(chi_m_c, chi_m_csing) = uncompress_basis(r, dlr2d_rfidx, vals2coefs_if_square(kmat, chi_m));
+#pragma omp task depend(out : lam_s_c)
+      std::tie(lam_s_c, lam_s_csing) = uncompress_basis(r, dlr2d_rfidx, vals2coefs_if_square(kmat, lam_s));
+#pragma omp task depend(out : lam_d_c)
+      std::tie(lam_d_c, lam_d_csing) = uncompress_basis(r, dlr2d_rfidx, vals2coefs_if_square(kmat, lam_d));
+#pragma omp task depend(out : lam_m_c)
+      std::tie(lam_m_c, lam_m_csing) = uncompress_basis(r, dlr2d_rfidx, vals2coefs_if_square(kmat, lam_m));
+    }
 
-  } else {
-    auto chi_s_c_compressed = vals2coefs_if_square(kmat, chi_s);
-    auto chi_d_c_compressed = vals2coefs_if_square(kmat, chi_d);
-    auto chi_m_c_compressed = vals2coefs_if_square(kmat, chi_m);
-    auto lam_s_c_compressed = vals2coefs_if_square(kmat, lam_s);
-    auto lam_d_c_compressed = vals2coefs_if_square(kmat, lam_d);
-    auto lam_m_c_compressed = vals2coefs_if_square(kmat, lam_m);
-
-    std::tie(chi_s_c, chi_s_csing) = uncompress_basis(r, dlr2d_rfidx, chi_s_c_compressed);
-    std::tie(chi_d_c, chi_d_csing) = uncompress_basis(r, dlr2d_rfidx, chi_d_c_compressed);
-    std::tie(chi_m_c, chi_m_csing) = uncompress_basis(r, dlr2d_rfidx, chi_m_c_compressed);
-    std::tie(lam_s_c, lam_s_csing) = uncompress_basis(r, dlr2d_rfidx, lam_s_c_compressed);
-    std::tie(lam_d_c, lam_d_csing) = uncompress_basis(r, dlr2d_rfidx, lam_d_c_compressed);
-    std::tie(lam_m_c, lam_m_csing) = uncompress_basis(r, dlr2d_rfidx, lam_m_c_compressed);
+    // Error measurement on test grid
+#pragma omp task depend(in : chi_s_c)
+    std::tie(chi_s_l2, chi_s_linf, chi_s_l2err, chi_s_linferr) = measure_error_if(beta, niomtst, eval(chi_s_c, chi_s_csing, 1), tru(chi_s_fun_batch));
+#pragma omp task depend(in : chi_d_c)
+    std::tie(chi_d_l2, chi_d_linf, chi_d_l2err, chi_d_linferr) = measure_error_if(beta, niomtst, eval(chi_d_c, chi_d_csing, 2), tru(chi_d_fun_batch));
+#pragma omp task depend(in : chi_m_c)
+    std::tie(chi_m_l2, chi_m_linf, chi_m_l2err, chi_m_linferr) = measure_error_if(beta, niomtst, eval(chi_m_c, chi_m_csing, 2), tru(chi_m_fun_batch));
+#pragma omp task depend(in : lam_s_c)
+    std::tie(lam_s_l2, lam_s_linf, lam_s_l2err, lam_s_linferr) = measure_error_if(beta, niomtst, eval(lam_s_c, lam_s_csing, 1), tru(lam_s_fun_batch));
+#pragma omp task depend(in : lam_d_c)
+    std::tie(lam_d_l2, lam_d_linf, lam_d_l2err, lam_d_linferr) = measure_error_if(beta, niomtst, eval(lam_d_c, lam_d_csing, 2), tru(lam_d_fun_batch));
+#pragma omp task depend(in : lam_m_c)
+    std::tie(lam_m_l2, lam_m_linf, lam_m_l2err, lam_m_linferr) = measure_error_if(beta, niomtst, eval(lam_m_c, lam_m_csing, 2), tru(lam_m_fun_batch));
+
+    // Polarization from DLR expansions
+#pragma omp task depend(in : lam_s_c)
+    {
+      pol_s = polarization(beta, lambda, eps, itops, ifops_fer, ifops_bos, gc, gc, lam_s_c, lam_s_csing);
+      pol_s *= -1.0 / 2;
+      pol_s_c = nda::array<dcomplex, 1>(ifops_bos.vals2coefs(beta, pol_s));
+    }
+#pragma omp task depend(in : lam_d_c)
+    {
+      pol_d   = polarization(beta, lambda, eps, itops, ifops_fer, ifops_bos, grc, gc, lam_d_c, lam_d_csing);
+      pol_d_c = nda::array<dcomplex, 1>(ifops_bos.vals2coefs(beta, pol_d));
+    }
+#pragma omp task depend(in : lam_m_c)
+    {
+      pol_m   = polarization(beta, lambda, eps, itops, ifops_fer, ifops_bos, grc, gc, lam_m_c, lam_m_csing);
+      pol_m_c = nda::array<dcomplex, 1>(ifops_bos.vals2coefs(beta, pol_m));
+    }
   }
   auto end = std::chrono::high_resolution_clock::now();
   fmt::print("Time: {}\n", std::chrono::duration<double>(end - start).count());
 
-  // Test DLR expansion of vertex function
-  fmt::print("Testing DLR expansion of vertex function...\n");
-
-  // Evaluate expansion on test grid and measure error
-  auto chi_s_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto chi_d_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto chi_m_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto chi_s_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto chi_d_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto chi_m_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_s_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_d_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_m_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_s_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_d_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_m_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  int midx = 0, nidx = 0;
-  start = std::chrono::high_resolution_clock::now();
-  for (int m = -niomtst / 2; m < niomtst / 2; ++m) {
-    for (int n = -niomtst / 2; n < niomtst / 2; ++n) {
-      nu1  = ((2 * m + 1) * pi * 1i) / beta;
-      nu2  = ((2 * n + 1) * pi * 1i) / beta;
-      midx = niomtst / 2 + m;
-      nidx = niomtst / 2 + n;
-
-      // Evaluate true functions
-      chi_s_tru(midx, nidx) = chi_s_fun(u, beta, nu1, nu2);
-      chi_d_tru(midx, nidx) = chi_d_fun(u, beta, nu1, nu2);
-      chi_m_tru(midx, nidx) = chi_m_fun(u, beta, nu1, nu2);
-      lam_s_tru(midx, nidx) = lam_s_fun(u, beta, nu1, nu2);
-      lam_d_tru(midx, nidx) = lam_d_fun(u, beta, nu1, nu2);
-      lam_m_tru(midx, nidx) = lam_m_fun(u, beta, nu1, nu2);
-
-      // Evaluate DLR expansions
-      chi_s_tst(midx, nidx) = coefs2eval_if(beta, dlr_rf, chi_s_c, chi_s_csing, m, n, 1);
-      chi_d_tst(midx, nidx) = coefs2eval_if(beta, dlr_rf, chi_d_c, chi_d_csing, m, n, 2);
-      chi_m_tst(midx, nidx) = coefs2eval_if(beta, dlr_rf, chi_m_c, chi_m_csing, m, n, 2);
-      lam_s_tst(midx, nidx) = coefs2eval_if(beta, dlr_rf, lam_s_c, lam_s_csing, m, n, 1);
-      lam_d_tst(midx, nidx) = coefs2eval_if(beta, dlr_rf, lam_d_c, lam_d_csing, m, n, 2);
-      lam_m_tst(midx, nidx) = coefs2eval_if(beta, dlr_rf, lam_m_c, lam_m_csing, m, n, 2);
-    }
-  }
-  end = std::chrono::high_resolution_clock::now();
-  fmt::print("Time: {}\n\n", std::chrono::duration<double>(end - start).count());
-
-  double chi_s_l2 = sqrt(sum(pow(abs(chi_s_tru), 2))) / beta / beta;
-  double chi_d_l2 = sqrt(sum(pow(abs(chi_d_tru), 2))) / beta / beta;
-  double chi_m_l2 = sqrt(sum(pow(abs(chi_m_tru), 2))) / beta / beta;
-  double lam_s_l2 = sqrt(sum(pow(abs(lam_s_tru), 2))) / beta / beta;
-  double lam_d_l2 = sqrt(sum(pow(abs(lam_d_tru), 2))) / beta / beta;
-  double lam_m_l2 = sqrt(sum(pow(abs(lam_m_tru), 2))) / beta / beta;
-
-  double chi_s_linf = max_element(abs(chi_s_tru));
-  double chi_d_linf = max_element(abs(chi_d_tru));
-  double chi_m_linf = max_element(abs(chi_m_tru));
-  double lam_s_linf = max_element(abs(lam_s_tru));
-  double lam_d_linf = max_element(abs(lam_d_tru));
-  double lam_m_linf = max_element(abs(lam_m_tru));
-
-  double chi_s_l2err = sqrt(sum(pow(abs(chi_s_tru - chi_s_tst), 2))) / beta / beta;
-  double chi_d_l2err = sqrt(sum(pow(abs(chi_d_tru - chi_d_tst), 2))) / beta / beta;
-  double chi_m_l2err = sqrt(sum(pow(abs(chi_m_tru - chi_m_tst), 2))) / beta / beta;
-  double lam_s_l2err = sqrt(sum(pow(abs(lam_s_tru - lam_s_tst), 2))) / beta / beta;
-  double lam_d_l2err = sqrt(sum(pow(abs(lam_d_tru - lam_d_tst), 2))) / beta / beta;
-  double lam_m_l2err = sqrt(sum(pow(abs(lam_m_tru - lam_m_tst), 2))) / beta / beta;
-
-  double chi_s_linferr = max_element(abs(chi_s_tru - chi_s_tst));
-  double chi_d_linferr = max_element(abs(chi_d_tru - chi_d_tst));
-  double chi_m_linferr = max_element(abs(chi_m_tru - chi_m_tst));
-  double lam_s_linferr = max_element(abs(lam_s_tru - lam_s_tst));
-  double lam_d_linferr = max_element(abs(lam_d_tru - lam_d_tst));
-  double lam_m_linferr = max_element(abs(lam_m_tru - lam_m_tst));
-
+  // Errors of DLR expansions of correlation and vertex functions
   fmt::print("--- chi_S results ---\n");
   fmt::print("L2 norm:    {}\n", chi_s_l2);
   fmt::print("Linf norm:  {}\n", chi_s_linf);
@@ -263,31 +243,6 @@ nda::vector<double> hubatom_allfuncs(double beta, double u, double lambda, doubl
   fmt::print("L2 error:   {}\n", lam_m_l2err);
   fmt::print("Linf error: {}\n\n", lam_m_linferr);
 
-  // Compute polarization from DLR expansions
-  auto itops = imtime_ops(lambda, dlr_rf);
-
-  // auto pol_s =
-  //     polarization_res(beta, ifops_fer, ifops_bos, gc, gc, lam_s_c,
-  //     lam_s_csing);
-  // pol_s += polarization_const(beta, itops, ifops_bos, gc, gc);
-  auto pol_s = polarization(beta, lambda, eps, itops, ifops_fer, ifops_bos, gc, gc, lam_s_c, lam_s_csing);
-  pol_s *= -1.0 / 2;
-
-  // auto pol_d =
-  //     polarization_res(beta, ifops_fer, ifops_bos, grc, gc, lam_d_c,
-  //     lam_d_csing);
-  // pol_d += polarization_const(beta, itops, ifops_bos, grc, gc);
-  auto pol_d = polarization(beta, lambda, eps, itops, ifops_fer, ifops_bos, grc, gc, lam_d_c, lam_d_csing);
-
-  // auto pol_m =
-  //     polarization_res(beta, ifops_fer, ifops_bos, grc, gc, lam_m_c,
-  //     lam_m_csing);
-  // pol_m += polarization_const(beta, itops, ifops_bos, grc, gc);
-  auto pol_m = polarization(beta, lambda, eps, itops, ifops_fer, ifops_bos, grc, gc, lam_m_c, lam_m_csing);
-
-  auto pol_s_c = ifops_bos.vals2coefs(beta, pol_s); // DLR expansion
-  auto pol_d_c = ifops_bos.vals2coefs(beta, pol_d);
-  auto pol_m_c = ifops_bos.vals2coefs(beta, pol_m);
 
   // Compute true polarization
   std::complex<double> pol0_s_tru = beta * -k_it(0.0, -u / 2, beta) / (2 * beta * u * -k_it(0.0, -u / 2, beta) - 4);
@@ -454,7 +409,7 @@ nda::vector<double> hubatom_allfuncs_3term(double beta, double u, double lambda,
   auto dlr_if_bos = ifops_bos.get_ifnodes();
 
   // Evaluate Green's function on 1D DLR grid and obtain its DLR coefficients
-  std::complex<double> nu1 = 0, nu2 = 0;
+  std::complex<double> nu1 = 0;
   auto g  = nda::vector<dcomplex>(r);
   auto gr = nda::vector<dcomplex>(r); // G reversed: G(-i nu_n)
   for (int k = 0; k < r; ++k) {
@@ -467,26 +422,12 @@ nda::vector<double> hubatom_allfuncs_3term(double beta, double u, double lambda,
 
   // Evaluate correlation and vertex functions on 2D DLR grid and obtain DLR
   // coefficients
-  auto chi_s = nda::vector<dcomplex>(niom);
-  auto chi_d = nda::vector<dcomplex>(niom);
-  auto chi_m = nda::vector<dcomplex>(niom);
-  auto lam_s = nda::vector<dcomplex>(niom);
-  auto lam_d = nda::vector<dcomplex>(niom);
-  auto lam_m = nda::vector<dcomplex>(niom);
-  for (int k = 0; k < niom; ++k) {
-    nu1      = (2 * dlr2d_if(k, 0) + 1) * pi * 1i / beta;
-    nu2      = (2 * dlr2d_if(k, 1) + 1) * pi * 1i / beta;
-    chi_s(k) = chi_s_fun(u, beta, nu1, nu2);
-    lam_s(k) = lam_s_fun(u, beta, nu1, nu2);
-  }
-  for (int k = 0; k < niom; ++k) {
-    nu1      = (2 * dlr2d_if_ph(k, 0) + 1) * pi * 1i / beta;
-    nu2      = (2 * dlr2d_if_ph(k, 1) + 1) * pi * 1i / beta;
-    chi_d(k) = chi_d_fun(u, beta, nu1, nu2);
-    chi_m(k) = chi_m_fun(u, beta, nu1, nu2);
-    lam_d(k) = lam_d_fun(u, beta, nu1, nu2);
-    lam_m(k) = lam_m_fun(u, beta, nu1, nu2);
-  }
+  auto chi_s = chi_s_fun_batch(u, beta, dlr2d_if);
+  auto chi_d = chi_d_fun_batch(u, beta, dlr2d_if_ph);
+  auto chi_m = chi_m_fun_batch(u, beta, dlr2d_if_ph);
+  auto lam_s = lam_s_fun_batch(u, beta, dlr2d_if);
+  auto lam_d = lam_d_fun_batch(u, beta, dlr2d_if_ph);
+  auto lam_m = lam_m_fun_batch(u, beta, dlr2d_if_ph);
 
   fmt::print("Obtaining DLR coefficients of chi, lambda...\n");
   auto chi_s_c     = nda::array<dcomplex, 3>();
@@ -531,76 +472,28 @@ nda::vector<double> hubatom_allfuncs_3term(double beta, double u, double lambda,
   // Test DLR expansion of vertex function
   fmt::print("Testing DLR expansion of vertex function...\n");
 
-  // Evaluate expansion on test grid and measure error
-  auto chi_s_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto chi_d_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto chi_m_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto chi_s_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto chi_d_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto chi_m_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_s_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_d_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_m_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_s_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_d_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_m_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  int midx = 0, nidx = 0;
+  // Evaluate expansions and true functions on test grid tile by tile, and
+  // measure errors
+  auto eval = [&](auto const &c, auto const &csing, int channel) {
+    return [&, channel](nda::array_const_view<int, 2> idx) {
+      auto vals = nda::vector<dcomplex>(idx.shape(0));
+      for (int i = 0; i < idx.shape(0); ++i) { vals(i) = coefs2eval_if_3term(beta, dlr_rf, c, csing, idx(i, 0), idx(i, 1), channel); }
+      return vals;
+    };
+  };
+  auto tru = [&](auto f) {
+    return [&, f](nda::array_const_view<int, 2> idx) { return f(u, beta, idx); };
+  };
   start = std::chrono::high_resolution_clock::now();
-  for (int m = -niomtst / 2; m < niomtst / 2; ++m) {
-    for (int n = -niomtst / 2; n < niomtst / 2; ++n) {
-      nu1  = ((2 * m + 1) * pi * 1i) / beta;
-      nu2  = ((2 * n + 1) * pi * 1i) / beta;
-      midx = niomtst / 2 + m;
-      nidx = niomtst / 2 + n;
-
-      // Evaluate true functions
-      chi_s_tru(midx, nidx) = chi_s_fun(u, beta, nu1, nu2);
-      chi_d_tru(midx, nidx) = chi_d_fun(u, beta, nu1, nu2);
-      chi_m_tru(midx, nidx) = chi_m_fun(u, beta, nu1, nu2);
-      lam_s_tru(midx, nidx) = lam_s_fun(u, beta, nu1, nu2);
-      lam_d_tru(midx, nidx) = lam_d_fun(u, beta, nu1, nu2);
-      lam_m_tru(midx, nidx) = lam_m_fun(u, beta, nu1, nu2);
-
-      // Evaluate DLR expansions
-      chi_s_tst(midx, nidx) = coefs2eval_if_3term(beta, dlr_rf, chi_s_c, chi_s_csing, m, n, 1);
-      chi_d_tst(midx, nidx) = coefs2eval_if_3term(beta, dlr_rf, chi_d_c, chi_d_csing, m, n, 2);
-      chi_m_tst(midx, nidx) = coefs2eval_if_3term(beta, dlr_rf, chi_m_c, chi_m_csing, m, n, 2);
-      lam_s_tst(midx, nidx) = coefs2eval_if_3term(beta, dlr_rf, lam_s_c, lam_s_csing, m, n, 1);
-      lam_d_tst(midx, nidx) = coefs2eval_if_3term(beta, dlr_rf, lam_d_c, lam_d_csing, m, n, 2);
-      lam_m_tst(midx, nidx) = coefs2eval_if_3term(beta, dlr_rf, lam_m_c, lam_m_csing, m, n, 2);
-    }
-  }
+  auto [chi_s_l2, chi_s_linf, chi_s_l2err, chi_s_linferr] = measure_error_if(beta, niomtst, eval(chi_s_c, chi_s_csing, 1), tru(chi_s_fun_batch));
+  auto [chi_d_l2, chi_d_linf, chi_d_l2err, chi_d_linferr] = measure_error_if(beta, niomtst, eval(chi_d_c, chi_d_csing, 2), tru(chi_d_fun_batch));
+  auto [chi_m_l2, chi_m_linf, chi_m_l2err, chi_m_linferr] = measure_error_if(beta, niomtst, eval(chi_m_c, chi_m_csing, 2), tru(chi_m_fun_batch));
+  auto [lam_s_l2, lam_s_linf, lam_s_l2err, lam_s_linferr] = measure_error_if(beta, niomtst, eval(lam_s_c, lam_s_csing, 1), tru(lam_s_fun_batch));
+  auto [lam_d_l2, lam_d_linf, lam_d_l2err, lam_d_linferr] = measure_error_if(beta, niomtst, eval(lam_d_c, lam_d_csing, 2), tru(lam_d_fun_batch));
+  auto [lam_m_l2, lam_m_linf, lam_m_l2err, lam_m_linferr] = measure_error_if(beta, niomtst, eval(lam_m_c, lam_m_csing, 2), tru(lam_m_fun_batch));
   end = std::chrono::high_resolution_clock::now();
   fmt::print("Time: {}\n\n", std::chrono::duration<double>(end - start).count());
 
-  double chi_s_l2 = sqrt(sum(pow(abs(chi_s_tru), 2))) / beta / beta;
-  double chi_d_l2 = sqrt(sum(pow(abs(chi_d_tru), 2))) / beta / beta;
-  double chi_m_l2 = sqrt(sum(pow(abs(chi_m_tru), 2))) / beta / beta;
-  double lam_s_l2 = sqrt(sum(pow(abs(lam_s_tru), 2))) / beta / beta;
-  double lam_d_l2 = sqrt(sum(pow(abs(lam_d_tru), 2))) / beta / beta;
-  double lam_m_l2 = sqrt(sum(pow(abs(lam_m_tru), 2))) / beta / beta;
-
-  double chi_s_linf = max_element(abs(chi_s_tru));
-  double chi_d_linf = max_element(abs(chi_d_tru));
-  double chi_m_linf = max_element(abs(chi_m_tru));
-  double lam_s_linf = max_element(abs(lam_s_tru));
-  double lam_d_linf = max_element(abs(lam_d_tru));
-  double lam_m_linf = max_element(abs(lam_m_tru));
-
-  double chi_s_l2err = sqrt(sum(pow(abs(chi_s_tru - chi_s_tst), 2))) / beta / beta;
-  double chi_d_l2err = sqrt(sum(pow(abs(chi_d_tru - chi_d_tst), 2))) / beta / beta;
-  double chi_m_l2err = sqrt(sum(pow(abs(chi_m_tru - chi_m_tst), 2))) / beta / beta;
-  double lam_s_l2err = sqrt(sum(pow(abs(lam_s_tru - lam_s_tst), 2))) / beta / beta;
-  double lam_d_l2err = sqrt(sum(pow(abs(lam_d_tru - lam_d_tst), 2))) / beta / beta;
-  double lam_m_l2err = sqrt(sum(pow(abs(lam_m_tru - lam_m_tst), 2))) / beta / beta;
-
-  double chi_s_linferr = max_element(abs(chi_s_tru - chi_s_tst));
-  double chi_d_linferr = max_element(abs(chi_d_tru - chi_d_tst));
-  double chi_m_linferr = max_element(abs(chi_m_tru - chi_m_tst));
-  double lam_s_linferr = max_element(abs(lam_s_tru - lam_s_tst));
-  double lam_d_linferr = max_element(abs(lam_d_tru - lam_d_tst));
-  double lam_m_linferr = max_element(abs(lam_m_tru - lam_m_tst));
-
   fmt::print("--- chi_S results ---\n");
   fmt::print("L2 norm:    {}\n", chi_s_l2);
   fmt::print("Linf norm:  {}\n", chi_s_linf);
@@ -860,3 +753,112 @@ std::complex<double> lam_d_fun(double u, double beta, std::complex<double> nu1,
 std::complex<double> lam_m_fun(double u, double beta, std::complex<double> nu1, std::complex<double> nu2) {
   return lam_ph_fun(u, beta, nu1, nu2, -1);
 }
+
+// Batched versions, in real arithmetic: with nu = i*x, x = (2n+1)*pi/beta, the
+// Green's function is g = -i*a with a = 4x/(4x^2+u^2), and the regular and
+// singular parts of chi/Pi are real
+
+nda::vector<dcomplex> g_fun_batch(double u, double beta, nda::vector_const_view<int> idx) {
+  int n     = idx.size();
+  auto vals = nda::vector<dcomplex>(n);
+  for (int i = 0; i < n; ++i) {
+    double x = (2 * idx(i) + 1) * pi / beta;
+    vals(i)  = dcomplex(0, -4 * x / (4 * x * x + u * u));
+  }
+  return vals;
+}
+
+nda::vector<dcomplex> chi_s_fun_batch(double u, double beta, nda::array_const_view<int, 2> idx) {
+  int n      = idx.shape(0);
+  double usq = u * u;
+  double sng = beta * u * -k_it(0.0, -u / 2, beta);
+  auto vals  = nda::vector<dcomplex>(n);
+
+  for (int i = 0; i < n; ++i) {
+    int m1 = idx(i, 0), m2 = idx(i, 1);
+    double x1 = (2 * m1 + 1) * pi / beta, x2 = (2 * m2 + 1) * pi / beta;
+    double a1 = 4 * x1 / (4 * x1 * x1 + usq), a2 = 4 * x2 / (4 * x2 * x2 + usq);
+
+    double val = 2 + usq / (2 * x1 * x2);
+    if (m1 + m2 + 1 == 0) { val -= sng * (1 + usq / (4 * x1 * x1)); }
+    vals(i) = -a1 * a2 * val;
+  }
+
+  return vals;
+}
+
+nda::vector<dcomplex> chi_ph_fun_batch(double u, double beta, nda::array_const_view<int, 2> idx, int channel) {
+  int n      = idx.shape(0);
+  double uu  = channel * u;
+  double usq = u * u;
+  double sng = beta * uu * -k_it(0.0, -uu / 2, beta);
+  auto vals  = nda::vector<dcomplex>(n);
+
+  for (int i = 0; i < n; ++i) {
+    int m1 = idx(i, 0), m2 = idx(i, 1);
+    double x1 = (2 * m1 + 1) * pi / beta, x2 = (2 * m2 + 1) * pi / beta;
+    double a1 = 4 * x1 / (4 * x1 * x1 + usq), a2 = 4 * x2 / (4 * x2 * x2 + usq);
+
+    double val = 2 - usq / (2 * x1 * x2);
+    if (m1 == m2) { val -= sng * (1 + usq / (4 * x1 * x1)); }
+    double im = (channel == 1 && m1 == m2) ? -beta * a2 : 0.0;
+    vals(i)   = dcomplex(a1 * a2 * val / 2, im);
+  }
+
+  return vals;
+}
+
+nda::vector<dcomplex> chi_d_fun_batch(double u, double beta, nda::array_const_view<int, 2> idx) { return chi_ph_fun_batch(u, beta, idx, 1); }
+
+nda::vector<dcomplex> chi_m_fun_batch(double u, double beta, nda::array_const_view<int, 2> idx) { return chi_ph_fun_batch(u, beta, idx, -1); }
+
+nda::vector<dcomplex> lam_s_fun_batch(double u, double beta, nda::array_const_view<int, 2> idx) {
+  int n      = idx.shape(0);
+  double usq = u * u;
+  double sng = beta * u * -k_it(0.0, -u / 2, beta);
+  auto vals  = nda::vector<dcomplex>(n);
+
+  for (int i = 0; i < n; ++i) {
+    int m1 = idx(i, 0), m2 = idx(i, 1);
+    double x1 = (2 * m1 + 1) * pi / beta, x2 = (2 * m2 + 1) * pi / beta;
+
+    double val = 2 + usq / (2 * x1 * x2);
+    if (m1 + m2 + 1 == 0) {
+      val -= sng * (1 - usq / (4 * x1 * x2));
+      val /= 2 - sng;
+    } else {
+      val /= 2;
+    }
+    vals(i) = val - 1;
+  }
+
+  return vals;
+}
+
+nda::vector<dcomplex> lam_ph_fun_batch(double u, double beta, nda::array_const_view<int, 2> idx, int channel) {
+  int n      = idx.shape(0);
+  double uu  = channel * u;
+  double usq = u * u;
+  double sng = beta * uu * -k_it(0.0, -uu / 2, beta);
+  auto vals  = nda::vector<dcomplex>(n);
+
+  for (int i = 0; i < n; ++i) {
+    int m1 = idx(i, 0), m2 = idx(i, 1);
+    double x1 = (2 * m1 + 1) * pi / beta, x2 = (2 * m2 + 1) * pi / beta;
+
+    double val = 2 - usq / (2 * x1 * x2);
+    if (m1 == m2) {
+      val -= sng * (1 + usq / (4 * x1 * x2));
+      val /= 2 - sng;
+    } else {
+      val /= 2;
+    }
+    vals(i) = val - 1;
+  }
+
+  return vals;
+}
+
+nda::vector<dcomplex> lam_d_fun_batch(double u, double beta, nda::array_const_view<int, 2> idx) { return lam_ph_fun_batch(u, beta, idx, 1); }
+
+nda::vector<dcomplex> lam_m_fun_batch(double u, double beta, nda::array_const_view<int, 2> idx) { return lam_ph_fun_batch(u, beta, idx, -1); }
@@ -14,7 +14,9 @@ using namespace dlr2d;
  * This function expands the Green's function, three-point correlators, and
  * vertex functions in all channels for the Hubbard atom in the DLR. It then
  * computes the polarization function in all channels. It measures the error of
- * all of these representations.
+ * all of these representations. The fits, error measurements and
+ * polarizations of the different channels are run concurrently as OpenMP
+ * tasks.
  *
  * \param[in] beta          Inverse temperature
  * \param[in] u             Hubbard interaction
@@ -119,4 +121,23 @@ std::complex<double> lam_d_fun(double u, double beta, std::complex<double> nu1,
  */
 std::complex<double> lam_m_fun(double u, double beta, std::complex<double> nu1, std::complex<double> nu2);
 
+/*!
+ * \brief Batched versions of the analytical solutions
+ *
+ * These take Matsubara frequency indices (fermionic index pairs for the
+ * correlators and vertex functions) rather than frequencies, evaluate in real
+ * arithmetic, and identify the singular frequencies by integer comparison.
+ * @{
+ */
+nda::vector<dcomplex> g_fun_batch(double u, double beta, nda::vector_const_view<int> idx);
+nda::vector<dcomplex> chi_s_fun_batch(double u, double beta, nda::array_const_view<int, 2> idx);
+nda::vector<dcomplex> chi_ph_fun_batch(double u, double beta, nda::array_const_view<int, 2> idx, int channel);
+nda::vector<dcomplex> chi_d_fun_batch(double u, double beta, nda::array_const_view<int, 2> idx);
+nda::vector<dcomplex> chi_m_fun_batch(double u, double beta, nda::array_const_view<int, 2> idx);
+nda::vector<dcomplex> lam_s_fun_batch(double u, double beta, nda::array_const_view<int, 2> idx);
+nda::vector<dcomplex> lam_ph_fun_batch(double u, double beta, nda::array_const_view<int, 2> idx, int channel);
+nda::vector<dcomplex> lam_d_fun_batch(double u, double beta, nda::array_const_view<int, 2> idx);
+nda::vector<dcomplex> lam_m_fun_batch(double u, double beta, nda::array_const_view<int, 2> idx);
+/** @} */
+
 /** @} */ // end of HubSolns group
@@ -1,4 +1,5 @@
 #include "hubatom.hpp"
+#include "../../src/parameters.hpp"
 #include <fstream>
 
 int main() {
@@ -12,6 +13,7 @@ int main() {
   bool reduced       = true;  // Full or reduced fine grid
   bool compressbasis = false;
   int niom_dense     = 100; // # imag freq sample pts for fine grid (must be even)
+  bool autolambda    = false; // Choose lambda from spectral bound rather than lambda = beta
 
   auto filename = "hubatom_eps12_tst1024_3term_2lambda";
 
@@ -20,8 +22,9 @@ int main() {
   auto results = nda::array<double, 2>(nresult, nexp);
   double beta = 0, lambda = 0;
   for (int i = 0; i < nexp; ++i) {
+    // Poles of Hubbard atom functions lie in [-u, u]
     beta   = pow(2.0, i);
-    lambda = beta;
+    lambda = autolambda ? choose_lambda(beta, u) : beta;
     if (threeterm) {
       results(nda::range::all, i) = hubatom_allfuncs_3term(beta, u, lambda, eps, niomtst, nbos_tst);
     } else {
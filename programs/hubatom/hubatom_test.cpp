@@ -1,4 +1,5 @@
 #include "hubatom.hpp"
+#include "../../src/cf2if_operator.hpp"
 
 #include <fmt/format.h>
 #include <gtest/gtest.h>
@@ -178,3 +179,249 @@ TEST(hubatom, main) {
 
   EXPECT_LT(pol_s_l2err, 10 * eps);
 }
+
+/*!
+ * \brief Test compressed 2D DLR expansion of density correlation function and
+ * singlet vertex function for Hubbard atom
+ *
+ * \note The 2D DLR grids are built in memory using \ref build_dlr2d_ifrf, so
+ * this test does not depend on precomputed grid data.
+ */
+TEST(hubatom, compressed) {
+  double beta   = 16;    // Inverse temperature
+  double u      = 1.0;   // Interaction
+  double lambda = 16;    // DLR cutoff
+  double eps    = 1e-10; // DLR tolerance
+  int niomtst   = 128;   // # imag freq test points (must be even)
+
+  // Get DLR frequencies and compressed 2D DLR grids
+  auto dlr_rf                  = build_dlr_rf(lambda, eps);
+  int r                        = dlr_rf.size(); // # DLR basis functions
+  auto [dlr2d_rfidx, dlr2d_if] = build_dlr2d_ifrf(lambda, eps);
+  int niom                     = dlr2d_if.shape(0);
+
+  EXPECT_EQ(dlr2d_rfidx.shape(0), niom);
+
+  // Get DLR nodes for particle-hole channel
+  auto dlr2d_if_ph  = nda::array<int, 2>(dlr2d_if.shape());
+  dlr2d_if_ph(_, 0) = -dlr2d_if(_, 0) - 1;
+  dlr2d_if_ph(_, 1) = dlr2d_if(_, 1);
+
+  auto kmat = build_cf2if_square(beta, dlr_rf, dlr2d_rfidx, dlr2d_if);
+
+  // Evaluate density correlation function and singlet vertex function on 2D DLR
+  // grid and obtain DLR coefficients
+  std::complex<double> nu1 = 0, nu2 = 0;
+  auto chi_d = nda::vector<dcomplex>(niom);
+  auto lam_s = nda::vector<dcomplex>(niom);
+  for (int k = 0; k < niom; ++k) {
+    // Particle-hole channel
+    nu1      = (2 * dlr2d_if_ph(k, 0) + 1) * pi * 1i / beta;
+    nu2      = (2 * dlr2d_if_ph(k, 1) + 1) * pi * 1i / beta;
+    chi_d(k) = chi_d_fun(u, beta, nu1, nu2);
+
+    // Particle-particle channel
+    nu1      = (2 * dlr2d_if(k, 0) + 1) * pi * 1i / beta;
+    nu2      = (2 * dlr2d_if(k, 1) + 1) * pi * 1i / beta;
+    lam_s(k) = lam_s_fun(u, beta, nu1, nu2);
+  }
+
+  auto [chi_d_c, chi_d_csing] = uncompress_basis(r, dlr2d_rfidx, vals2coefs_if_square(kmat, chi_d));
+  auto [lam_s_c, lam_s_csing] = uncompress_basis(r, dlr2d_rfidx, vals2coefs_if_square(kmat, lam_s));
+
+  // Evaluate expansion on test grid and measure error
+  double chi_d_errsq = 0, lam_s_errsq = 0;
+  for (int m = -niomtst / 2; m < niomtst / 2; ++m) {
+    for (int n = -niomtst / 2; n < niomtst / 2; ++n) {
+      nu1 = ((2 * m + 1) * pi * 1i) / beta;
+      nu2 = ((2 * n + 1) * pi * 1i) / beta;
+
+      chi_d_errsq += pow(abs(chi_d_fun(u, beta, nu1, nu2) - coefs2eval_if(beta, dlr_rf, chi_d_c, chi_d_csing, m, n, 2)), 2);
+      lam_s_errsq += pow(abs(lam_s_fun(u, beta, nu1, nu2) - coefs2eval_if(beta, dlr_rf, lam_s_c, lam_s_csing, m, n, 1)), 2);
+    }
+  }
+
+  double chi_d_l2err = sqrt(chi_d_errsq) / beta / beta;
+  double lam_s_l2err = sqrt(lam_s_errsq) / beta / beta;
+
+  fmt::print("Compressed basis chi_D L2 error:    {}\n", chi_d_l2err);
+  fmt::print("Compressed basis lambda_S L2 error: {}\n\n", lam_s_l2err);
+
+  EXPECT_LT(chi_d_l2err, 100 * eps);
+  EXPECT_LT(lam_s_l2err, 100 * eps);
+}
+
+/*!
+ * \brief Test a posteriori error estimate of 2D DLR expansion of singlet
+ * vertex function for Hubbard atom against error on dense test grid, for a
+ * resolved and an under-resolved (DLR cutoff too small) expansion
+ */
+TEST(hubatom, estimate_error) {
+  double beta = 16;    // Inverse temperature
+  double u    = 1.0;   // Interaction
+  double eps  = 1e-10; // DLR tolerance
+  int nval    = 64;    // # validation nodes
+  int niomtst = 128;   // # imag freq test points (must be even)
+  double fac  = 100;   // Allowed ratio of error estimate and true error
+
+  // Validation error estimate, coefficient tail ratio, and error on dense
+  // test grid, for given DLR cutoff
+  auto errors = [&](double lambda) {
+    auto dlr_rf                   = build_dlr_rf(lambda, eps);
+    int r                         = dlr_rf.size(); // # DLR basis functions
+    auto [dlr2d_if, dlr2d_if_val] = build_dlr2d_if_val(lambda, eps, nval);
+    int niom                      = dlr2d_if.shape(0);
+
+    // Fit singlet vertex function on 2D DLR grid
+    std::complex<double> nu1 = 0, nu2 = 0;
+    auto lam_s = nda::vector<dcomplex>(niom);
+    for (int k = 0; k < niom; ++k) {
+      nu1      = (2 * dlr2d_if(k, 0) + 1) * pi * 1i / beta;
+      nu2      = (2 * dlr2d_if(k, 1) + 1) * pi * 1i / beta;
+      lam_s(k) = lam_s_fun(u, beta, nu1, nu2);
+    }
+    auto [lam_s_c, lam_s_csing] = vals2coefs_if(build_cf2if(beta, dlr_rf, dlr2d_if), lam_s, r);
+
+    // Error estimate from validation nodes
+    auto lam_s_val = nda::vector<dcomplex>(dlr2d_if_val.shape(0));
+    for (int k = 0; k < dlr2d_if_val.shape(0); ++k) {
+      nu1          = (2 * dlr2d_if_val(k, 0) + 1) * pi * 1i / beta;
+      nu2          = (2 * dlr2d_if_val(k, 1) + 1) * pi * 1i / beta;
+      lam_s_val(k) = lam_s_fun(u, beta, nu1, nu2);
+    }
+    auto [errest, tail] = estimate_error_if(beta, dlr_rf, lam_s_c, lam_s_csing, dlr2d_if_val, lam_s_val, 1);
+
+    // Error on dense test grid
+    double linferr = 0;
+    for (int m = -niomtst / 2; m < niomtst / 2; ++m) {
+      for (int n = -niomtst / 2; n < niomtst / 2; ++n) {
+        nu1     = ((2 * m + 1) * pi * 1i) / beta;
+        nu2     = ((2 * n + 1) * pi * 1i) / beta;
+        linferr = std::max(linferr, abs(lam_s_fun(u, beta, nu1, nu2) - coefs2eval_if(beta, dlr_rf, lam_s_c, lam_s_csing, m, n, 1)));
+      }
+    }
+
+    fmt::print("DLR cutoff:                {}\n", lambda);
+    fmt::print("Validation error estimate: {}\n", errest);
+    fmt::print("Coefficient tail ratio:    {}\n", tail);
+    fmt::print("Dense grid Linf error:     {}\n\n", linferr);
+
+    return std::make_tuple(errest, linferr);
+  };
+
+  // Resolved expansion: estimate and true error are both below tolerance, and
+  // agree within a factor
+  auto [errest, linferr] = errors(16);
+  EXPECT_LT(errest, 100 * eps);
+  EXPECT_LT(linferr, 100 * eps);
+  EXPECT_LT(errest, fac * linferr);
+  EXPECT_LT(linferr, fac * errest);
+
+  // Under-resolved expansion, with cutoff below beta times the energy scale
+  // of the Hubbard atom: estimate flags the error
+  auto [errest_c, linferr_c] = errors(2);
+  EXPECT_GT(linferr_c, 100 * eps);
+  EXPECT_GT(errest_c, 100 * eps);
+  EXPECT_LT(errest_c, fac * linferr_c);
+  EXPECT_LT(linferr_c, fac * errest_c);
+}
+
+/*!
+ * \brief Test iterative 2D DLR fit of singlet vertex function for Hubbard atom
+ * using matrix-free operator, with and without warm start
+ */
+TEST(hubatom, lsqr) {
+  double beta   = 8;     // Inverse temperature
+  double lambda = 8;     // DLR cutoff
+  double eps    = 1e-8;  // DLR tolerance
+  double tol    = 1e-12; // LSQR tolerance
+  int maxit     = 10000; // Maximum # LSQR iterations
+  int niomtst   = 64;    // # imag freq test points (must be even)
+
+  auto dlr_rf   = build_dlr_rf(lambda, eps);
+  auto dlr2d_if = build_dlr2d_if(lambda, eps);
+  int niom      = dlr2d_if.shape(0);
+  auto op       = cf2if_operator(beta, dlr_rf, dlr2d_if);
+
+  // Sample singlet vertex function for two nearby interactions
+  std::complex<double> nu1 = 0, nu2 = 0;
+  auto lam_s  = nda::vector<dcomplex>(niom);
+  auto lam_s2 = nda::vector<dcomplex>(niom);
+  for (int k = 0; k < niom; ++k) {
+    nu1       = (2 * dlr2d_if(k, 0) + 1) * pi * 1i / beta;
+    nu2       = (2 * dlr2d_if(k, 1) + 1) * pi * 1i / beta;
+    lam_s(k)  = lam_s_fun(1.0, beta, nu1, nu2);
+    lam_s2(k) = lam_s_fun(1.01, beta, nu1, nu2);
+  }
+
+  // Cold and warm started fits
+  auto [c, niter]   = lsqr_cf2if(op, lam_s, nda::vector<dcomplex>(), tol, maxit);
+  auto [c2, niter2] = lsqr_cf2if(op, lam_s2, c, tol, maxit);
+
+  fmt::print("LSQR iterations, cold start: {}\n", niter);
+  fmt::print("LSQR iterations, warm start: {}\n", niter2);
+
+  EXPECT_LT(niter, maxit);
+  EXPECT_LT(niter2, niter);
+
+  // Error on test grid
+  auto [lam_s_c, lam_s_csing] = vals2coefs_if_lsqr(op, lam_s, tol, maxit);
+  double l2err                = 0;
+  for (int m = -niomtst / 2; m < niomtst / 2; ++m) {
+    for (int n = -niomtst / 2; n < niomtst / 2; ++n) {
+      nu1 = ((2 * m + 1) * pi * 1i) / beta;
+      nu2 = ((2 * n + 1) * pi * 1i) / beta;
+      l2err += pow(abs(lam_s_fun(1.0, beta, nu1, nu2) - coefs2eval_if(beta, dlr_rf, lam_s_c, lam_s_csing, m, n, 1)), 2);
+    }
+  }
+  l2err = sqrt(l2err) / beta / beta;
+
+  fmt::print("LSQR fit L2 error: {}\n\n", l2err);
+
+  EXPECT_LT(l2err, 100 * eps);
+}
+
+/*!
+ * \brief Test batched analytical solutions for Hubbard atom against scalar
+ * versions, on a grid containing the singular frequency index pairs
+ */
+TEST(hubatom, batch) {
+  double beta = 16;  // Inverse temperature
+  double u    = 1.5; // Interaction
+  int nmax    = 8;   // Test grid is (-nmax,...,nmax-1)^2
+
+  int n    = 2 * nmax;
+  auto idx = nda::array<int, 2>(n * n, 2);
+  for (int m1 = 0; m1 < n; ++m1) {
+    for (int m2 = 0; m2 < n; ++m2) {
+      idx(m1 * n + m2, 0) = m1 - nmax;
+      idx(m1 * n + m2, 1) = m2 - nmax;
+    }
+  }
+
+  auto g     = g_fun_batch(u, beta, nda::vector<int>(idx(_, 0)));
+  auto chi_s = chi_s_fun_batch(u, beta, idx);
+  auto chi_d = chi_d_fun_batch(u, beta, idx);
+  auto chi_m = chi_m_fun_batch(u, beta, idx);
+  auto lam_s = lam_s_fun_batch(u, beta, idx);
+  auto lam_d = lam_d_fun_batch(u, beta, idx);
+  auto lam_m = lam_m_fun_batch(u, beta, idx);
+
+  std::complex<double> nu1 = 0, nu2 = 0;
+  double err               = 0;
+  for (int i = 0; i < n * n; ++i) {
+    nu1 = (2 * idx(i, 0) + 1) * pi * 1i / beta;
+    nu2 = (2 * idx(i, 1) + 1) * pi * 1i / beta;
+    err = std::max(err, abs(g(i) - g_fun(u, nu1)));
+    err = std::max(err, abs(chi_s(i) - chi_s_fun(u, beta, nu1, nu2)));
+    err = std::max(err, abs(chi_d(i) - chi_d_fun(u, beta, nu1, nu2)));
+    err = std::max(err, abs(chi_m(i) - chi_m_fun(u, beta, nu1, nu2)));
+    err = std::max(err, abs(lam_s(i) - lam_s_fun(u, beta, nu1, nu2)));
+    err = std::max(err, abs(lam_d(i) - lam_d_fun(u, beta, nu1, nu2)));
+    err = std::max(err, abs(lam_m(i) - lam_m_fun(u, beta, nu1, nu2)));
+  }
+
+  fmt::print("Max deviation of batched from scalar solutions: {}\n\n", err);
+
+  EXPECT_LT(err, 1e-12);
+}
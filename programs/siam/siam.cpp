@@ -2,9 +2,10 @@
 #include "../src/utils.hpp"
 
 #include <fmt/format.h>
+#include <stdexcept>
 
 nda::vector<double> siam_allfuncs(double beta, double u, double lambda, double eps, int niomtst, int nbos_tst, bool reduced, bool compressbasis,
-                                  int niom_dense) {
+                                  int niom_dense, bool multieps) {
 
   auto path     = "../../../dlr2d_if_data/";                                   // Path for DLR 2D grid data
   auto datafile = "../../../siam_data/SIAM_beta20_U5.0_ED_extracted_final.h5"; // Filename
@@ -17,7 +18,10 @@ nda::vector<double> siam_allfuncs(double beta, double u, double lambda, double e
 
   // Read 2D DLR grid indices from file
   std::string filename;
-  if (!reduced) {
+  if (multieps) {
+    if (!reduced || compressbasis) throw std::runtime_error("Multi-tolerance grids require reduced fine grid and overcomplete basis.");
+    filename = get_filename_multieps(lambda, eps);
+  } else if (!reduced) {
     filename = get_filename(lambda, eps, niom_dense);
   } else {
     filename = get_filename(lambda, eps, compressbasis);
@@ -125,7 +129,6 @@ nda::vector<double> siam_allfuncs(double beta, double u, double lambda, double e
     lam_m(k) = lam_m_data(chi_nmax + dlr2d_if_ph(k, 0), chi_nmax + dlr2d_if_ph(k, 1)) - 1;
   }
 
-  fmt::print("Obtaining DLR coefficients of chi, lambda...\n");
   auto chi_s_c     = nda::array<dcomplex, 3>();
   auto chi_d_c     = nda::array<dcomplex, 3>();
   auto chi_m_c     = nda::array<dcomplex, 3>();
@@ -139,45 +142,116 @@ nda::vector<double> siam_allfuncs(double beta, double u, double lambda, double e
   auto lam_d_csing = nda::array<dcomplex, 1>();
   auto lam_m_csing = nda::array<dcomplex, 1>();
 
+  // Evaluators of expansions and true functions on tiles of the test grid
+  auto eval = [&](auto const &c, auto const &csing, int channel) {
+    return [&, channel](nda::array_const_view<int, 2> idx) { return coefs2eval_if(beta, dlr_rf, c, csing, idx, channel); };
+  };
+  auto data = [&](auto const &f, double shift) {
+    return [&, shift](nda::array_const_view<int, 2> idx) {
+      auto vals = nda::vector<dcomplex>(idx.shape(0));
+      for (int i = 0; i < idx.shape(0); ++i) { vals(i) = f(chi_nmax + idx(i, 0), chi_nmax + idx(i, 1)) - shift; }
+      return vals;
+    };
+  };
+  auto itops = imtime_ops(lambda, dlr_rf);
+
+  // Fitting, error measurement and polarization as a graph of OpenMP tasks.
+  // Each channel's fit depends only on the system matrix, its error
+  // measurement and polarization depend only on its fit, and the singular
+  // coefficients are written together with the regular ones, so the
+  // dependences are tracked through the latter.
+  double chi_s_l2 = 0, chi_s_linf = 0, chi_s_l2err = 0, chi_s_linferr = 0;
+  double chi_d_l2 = 0, chi_d_linf = 0, chi_d_l2err = 0, chi_d_linferr = 0;
+  double chi_m_l2 = 0, chi_m_linf = 0, chi_m_l2err = 0, chi_m_linferr = 0;
+  double lam_s_l2 = 0, lam_s_linf = 0, lam_s_l2err = 0, lam_s_linferr = 0;
+  double lam_d_l2 = 0, lam_d_linf = 0, lam_d_l2err = 0, lam_d_linferr = 0;
+  double lam_m_l2 = 0, lam_m_linf = 0, lam_m_l2err = 0, lam_m_linferr = 0;
+  auto pol_s   = nda::vector<dcomplex>();
+  auto pol_d   = nda::vector<dcomplex>();
+  auto pol_m   = nda::vector<dcomplex>();
+  auto pol_s_c = nda::array<dcomplex, 1>();
+  auto pol_d_c = nda::array<dcomplex, 1>();
+  auto pol_m_c = nda::array<dcomplex, 1>();
+
+  fmt::print("Fitting chi, lambda, testing expansions and computing polarization...\n");
   auto start = std::chrono::high_resolution_clock::now();
-  if (!compressbasis) {
-    auto valsall  = fmatrix(niom, 6);
-    valsall(_, 0) = chi_s;
-    valsall(_, 1) = chi_d;
-    valsall(_, 2) = chi_m;
-    valsall(_, 3) = lam_s;
-    valsall(_, 4) = lam_d;
-    valsall(_, 5) = lam_m;
-
-    auto [coefsall, coefsingall] = vals2coefs_if_many(kmat, valsall, r);
-
-    chi_s_c     = coefsall(0, _, _, _);
-    chi_d_c     = coefsall(1, _, _, _);
-    chi_m_c     = coefsall(2, _, _, _);
-    lam_s_c     = coefsall(3, _, _, _);
-    lam_d_c     = coefsall(4, _, _, _);
-    lam_m_c     = coefsall(5, _, _, _);
-    chi_s_csing = coefsingall(0, _);
-    chi_d_csing = coefsingall(1, _);
-    chi_m_csing = coefsingall(2, _);
-    lam_s_csing = coefsingall(3, _);
-    lam_d_csing = coefsingall(4, _);
-    lam_m_csing = coefsingall(5, _);
+  blas_thread_scope blas(1); // Tasks run concurrently, one BLAS thread each
+#pragma omp parallel
+#pragma omp single
+  {
+    // Fits
+    if (!compressbasis) {
+#pragma omp task depend(out : chi_s_c, chi_d_c, chi_m_c, lam_s_c, lam_d_c, lam_m_c)
+      {
+        auto valsall  = fmatrix(niom, 6);
+        valsall(_, 0) = chi_s;
+        valsall(_, 1) = chi_d;
+        valsall(_, 2) = chi_m;
+        valsall(_, 3) = lam_s;
+        valsall(_, 4) = lam_d;
+        valsall(_, 5) = lam_m;
+
+        auto [coefsall, coefsingall] = vals2coefs_if_many(kmat, valsall, r);
+
+        chi_s_c     = coefsall(0, _, _, _);
+        chi_d_c     = coefsall(1, _, _, _);
+        chi_m_c     = coefsall(2, _, _, _);
+        lam_s_c     = coefsall(3, _, _, _);
+        lam_d_c     = coefsall(4, _, _, _);
+        lam_m_c     = coefsall(5, _, _, _);
+        chi_s_csing = coefsingall(0, _);
+        chi_d_csing = coefsingall(1, _);
+        chi_m_csing = coefsingall(2, _);
+        lam_s_csing = coefsingall(3, _);
+        lam_d_csing = coefsingall(4, _);
+        lam_m_csing = coefsingall(5, _);
+      }
+    } else {
+#pragma omp task depend(out : chi_s_c)
+      std::tie(chi_s_c, chi_s_csing) = uncompress_basis(r, dlr2d_rfidx, vals2coefs_if_square(kmat, chi_s));
+#pragma omp task depend(out : chi_d_c)
+      std::tie(chi_d_c, chi_d_csing) = uncompress_basis(r, dlr2d_rfidx, vals2coefs_if_square(kmat, chi_d));
+#pragma omp task depend(out : chi_m_c)
+      std::tie(chi_m_c, chi_m_csing) = uncompress_basis(r, dlr2d_rfidx, vals2coefs_if_square(kmat, chi_m));
+#pragma omp task depend(out : lam_s_c)
+      std::tie(lam_s_c, lam_s_csing) = uncompress_basis(r, dlr2d_rfidx, vals2coefs_if_square(kmat, lam_s));
+#pragma omp task depend(out : lam_d_c)
+      std::tie(lam_d_c, lam_d_csing) = uncompress_basis(r, dlr2d_rfidx, vals2coefs_if_square(kmat, lam_d));
+#pragma omp task depend(out : lam_m_c)
+      std::tie(lam_m_c, lam_m_csing) = uncompress_basis(r, dlr2d_rfidx, vals2coefs_if_square(kmat, lam_m));
+    }
 
-  } else {
-    auto chi_s_c_compressed = vals2coefs_if_square(kmat, chi_s);
-    auto chi_d_c_compressed = vals2coefs_if_square(kmat, chi_d);
-    auto chi_m_c_compressed = vals2coefs_if_square(kmat, chi_m);
-    auto lam_s_c_compressed = vals2coefs_if_square(kmat, lam_s);
-    auto lam_d_c_compressed = vals2coefs_if_square(kmat, lam_d);
-    auto lam_m_c_compressed = vals2coefs_if_square(kmat, lam_m);
-
-    std::tie(chi_s_c, chi_s_csing) = uncompress_basis(r, dlr2d_rfidx, chi_s_c_compressed);
-    std::tie(chi_d_c, chi_d_csing) = uncompress_basis(r, dlr2d_rfidx, chi_d_c_compressed);
-    std::tie(chi_m_c, chi_m_csing) = uncompress_basis(r, dlr2d_rfidx, chi_m_c_compressed);
-    std::tie(lam_s_c, lam_s_csing) = uncompress_basis(r, dlr2d_rfidx, lam_s_c_compressed);
-    std::tie(lam_d_c, lam_d_csing) = uncompress_basis(r, dlr2d_rfidx, lam_d_c_compressed);
-    std::tie(lam_m_c, lam_m_csing) = uncompress_basis(r, dlr2d_rfidx, lam_m_c_compressed);
+    // Error measurement on test grid
+#pragma omp task depend(in : chi_s_c)
+    std::tie(chi_s_l2, chi_s_linf, chi_s_l2err, chi_s_linferr) = measure_error_if(beta, niomtst, eval(chi_s_c, chi_s_csing, 1), data(chi_s_data, 0));
+#pragma omp task depend(in : chi_d_c)
+    std::tie(chi_d_l2, chi_d_linf, chi_d_l2err, chi_d_linferr) = measure_error_if(beta, niomtst, eval(chi_d_c, chi_d_csing, 2), data(chi_d_data, 0));
+#pragma omp task depend(in : chi_m_c)
+    std::tie(chi_m_l2, chi_m_linf, chi_m_l2err, chi_m_linferr) = measure_error_if(beta, niomtst, eval(chi_m_c, chi_m_csing, 2), data(chi_m_data, 0));
+#pragma omp task depend(in : lam_s_c)
+    std::tie(lam_s_l2, lam_s_linf, lam_s_l2err, lam_s_linferr) = measure_error_if(beta, niomtst, eval(lam_s_c, lam_s_csing, 1), data(lam_s_data, 1));
+#pragma omp task depend(in : lam_d_c)
+    std::tie(lam_d_l2, lam_d_linf, lam_d_l2err, lam_d_linferr) = measure_error_if(beta, niomtst, eval(lam_d_c, lam_d_csing, 2), data(lam_d_data, 1));
+#pragma omp task depend(in : lam_m_c)
+    std::tie(lam_m_l2, lam_m_linf, lam_m_l2err, lam_m_linferr) = measure_error_if(beta, niomtst, eval(lam_m_c, lam_m_csing, 2), data(lam_m_data, 1));
+
+    // Polarization from DLR expansions
+#pragma omp task depend(in : lam_s_c)
+    {
+      pol_s = polarization(beta, lambda, eps, itops, ifops_fer, ifops_bos, gc, gc, lam_s_c, lam_s_csing);
+      pol_s *= -1.0 / 2;
+      pol_s_c = nda::array<dcomplex, 1>(ifops_bos.vals2coefs(beta, pol_s));
+    }
+#pragma omp task depend(in : lam_d_c)
+    {
+      pol_d   = polarization(beta, lambda, eps, itops, ifops_fer, ifops_bos, grc, gc, lam_d_c, lam_d_csing);
+      pol_d_c = nda::array<dcomplex, 1>(ifops_bos.vals2coefs(beta, pol_d));
+    }
+#pragma omp task depend(in : lam_m_c)
+    {
+      pol_m   = polarization(beta, lambda, eps, itops, ifops_fer, ifops_bos, grc, gc, lam_m_c, lam_m_csing);
+      pol_m_c = nda::array<dcomplex, 1>(ifops_bos.vals2coefs(beta, pol_m));
+    }
   }
   auto end = std::chrono::high_resolution_clock::now();
   fmt::print("Time: {}\n", std::chrono::duration<double>(end - start).count());
@@ -194,77 +268,7 @@ nda::vector<double> siam_allfuncs(double beta, double u, double lambda, double e
   fmt::print("L2 norm:    {}\n", sqrt(sum(pow(abs(g_tru), 2))) / beta);
   fmt::print("L2 error:   {}\n", sqrt(sum(pow(abs(g_tru - g_tst), 2))) / beta);
 
-  // Test DLR expansion of vertex function
-  fmt::print("Testing DLR expansion of vertex function...\n");
-
-  // Evaluate expansion on test grid and measure error
-  auto chi_s_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto chi_d_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto chi_m_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto chi_s_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto chi_d_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto chi_m_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_s_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_d_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_m_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_s_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_d_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_m_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  int midx = 0, nidx = 0;
-  start = std::chrono::high_resolution_clock::now();
-  for (int m = -niomtst / 2; m < niomtst / 2; ++m) {
-    for (int n = -niomtst / 2; n < niomtst / 2; ++n) {
-      midx = niomtst / 2 + m;
-      nidx = niomtst / 2 + n;
-
-      // Evaluate true functions
-      chi_s_tru(midx, nidx) = chi_s_data(chi_nmax + m, chi_nmax + n);
-      chi_d_tru(midx, nidx) = chi_d_data(chi_nmax + m, chi_nmax + n);
-      chi_m_tru(midx, nidx) = chi_m_data(chi_nmax + m, chi_nmax + n);
-      lam_s_tru(midx, nidx) = lam_s_data(chi_nmax + m, chi_nmax + n) - 1;
-      lam_d_tru(midx, nidx) = lam_d_data(chi_nmax + m, chi_nmax + n) - 1;
-      lam_m_tru(midx, nidx) = lam_m_data(chi_nmax + m, chi_nmax + n) - 1;
-
-      // Evaluate DLR expansions
-      chi_s_tst(midx, nidx) = coefs2eval_if(beta, dlr_rf, chi_s_c, chi_s_csing, m, n, 1);
-      chi_d_tst(midx, nidx) = coefs2eval_if(beta, dlr_rf, chi_d_c, chi_d_csing, m, n, 2);
-      chi_m_tst(midx, nidx) = coefs2eval_if(beta, dlr_rf, chi_m_c, chi_m_csing, m, n, 2);
-      lam_s_tst(midx, nidx) = coefs2eval_if(beta, dlr_rf, lam_s_c, lam_s_csing, m, n, 1);
-      lam_d_tst(midx, nidx) = coefs2eval_if(beta, dlr_rf, lam_d_c, lam_d_csing, m, n, 2);
-      lam_m_tst(midx, nidx) = coefs2eval_if(beta, dlr_rf, lam_m_c, lam_m_csing, m, n, 2);
-    }
-  }
-  end = std::chrono::high_resolution_clock::now();
-  fmt::print("Time: {}\n\n", std::chrono::duration<double>(end - start).count());
-
-  double chi_s_l2 = sqrt(sum(pow(abs(chi_s_tru), 2))) / beta / beta;
-  double chi_d_l2 = sqrt(sum(pow(abs(chi_d_tru), 2))) / beta / beta;
-  double chi_m_l2 = sqrt(sum(pow(abs(chi_m_tru), 2))) / beta / beta;
-  double lam_s_l2 = sqrt(sum(pow(abs(lam_s_tru), 2))) / beta / beta;
-  double lam_d_l2 = sqrt(sum(pow(abs(lam_d_tru), 2))) / beta / beta;
-  double lam_m_l2 = sqrt(sum(pow(abs(lam_m_tru), 2))) / beta / beta;
-
-  double chi_s_linf = max_element(abs(chi_s_tru));
-  double chi_d_linf = max_element(abs(chi_d_tru));
-  double chi_m_linf = max_element(abs(chi_m_tru));
-  double lam_s_linf = max_element(abs(lam_s_tru));
-  double lam_d_linf = max_element(abs(lam_d_tru));
-  double lam_m_linf = max_element(abs(lam_m_tru));
-
-  double chi_s_l2err = sqrt(sum(pow(abs(chi_s_tru - chi_s_tst), 2))) / beta / beta;
-  double chi_d_l2err = sqrt(sum(pow(abs(chi_d_tru - chi_d_tst), 2))) / beta / beta;
-  double chi_m_l2err = sqrt(sum(pow(abs(chi_m_tru - chi_m_tst), 2))) / beta / beta;
-  double lam_s_l2err = sqrt(sum(pow(abs(lam_s_tru - lam_s_tst), 2))) / beta / beta;
-  double lam_d_l2err = sqrt(sum(pow(abs(lam_d_tru - lam_d_tst), 2))) / beta / beta;
-  double lam_m_l2err = sqrt(sum(pow(abs(lam_m_tru - lam_m_tst), 2))) / beta / beta;
-
-  double chi_s_linferr = max_element(abs(chi_s_tru - chi_s_tst));
-  double chi_d_linferr = max_element(abs(chi_d_tru - chi_d_tst));
-  double chi_m_linferr = max_element(abs(chi_m_tru - chi_m_tst));
-  double lam_s_linferr = max_element(abs(lam_s_tru - lam_s_tst));
-  double lam_d_linferr = max_element(abs(lam_d_tru - lam_d_tst));
-  double lam_m_linferr = max_element(abs(lam_m_tru - lam_m_tst));
-
+  // Errors of DLR expansions of correlation and vertex functions
   fmt::print("--- chi_S results ---\n");
   fmt::print("L2 norm:    {}\n", chi_s_l2);
   fmt::print("Linf norm:  {}\n", chi_s_linf);
@@ -301,31 +305,6 @@ nda::vector<double> siam_allfuncs(double beta, double u, double lambda, double e
   fmt::print("L2 error:   {}\n", lam_m_l2err);
   fmt::print("Linf error: {}\n\n", lam_m_linferr);
 
-  // Compute polarization from DLR expansions
-  auto itops = imtime_ops(lambda, dlr_rf);
-
-  // auto pol_s =
-  //     polarization_res(beta, ifops_fer, ifops_bos, gc, gc, lam_s_c,
-  //     lam_s_csing);
-  // pol_s += polarization_const(beta, itops, ifops_bos, gc, gc);
-  auto pol_s = polarization(beta, lambda, eps, itops, ifops_fer, ifops_bos, gc, gc, lam_s_c, lam_s_csing);
-  pol_s *= -1.0 / 2;
-
-  // auto pol_d =
-  //     polarization_res(beta, ifops_fer, ifops_bos, grc, gc, lam_d_c,
-  //     lam_d_csing);
-  // pol_d += polarization_const(beta, itops, ifops_bos, grc, gc);
-  auto pol_d = polarization(beta, lambda, eps, itops, ifops_fer, ifops_bos, grc, gc, lam_d_c, lam_d_csing);
-
-  // auto pol_m =
-  //     polarization_res(beta, ifops_fer, ifops_bos, grc, gc, lam_m_c,
-  //     lam_m_csing);
-  // pol_m += polarization_const(beta, itops, ifops_bos, grc, gc);
-  auto pol_m = polarization(beta, lambda, eps, itops, ifops_fer, ifops_bos, grc, gc, lam_m_c, lam_m_csing);
-
-  auto pol_s_c = ifops_bos.vals2coefs(beta, pol_s); // DLR expansion
-  auto pol_d_c = ifops_bos.vals2coefs(beta, pol_d);
-  auto pol_m_c = ifops_bos.vals2coefs(beta, pol_m);
 
   // Evaluate polarization on dense grid
   auto pol_s_tst             = nda::vector<dcomplex>(nbos_tst);
@@ -612,74 +591,32 @@ nda::vector<double> siam_allfuncs_3term(double beta, double u, double lambda, do
   // Test DLR expansion of vertex function
   fmt::print("Testing DLR expansion of vertex function...\n");
 
-  // Evaluate expansion on test grid and measure error
-  auto chi_s_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto chi_d_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto chi_m_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto chi_s_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto chi_d_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto chi_m_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_s_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_d_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_m_tst = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_s_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_d_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  auto lam_m_tru = nda::array<dcomplex, 2>(niomtst, niomtst);
-  int midx = 0, nidx = 0;
+  // Evaluate expansions and true functions on test grid tile by tile, and
+  // measure errors
+  auto eval = [&](auto const &c, auto const &csing, int channel) {
+    return [&, channel](nda::array_const_view<int, 2> idx) {
+      auto vals = nda::vector<dcomplex>(idx.shape(0));
+      for (int i = 0; i < idx.shape(0); ++i) { vals(i) = coefs2eval_if_3term(beta, dlr_rf, c, csing, idx(i, 0), idx(i, 1), channel); }
+      return vals;
+    };
+  };
+  auto data = [&](auto const &f, double shift) {
+    return [&, shift](nda::array_const_view<int, 2> idx) {
+      auto vals = nda::vector<dcomplex>(idx.shape(0));
+      for (int i = 0; i < idx.shape(0); ++i) { vals(i) = f(chi_nmax + idx(i, 0), chi_nmax + idx(i, 1)) - shift; }
+      return vals;
+    };
+  };
   start = std::chrono::high_resolution_clock::now();
-  for (int m = -niomtst / 2; m < niomtst / 2; ++m) {
-    for (int n = -niomtst / 2; n < niomtst / 2; ++n) {
-      midx = niomtst / 2 + m;
-      nidx = niomtst / 2 + n;
-
-      // Evaluate true functions
-      chi_s_tru(midx, nidx) = chi_s_data(chi_nmax + m, chi_nmax + n);
-      chi_d_tru(midx, nidx) = chi_d_data(chi_nmax + m, chi_nmax + n);
-      chi_m_tru(midx, nidx) = chi_m_data(chi_nmax + m, chi_nmax + n);
-      lam_s_tru(midx, nidx) = lam_s_data(chi_nmax + m, chi_nmax + n) - 1;
-      lam_d_tru(midx, nidx) = lam_d_data(chi_nmax + m, chi_nmax + n) - 1;
-      lam_m_tru(midx, nidx) = lam_m_data(chi_nmax + m, chi_nmax + n) - 1;
-
-      // Evaluate DLR expansions
-      chi_s_tst(midx, nidx) = coefs2eval_if_3term(beta, dlr_rf, chi_s_c, chi_s_csing, m, n, 1);
-      chi_d_tst(midx, nidx) = coefs2eval_if_3term(beta, dlr_rf, chi_d_c, chi_d_csing, m, n, 2);
-      chi_m_tst(midx, nidx) = coefs2eval_if_3term(beta, dlr_rf, chi_m_c, chi_m_csing, m, n, 2);
-      lam_s_tst(midx, nidx) = coefs2eval_if_3term(beta, dlr_rf, lam_s_c, lam_s_csing, m, n, 1);
-      lam_d_tst(midx, nidx) = coefs2eval_if_3term(beta, dlr_rf, lam_d_c, lam_d_csing, m, n, 2);
-      lam_m_tst(midx, nidx) = coefs2eval_if_3term(beta, dlr_rf, lam_m_c, lam_m_csing, m, n, 2);
-    }
-  }
+  auto [chi_s_l2, chi_s_linf, chi_s_l2err, chi_s_linferr] = measure_error_if(beta, niomtst, eval(chi_s_c, chi_s_csing, 1), data(chi_s_data, 0));
+  auto [chi_d_l2, chi_d_linf, chi_d_l2err, chi_d_linferr] = measure_error_if(beta, niomtst, eval(chi_d_c, chi_d_csing, 2), data(chi_d_data, 0));
+  auto [chi_m_l2, chi_m_linf, chi_m_l2err, chi_m_linferr] = measure_error_if(beta, niomtst, eval(chi_m_c, chi_m_csing, 2), data(chi_m_data, 0));
+  auto [lam_s_l2, lam_s_linf, lam_s_l2err, lam_s_linferr] = measure_error_if(beta, niomtst, eval(lam_s_c, lam_s_csing, 1), data(lam_s_data, 1));
+  auto [lam_d_l2, lam_d_linf, lam_d_l2err, lam_d_linferr] = measure_error_if(beta, niomtst, eval(lam_d_c, lam_d_csing, 2), data(lam_d_data, 1));
+  auto [lam_m_l2, lam_m_linf, lam_m_l2err, lam_m_linferr] = measure_error_if(beta, niomtst, eval(lam_m_c, lam_m_csing, 2), data(lam_m_data, 1));
   end = std::chrono::high_resolution_clock::now();
   fmt::print("Time: {}\n", std::chrono::duration<double>(end - start).count());
 
-  double chi_s_l2 = sqrt(sum(pow(abs(chi_s_tru), 2))) / beta / beta;
-  double chi_d_l2 = sqrt(sum(pow(abs(chi_d_tru), 2))) / beta / beta;
-  double chi_m_l2 = sqrt(sum(pow(abs(chi_m_tru), 2))) / beta / beta;
-  double lam_s_l2 = sqrt(sum(pow(abs(lam_s_tru), 2))) / beta / beta;
-  double lam_d_l2 = sqrt(sum(pow(abs(lam_d_tru), 2))) / beta / beta;
-  double lam_m_l2 = sqrt(sum(pow(abs(lam_m_tru), 2))) / beta / beta;
-
-  double chi_s_linf = max_element(abs(chi_s_tru));
-  double chi_d_linf = max_element(abs(chi_d_tru));
-  double chi_m_linf = max_element(abs(chi_m_tru));
-  double lam_s_linf = max_element(abs(lam_s_tru));
-  double lam_d_linf = max_element(abs(lam_d_tru));
-  double lam_m_linf = max_element(abs(lam_m_tru));
-
-  double chi_s_l2err = sqrt(sum(pow(abs(chi_s_tru - chi_s_tst), 2))) / beta / beta;
-  double chi_d_l2err = sqrt(sum(pow(abs(chi_d_tru - chi_d_tst), 2))) / beta / beta;
-  double chi_m_l2err = sqrt(sum(pow(abs(chi_m_tru - chi_m_tst), 2))) / beta / beta;
-  double lam_s_l2err = sqrt(sum(pow(abs(lam_s_tru - lam_s_tst), 2))) / beta / beta;
-  double lam_d_l2err = sqrt(sum(pow(abs(lam_d_tru - lam_d_tst), 2))) / beta / beta;
-  double lam_m_l2err = sqrt(sum(pow(abs(lam_m_tru - lam_m_tst), 2))) / beta / beta;
-
-  double chi_s_linferr = max_element(abs(chi_s_tru - chi_s_tst));
-  double chi_d_linferr = max_element(abs(chi_d_tru - chi_d_tst));
-  double chi_m_linferr = max_element(abs(chi_m_tru - chi_m_tst));
-  double lam_s_linferr = max_element(abs(lam_s_tru - lam_s_tst));
-  double lam_d_linferr = max_element(abs(lam_d_tru - lam_d_tst));
-  double lam_m_linferr = max_element(abs(lam_m_tru - lam_m_tst));
-
   fmt::print("--- chi_S results ---\n");
   fmt::print("L2 norm:    {}\n", chi_s_l2);
   fmt::print("Linf norm:  {}\n", chi_s_linf);
@@ -18,6 +18,8 @@ using namespace dlr2d;
  * functions", arXiv:2405.06716. It then computes the polarization function in
  * all channels. It measures the error of all of these representations against
  * data computed using exact diagonalization which must be supplied externally.
+ * The fits, error measurements and polarizations of the different channels are
+ * run concurrently as OpenMP tasks.
  *
  * \param[in] beta          Inverse temperature
  * \param[in] u             Hubbard interaction
@@ -30,12 +32,14 @@ using namespace dlr2d;
  * \param[in] compressbasis Overcomplete or compressed DLR basis
  * \param[in] niom_dense    # Matsubara freqs in fine grid (only used if
  * reduced=false)
+ * \param[in] multieps      Read grid generated by \ref build_dlr2d_if_multieps
+ * (requires reduced=true and compressbasis=false)
  *
  * \return Vector containing problem parameters and errors, for analysis and
  * plotting
  */
 nda::vector<double> siam_allfuncs(double beta, double u, double lambda, double eps, int niomtst, int nbos_tst, bool reduced, bool compressbasis,
-                                  int niom_dense = 0);
+                                  int niom_dense = 0, bool multieps = false);
 
 /*!
  * \brief Driver function for single-impurity Anderson model example, all
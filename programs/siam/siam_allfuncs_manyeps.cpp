@@ -1,6 +1,7 @@
 #include "siam.hpp"
 
 #include <fstream>
+#include <stdexcept>
 
 using namespace dlr2d;
 
@@ -14,19 +15,32 @@ int main() {
   bool reduced       = true;  // Full or reduced fine grid
   bool compressbasis = true;  // Overcomplete or compressed basis
   int niom_dense     = 100;   // # imag freq sample pts for fine grid (must be even)
+  bool multieps      = false; // Generate grids for all eps from a single pivoted QR
 
   auto filename = "siam_recompress";
 
   int nexp     = 6;
   int nresult  = 42;
   auto results = nda::array<double, 2>(nresult, nexp);
-  double eps   = 0;
+  auto epss    = nda::vector<double>(nexp);
+  for (int i = 0; i < nexp; ++i) { epss(i) = pow(10, -2.0 * (i + 1)); }
+
+  // Generate reduced, overcomplete grids for all eps at once, stored separately
+  // from the standard grids
+  if (multieps) {
+    if (threeterm || !reduced || compressbasis) {
+      throw std::runtime_error("multieps requires threeterm = false, reduced = true and compressbasis = false.");
+    }
+    build_dlr2d_if_multieps(lambda, epss, "../../../dlr2d_if_data/");
+  }
+
+  double eps = 0;
   for (int i = 0; i < nexp; ++i) {
-    eps = pow(10, -2.0 * (i + 1));
+    eps = epss(i);
     if (threeterm) {
       results(nda::range::all, i) = siam_allfuncs_3term(beta, u, lambda, eps, niomtst, nbos_tst);
     } else {
-      results(nda::range::all, i) = siam_allfuncs(beta, u, lambda, eps, niomtst, nbos_tst, reduced, compressbasis, niom_dense);
+      results(nda::range::all, i) = siam_allfuncs(beta, u, lambda, eps, niomtst, nbos_tst, reduced, compressbasis, niom_dense, multieps);
     }
   }
 
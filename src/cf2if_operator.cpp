@@ -0,0 +1,263 @@
+#include "cf2if_operator.hpp"
+
+#include <array>
+#include <utility>
+
+namespace dlr2d {
+
+  using namespace cppdlr;
+
+  cf2if_operator::cf2if_operator(double beta, nda::vector_const_view<double> dlr_rf, nda::array_const_view<int, 2> dlr2d_if)
+     : beta(beta), r(dlr_rf.size()), niom(dlr2d_if.shape(0)) {
+
+    // 1D kernels on 2D DLR grid, as used by build_cf2if
+    auto k1d = build_k1d_if(dlr_rf, dlr2d_if, true);
+    kf1      = std::move(k1d[0]);
+    kf2      = std::move(k1d[1]);
+    kb       = std::move(k1d[2]);
+
+    // Anti-diagonal grid points
+    int nsng = 0;
+    for (int n = 0; n < niom; ++n) {
+      if (dlr2d_if(n, 0) == -dlr2d_if(n, 1) - 1) ++nsng;
+    }
+    sng  = nda::vector<int>(nsng);
+    nsng = 0;
+    for (int n = 0; n < niom; ++n) {
+      if (dlr2d_if(n, 0) == -dlr2d_if(n, 1) - 1) sng(nsng++) = n;
+    }
+  }
+
+  nda::vector<dcomplex> cf2if_operator::apply(nda::vector_const_view<dcomplex> c) const {
+
+    auto vals = nda::vector<dcomplex>(niom);
+    auto cblk = fmatrix(r, r);
+    auto p    = fmatrix(niom, r);
+    vals      = 0;
+
+    // Regular part: term t contributes sum_l (ka * C_t)(n, l) kc(n, l), where
+    // ka and kc are the 1D kernel matrices of its two factors
+    auto ka = std::array<fmatrix const *, 3>{&kf1, &kf2, &kf1};
+    auto kc = std::array<fmatrix const *, 3>{&kf2, &kb, &kb};
+    for (int t = 0; t < 3; ++t) {
+      for (int k = 0; k < r; ++k) {
+        for (int l = 0; l < r; ++l) { cblk(k, l) = c(t * r * r + k * r + l); }
+      }
+      p = (*ka[t]) * cblk;
+      for (int l = 0; l < r; ++l) {
+        for (int n = 0; n < niom; ++n) { vals(n) += p(n, l) * (*kc[t])(n, l); }
+      }
+    }
+
+    // Singular part
+    for (int j = 0; j < sng.size(); ++j) {
+      for (int k = 0; k < r; ++k) { vals(sng(j)) += kf1(sng(j), k) * c(3 * r * r + k); }
+    }
+
+    vals *= beta * beta;
+
+    return vals;
+  }
+
+  nda::vector<dcomplex> cf2if_operator::apply(nda::array_const_view<dcomplex, 3> gc_reg, nda::array_const_view<dcomplex, 1> gc_sng) const {
+
+    auto c = nda::vector<dcomplex>(3 * r * r + r);
+    for (int t = 0; t < 3; ++t) {
+      for (int k = 0; k < r; ++k) {
+        for (int l = 0; l < r; ++l) { c(t * r * r + k * r + l) = gc_reg(t, k, l); }
+      }
+    }
+    c(nda::range(3 * r * r, 3 * r * r + r)) = gc_sng;
+
+    return apply(c);
+  }
+
+  nda::vector<dcomplex> cf2if_operator::adjoint(nda::vector_const_view<dcomplex> vals) const {
+
+    auto c  = nda::vector<dcomplex>(3 * r * r + r);
+    auto yk = fmatrix(niom, r);
+    auto q  = fmatrix(r, r);
+
+    // Regular part: block t is ka^H * diag(vals) * conj(kc), where ka and kc
+    // are the 1D kernel matrices of its two factors
+    auto ka = std::array<fmatrix const *, 3>{&kf1, &kf2, &kf1};
+    auto kc = std::array<fmatrix const *, 3>{&kf2, &kb, &kb};
+    for (int t = 0; t < 3; ++t) {
+      for (int l = 0; l < r; ++l) {
+        for (int n = 0; n < niom; ++n) { yk(n, l) = vals(n) * conj((*kc[t])(n, l)); }
+      }
+      q = fmatrix(conj(transpose(*ka[t]))) * yk;
+      for (int k = 0; k < r; ++k) {
+        for (int l = 0; l < r; ++l) { c(t * r * r + k * r + l) = q(k, l); }
+      }
+    }
+
+    // Singular part
+    for (int k = 0; k < r; ++k) {
+      c(3 * r * r + k) = 0;
+      for (int j = 0; j < sng.size(); ++j) { c(3 * r * r + k) += conj(kf1(sng(j), k)) * vals(sng(j)); }
+    }
+
+    c *= beta * beta;
+
+    return c;
+  }
+
+  nda::vector<double> cf2if_operator::colnorms() const {
+
+    auto nrm = nda::vector<double>(3 * r * r + r);
+
+    // |kf1|^2, |kf2|^2, |kb|^2
+    auto kf1sq = nda::matrix<double, nda::F_layout>(niom, r);
+    auto kf2sq = nda::matrix<double, nda::F_layout>(niom, r);
+    auto kbsq  = nda::matrix<double, nda::F_layout>(niom, r);
+    for (int k = 0; k < r; ++k) {
+      for (int n = 0; n < niom; ++n) {
+        kf1sq(n, k) = std::norm(kf1(n, k));
+        kf2sq(n, k) = std::norm(kf2(n, k));
+        kbsq(n, k)  = std::norm(kb(n, k));
+      }
+    }
+
+    // Regular part
+    auto ka = std::array<nda::matrix<double, nda::F_layout> const *, 3>{&kf1sq, &kf2sq, &kf1sq};
+    auto kc = std::array<nda::matrix<double, nda::F_layout> const *, 3>{&kf2sq, &kbsq, &kbsq};
+    for (int t = 0; t < 3; ++t) {
+      auto q = nda::matrix<double, nda::F_layout>(transpose(*ka[t]) * (*kc[t]));
+      for (int k = 0; k < r; ++k) {
+        for (int l = 0; l < r; ++l) { nrm(t * r * r + k * r + l) = q(k, l); }
+      }
+    }
+
+    // Singular part
+    for (int k = 0; k < r; ++k) {
+      nrm(3 * r * r + k) = 0;
+      for (int j = 0; j < sng.size(); ++j) { nrm(3 * r * r + k) += kf1sq(sng(j), k); }
+    }
+
+    for (int i = 0; i < nrm.size(); ++i) { nrm(i) = beta * beta * sqrt(nrm(i)); }
+
+    return nrm;
+  }
+
+  std::tuple<nda::vector<dcomplex>, int> lsqr_cf2if(cf2if_operator const &op, nda::vector_const_view<dcomplex> vals, nda::vector_const_view<dcomplex> c0,
+                                                    double tol, int maxit) {
+
+    int ncoef = op.ncols();
+
+    // Column scaling; columns which vanish on the grid (singular terms, if no
+    // grid point lies on the anti-diagonal) are left unscaled
+    auto d = op.colnorms();
+    for (int i = 0; i < ncoef; ++i) { d(i) = (d(i) > 0) ? 1.0 / d(i) : 1.0; }
+
+    auto vecnorm = [](nda::vector_const_view<dcomplex> x) { return sqrt(sum(pow(abs(x), 2))); };
+
+    // Initial residual
+    auto c = nda::vector<dcomplex>(ncoef);
+    auto u = nda::vector<dcomplex>(vals);
+    if (c0.size() > 0) {
+      c = c0;
+      u -= op.apply(c0);
+    } else {
+      c = 0;
+    }
+    double bnorm = vecnorm(vals);
+
+    // Golub-Kahan bidiagonalization of A D, started from the residual
+    double beta = vecnorm(u);
+    if (beta <= tol * bnorm) return {c, 0};
+    u /= beta;
+
+    auto v = nda::vector<dcomplex>(ncoef);
+    v      = op.adjoint(u);
+    for (int i = 0; i < ncoef; ++i) { v(i) *= d(i); }
+    double alpha = vecnorm(v);
+    if (alpha == 0) return {c, 0};
+    v /= alpha;
+
+    auto w = nda::vector<dcomplex>(v);
+    auto y = nda::vector<dcomplex>(ncoef); // Correction in scaled variables
+    auto z = nda::vector<dcomplex>(ncoef);
+    y      = 0;
+
+    double phibar = beta, rhobar = alpha;
+    double anormsq = 0;
+    int it         = 0;
+    while (it < maxit) {
+      ++it;
+
+      // Continue bidiagonalization
+      for (int i = 0; i < ncoef; ++i) { z(i) = d(i) * v(i); }
+      u    = op.apply(z) - alpha * u;
+      beta = vecnorm(u);
+      if (beta > 0) u /= beta;
+
+      anormsq += alpha * alpha + beta * beta;
+
+      z = op.adjoint(u);
+      for (int i = 0; i < ncoef; ++i) { z(i) = d(i) * z(i) - beta * v(i); }
+      v     = z;
+      alpha = vecnorm(v);
+      if (alpha > 0) v /= alpha;
+
+      // Apply plane rotation to eliminate subdiagonal
+      double rho   = sqrt(rhobar * rhobar + beta * beta);
+      double cs    = rhobar / rho;
+      double sn    = beta / rho;
+      double theta = sn * alpha;
+      rhobar       = -cs * alpha;
+      double phi   = cs * phibar;
+      phibar       = sn * phibar;
+
+      // Update solution and search direction
+      y += (phi / rho) * w;
+      w = v - (theta / rho) * w;
+
+      // Stopping criteria
+      if (phibar <= tol * bnorm) break;
+      if (phibar * alpha * std::abs(cs) <= tol * sqrt(anormsq) * phibar) break;
+    }
+
+    // Undo column scaling
+    for (int i = 0; i < ncoef; ++i) { c(i) += d(i) * y(i); }
+
+    return {c, it};
+  }
+
+  std::tuple<nda::array<dcomplex, 3>, nda::array<dcomplex, 1>> vals2coefs_if_lsqr(cf2if_operator const &op, nda::vector_const_view<dcomplex> vals,
+                                                                                  double tol, int maxit, nda::array_const_view<dcomplex, 3> gc_reg,
+                                                                                  nda::array_const_view<dcomplex, 1> gc_sng) {
+
+    int r = op.rank();
+
+    // Flatten initial guess
+    auto c0 = nda::vector<dcomplex>(3 * r * r + r);
+    for (int t = 0; t < 3; ++t) {
+      for (int k = 0; k < r; ++k) {
+        for (int l = 0; l < r; ++l) { c0(t * r * r + k * r + l) = gc_reg(t, k, l); }
+      }
+    }
+    c0(nda::range(3 * r * r, 3 * r * r + r)) = gc_sng;
+
+    auto [c, niter] = lsqr_cf2if(op, vals, c0, tol, maxit);
+
+    auto coefreg = nda::array<dcomplex, 3>(3, r, r);
+    auto coefsng = nda::array<dcomplex, 1>(r);
+    for (int t = 0; t < 3; ++t) {
+      for (int k = 0; k < r; ++k) {
+        for (int l = 0; l < r; ++l) { coefreg(t, k, l) = c(t * r * r + k * r + l); }
+      }
+    }
+    coefsng = c(nda::range(3 * r * r, 3 * r * r + r));
+
+    return {coefreg, coefsng};
+  }
+
+  std::tuple<nda::array<dcomplex, 3>, nda::array<dcomplex, 1>> vals2coefs_if_lsqr(cf2if_operator const &op, nda::vector_const_view<dcomplex> vals,
+                                                                                  double tol, int maxit) {
+
+    int r = op.rank();
+    return vals2coefs_if_lsqr(op, vals, tol, maxit, nda::zeros<dcomplex>(3, r, r), nda::zeros<dcomplex>(r));
+  }
+
+} // namespace dlr2d
@@ -0,0 +1,189 @@
+#pragma once
+
+#include "dlr2d.hpp"
+
+namespace dlr2d {
+
+  /*!
+ * \brief Matrix-free representation of the 2D DLR coefficients to values
+ * matrix
+ *
+ * This class represents the niom x (3r^2 + r) matrix returned by \ref
+ * build_cf2if without forming it. Each column of that matrix is a Hadamard
+ * product of two 1D kernel vectors evaluated on the 2D DLR grid, so only the
+ * three niom x r matrices of 1D kernels (fermionic in the first and second
+ * argument, bosonic in their sum) are stored, reducing storage from O(niom r^2)
+ * to O(niom r). Products with the matrix and its adjoint are computed by
+ * matrix-matrix products of these kernel matrices with r x r blocks of
+ * coefficients, followed by row-wise contractions.
+ *
+ * Coefficient vectors are flattened in the ordering of the columns of \ref
+ * build_cf2if, which coincides with the row-major ordering of the (3, r, r)
+ * regular coefficient array followed by the r singular coefficients.
+ */
+  class cf2if_operator {
+
+    public:
+    /*!
+   * \brief Constructor
+   *
+   * \param[in] beta     Inverse temperature
+   * \param[in] dlr_rf   1D DLR real frequencies
+   * \param[in] dlr2d_if 2D DLR Matsubara frequency grid
+   */
+    cf2if_operator(double beta, nda::vector_const_view<double> dlr_rf, nda::array_const_view<int, 2> dlr2d_if);
+
+    /*!
+   * \brief Apply operator to 2D DLR coefficients
+   *
+   * \param[in] c Flattened 2D DLR coefficients
+   *
+   * \return Values of 2D DLR expansion on 2D DLR grid
+   */
+    nda::vector<dcomplex> apply(nda::vector_const_view<dcomplex> c) const;
+
+    /*!
+   * \brief Apply operator to 2D DLR regular and singular coefficients
+   *
+   * \param[in] gc_reg 2D DLR regular expansion coefficients
+   * \param[in] gc_sng 1D DLR singular expansion coefficients
+   *
+   * \return Values of 2D DLR expansion on 2D DLR grid
+   */
+    nda::vector<dcomplex> apply(nda::array_const_view<dcomplex, 3> gc_reg, nda::array_const_view<dcomplex, 1> gc_sng) const;
+
+    /*!
+   * \brief Apply adjoint of operator to values on 2D DLR grid
+   *
+   * \param[in] vals Values on 2D DLR grid
+   *
+   * \return Flattened vector in 2D DLR coefficient space
+   */
+    nda::vector<dcomplex> adjoint(nda::vector_const_view<dcomplex> vals) const;
+
+    /*!
+   * \brief Get Euclidean norms of columns of operator
+   *
+   * The squared norm of the column for coefficient (t, k, l) is beta^4 sum_n
+   * |ka(n, k)|^2 |kc(n, l)|^2, where ka and kc are the 1D kernel matrices of
+   * the two factors of term t, so the norms of all columns of a term are
+   * obtained from a single real matrix-matrix product.
+   *
+   * \return Column norms
+   */
+    nda::vector<double> colnorms() const;
+
+    /*!
+   * \brief Get 1D kernel matrices
+   *
+   * \return niom x r matrices of 1D fermionic kernels in first and second
+   * arguments, and 1D bosonic kernels in their sum, without factors of beta
+   */
+    std::tuple<fmatrix_const_view, fmatrix_const_view, fmatrix_const_view> get_kernels() const { return {kf1, kf2, kb}; }
+
+    /*!
+   * \brief Get indices of 2D DLR grid points on the anti-diagonal, at which the
+   * singular term is nonzero
+   *
+   * \return Indices of anti-diagonal grid points
+   */
+    nda::vector_const_view<int> get_sng() const { return sng; }
+
+    /*!
+   * \brief Get inverse temperature
+   *
+   * \return Inverse temperature
+   */
+    double get_beta() const { return beta; }
+
+    /*!
+   * \brief Get # basis functions in 1D DLR
+   *
+   * \return # basis functions in 1D DLR
+   */
+    int rank() const { return r; }
+
+    /*!
+   * \brief Get # rows of operator (# 2D DLR grid points)
+   *
+   * \return # rows
+   */
+    int nrows() const { return niom; }
+
+    /*!
+   * \brief Get # columns of operator (# 2D DLR basis functions)
+   *
+   * \return # columns
+   */
+    int ncols() const { return 3 * r * r + r; }
+
+    private:
+    double beta;          ///< Inverse temperature
+    int r;                ///< # basis functions in 1D DLR
+    int niom;             ///< # 2D DLR grid points
+    fmatrix kf1;          ///< Fermionic kernels in first argument
+    fmatrix kf2;          ///< Fermionic kernels in second argument
+    fmatrix kb;           ///< Bosonic kernels in sum of arguments
+    nda::vector<int> sng; ///< Indices of anti-diagonal grid points
+  };
+
+  /*!
+ * \brief Solve 2D DLR least squares problem by LSQR
+ *
+ * This function applies the LSQR algorithm (Paige and Saunders, ACM TOMS
+ * 1982) to the problem of minimizing ||A c - vals||, where A is given by a
+ * \ref cf2if_operator, using only products with A and its adjoint. The columns
+ * of A are scaled to unit norm (see \ref cf2if_operator::colnorms), which
+ * removes the large disparity in column norms between the 2D DLR basis
+ * functions. Starting from zero, LSQR converges to the minimum norm solution
+ * of the scaled problem.
+ *
+ * If an initial guess c0 is given, LSQR is applied to the residual b - A c0,
+ * and the correction is added to c0. If c0 is close to the solution, for
+ * example the coefficients from the previous step of a self-consistency loop,
+ * few iterations are needed.
+ *
+ * Iteration stops when ||A c - vals|| <= tol ||vals||, when ||A^H (A c -
+ * vals)|| <= tol ||A|| ||A c - vals||, with ||A|| estimated during the
+ * iteration, or after maxit iterations.
+ *
+ * \param[in] op    Coefficients to values operator
+ * \param[in] vals  Values of 2D DLR expansion on 2D DLR Mat. freq. grid
+ * \param[in] c0    Initial guess for flattened 2D DLR coefficients (empty for
+ * zero)
+ * \param[in] tol   Relative tolerance
+ * \param[in] maxit Maximum # iterations
+ *
+ * \return Flattened 2D DLR coefficients, and # iterations
+ */
+  std::tuple<nda::vector<dcomplex>, int> lsqr_cf2if(cf2if_operator const &op, nda::vector_const_view<dcomplex> vals, nda::vector_const_view<dcomplex> c0,
+                                                    double tol, int maxit);
+
+  /*!
+ * \brief Transform values of a 2D DLR expansion on the 2D DLR imaginary
+ * (Matsubara) frequency grid to its coefficients, iteratively
+ *
+ * This function differs from \ref vals2coefs_if in that the least squares
+ * problem is solved by \ref lsqr_cf2if, using a matrix-free \ref
+ * cf2if_operator in place of the matrix returned by \ref build_cf2if, and can
+ * be warm started from the coefficients of a nearby function.
+ *
+ * \param[in] op     Coefficients to values operator
+ * \param[in] vals   Values of 2D DLR expansion on 2D DLR Mat. freq. grid
+ * \param[in] tol    Relative tolerance
+ * \param[in] maxit  Maximum # iterations
+ * \param[in] gc_reg Initial guess for 2D DLR regular expansion coefficients
+ * (zero if not given)
+ * \param[in] gc_sng Initial guess for 1D DLR singular expansion coefficients
+ * (zero if not given)
+ *
+ * \return 2D DLR regular and singular expansion coefficients
+ */
+  std::tuple<nda::array<dcomplex, 3>, nda::array<dcomplex, 1>> vals2coefs_if_lsqr(cf2if_operator const &op, nda::vector_const_view<dcomplex> vals,
+                                                                                  double tol, int maxit);
+
+  std::tuple<nda::array<dcomplex, 3>, nda::array<dcomplex, 1>> vals2coefs_if_lsqr(cf2if_operator const &op, nda::vector_const_view<dcomplex> vals,
+                                                                                  double tol, int maxit, nda::array_const_view<dcomplex, 3> gc_reg,
+                                                                                  nda::array_const_view<dcomplex, 1> gc_sng);
+
+} // namespace dlr2d
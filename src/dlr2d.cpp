@@ -1,101 +1,266 @@
 #include "dlr2d.hpp"
+#include "cf2if_operator.hpp"
 #include "utils.hpp"
 
+#include <array>
 #include <fmt/format.h>
 #include <numbers>
+#include <set>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace dlr2d {
 
   using namespace cppdlr;
   using std::numbers::pi;
 
-  // Obtain 2D DLR nodes
+  // Statistics of nu1 + nu2 for given statistics of nu1 and nu2
+  static statistic_t sum_statistic(statistic_t stat1, statistic_t stat2) { return (stat1 == stat2) ? Boson : Fermion; }
 
-  nda::array<int, 2> build_dlr2d_if_fullgrid(double lambda, int niom_dense, double eps) {
+  // Offset of index of nu1 + nu2 from sum of indices of nu1 and nu2
+  static int sum_offset(statistic_t stat1, statistic_t stat2) { return (stat1 == Fermion && stat2 == Fermion) ? 1 : 0; }
 
-    // Get DLR frequencies
-    auto dlr_rf = build_dlr_rf(lambda, eps);
-    int r       = dlr_rf.size(); // # DLR basis functions
+  // Singular terms present in 2D DLR with given statistics (see build_cf2if)
+  static std::vector<int> sng_terms(statistic_t stat1, statistic_t stat2) {
+    auto terms = std::vector<int>();
+    if (sum_statistic(stat1, stat2) == Boson) terms.push_back(0);
+    if (stat1 == Boson) terms.push_back(1);
+    if (stat2 == Boson) terms.push_back(2);
+    return terms;
+  }
 
-    fmt::print("\nDLR cutoff Lambda = {}\n", lambda);
-    fmt::print("DLR tolerance epsilon = {}\n", eps);
-    fmt::print("# DLR basis functions = {}\n", r);
+  // Whether singular term s of 2D DLR is supported at index pair (m, n)
+  static bool on_sng(int s, int m, int n, int off) {
+    switch (s) {
+      case 0: return m + n + off == 0;
+      case 1: return m == 0;
+      default: return n == 0;
+    }
+  }
+
+  // 1D kernel of given statistics. Bosonic kernels are k_if_boson if kbos_alt
+  // is true, and k_if(..., Boson) otherwise.
+  static dcomplex k1d_if(int n, double om, statistic_t stat, bool kbos_alt) {
+    return (stat == Boson && kbos_alt) ? k_if_boson(n, om) : k_if(n, om, stat);
+  }
 
-    // Get dense Matsubara frequency sampling grid
-    auto nu_dense = nda::vector<dcomplex>(niom_dense);
-    for (int n = -niom_dense / 2; n < niom_dense / 2; ++n) { nu_dense(n + niom_dense / 2) = (2 * n + 1) * pi * 1i; }
+  std::array<fmatrix, 3> build_k1d_if(nda::vector_const_view<double> dlr_rf, nda::array_const_view<int, 2> idx, bool kbos_alt, statistic_t stat1,
+                                      statistic_t stat2) {
+
+    int r      = dlr_rf.size();
+    int niom   = idx.shape(0);
+    int off    = sum_offset(stat1, stat2);
+    auto stat3 = sum_statistic(stat1, stat2);
+
+    auto k1d = std::array<fmatrix, 3>{fmatrix(niom, r), fmatrix(niom, r), fmatrix(niom, r)};
+#pragma omp parallel for schedule(static) num_threads(get_num_threads())
+    for (int n = 0; n < niom; ++n) {
+      int n3 = idx(n, 0) + idx(n, 1) + off;
+      for (int k = 0; k < r; ++k) {
+        k1d[0](n, k) = k1d_if(idx(n, 0), dlr_rf(k), stat1, kbos_alt);
+        k1d[1](n, k) = k1d_if(idx(n, 1), dlr_rf(k), stat2, kbos_alt);
+        k1d[2](n, k) = k1d_if(n3, dlr_rf(k), stat3, kbos_alt);
+      }
+    }
 
-    // Get system matrix for dense grid
-    auto kmat                = fmatrix(niom_dense * niom_dense, 3 * r * r + r);
-    std::complex<double> nu1 = 0, nu2 = 0;
+    return k1d;
+  }
+
+  // Columns (t, k, l) of 2D DLR kernel matrix containing terms t0,...,2 of the
+  // regular part followed by the singular terms sng (t = 3, l the singular
+  // term), in the order of build_cf2if
+  static nda::array<int, 2> kmat_cols(int r, int t0, std::vector<int> const &sng = {0}) {
+
+    int nreg  = (3 - t0) * r * r;
+    int nsng  = sng.size();
+    auto cols = nda::array<int, 2>(nreg + nsng * r, 3);
+    for (int i = 0; i < nreg; ++i) {
+      cols(i, 0) = t0 + i / (r * r);
+      cols(i, 1) = (i / r) % r;
+      cols(i, 2) = i % r;
+    }
+    for (int i = 0; i < nsng; ++i) {
+      for (int k = 0; k < r; ++k) {
+        cols(nreg + i * r + k, 0) = 3;
+        cols(nreg + i * r + k, 1) = k;
+        cols(nreg + i * r + k, 2) = sng[i];
+      }
+    }
+
+    return cols;
+  }
+
+  // Entry of 2D DLR kernel matrix in column (t, k, l) (see kmat_cols) at the
+  // index pair (m, n) in row n of the 1D kernels k1, k2, k12 returned by
+  // build_k1d_if, where off is the index offset of nu1 + nu2
+  static dcomplex kmat_entry(int t, int k, int l, int m, int n, int off, int row, fmatrix const &k1, fmatrix const &k2, fmatrix const &k12) {
+    switch (t) {
+      case 0: return k1(row, k) * k2(row, l);
+      case 1: return k2(row, k) * k12(row, l);
+      case 2: return k1(row, k) * k12(row, l);
+      default: return on_sng(l, m, n, off) ? (l == 1 ? k2(row, k) : k1(row, k)) : dcomplex(0);
+    }
+  }
+
+  // Assemble 2D DLR kernel matrix at Matsubara frequency index pairs idx, with
+  // columns given by cols (see kmat_cols), from the 1D kernels k1d returned by
+  // build_k1d_if, times scale; off is the index offset of nu1 + nu2 (see
+  // sum_offset). The columns are distributed over threads in static
+  // contiguous blocks, and the matrix is allocated without initialization, so
+  // each block is first touched, and its memory pages placed, by the thread
+  // which fills it.
+  static fmatrix assemble_kmat(nda::array_const_view<int, 2> idx, nda::array_const_view<int, 2> cols, std::array<fmatrix, 3> const &k1d,
+                               double scale, int off = 1) {
+
+    int niom  = idx.shape(0);
+    int ncol  = cols.shape(0);
+    auto &k1  = k1d[0];
+    auto &k2  = k1d[1];
+    auto &k12 = k1d[2];
+
+    // Factors of regular term t = 0, 1, 2 in first and second DLR frequency
+    auto ka = std::array<fmatrix const *, 3>{&k1, &k2, &k1};
+    auto kc = std::array<fmatrix const *, 3>{&k2, &k12, &k12};
+
+    auto kmat = fmatrix(niom, ncol);
+#pragma omp parallel for schedule(static) num_threads(get_num_threads())
+    for (int i = 0; i < ncol; ++i) {
+      int t = cols(i, 0);
+      int k = cols(i, 1);
+      int l = cols(i, 2);
+      if (t < 3) {
+        for (int n = 0; n < niom; ++n) { kmat(n, i) = scale * (*ka[t])(n, k) * (*kc[t])(n, l); }
+      } else {
+        for (int n = 0; n < niom; ++n) { kmat(n, i) = scale * kmat_entry(t, k, l, idx(n, 0), idx(n, 1), off, n, k1, k2, k12); }
+      }
+    }
+
+    return kmat;
+  }
+
+  // Transpose of the matrix assembled by assemble_kmat, with one column per
+  // index pair, as used by pivoted QR for node selection. It is assembled
+  // directly rather than copied from assemble_kmat, with the columns
+  // distributed over threads in static contiguous blocks and first touched by
+  // the thread which fills them.
+  static fmatrix assemble_kmatt(nda::array_const_view<int, 2> idx, nda::array_const_view<int, 2> cols, std::array<fmatrix, 3> const &k1d,
+                                double scale, int off = 1) {
+
+    int niom = idx.shape(0);
+    int nrow = cols.shape(0);
+
+    auto kmatt = fmatrix(nrow, niom);
+#pragma omp parallel for schedule(static) num_threads(get_num_threads())
+    for (int n = 0; n < niom; ++n) {
+      for (int i = 0; i < nrow; ++i) {
+        kmatt(i, n) = scale * kmat_entry(cols(i, 0), cols(i, 1), cols(i, 2), idx(n, 0), idx(n, 1), off, n, k1d[0], k1d[1], k1d[2]);
+      }
+    }
+
+    return kmatt;
+  }
+
+  // Columns of transposed 2D DLR system matrix at Matsubara frequency index
+  // pairs idx, multiplied from the left by the sketching matrix omega (see
+  // build_k2d_if_t). The sketch is applied to one block of r rows (fixed term
+  // and first DLR frequency) at a time, as it is generated, so that the full
+  // (3r^2 + r) x niom block is never formed. If omega is empty, the unsketched
+  // columns are returned.
+  static fmatrix build_k2d_if_t_sketch(nda::vector_const_view<double> dlr_rf, nda::array_const_view<int, 2> idx, fmatrix_const_view omega) {
+
+    if (omega.shape(0) == 0) { return build_k2d_if_t(dlr_rf, idx); }
+
+    int r     = dlr_rf.size();
+    int niom  = idx.shape(0);
+    auto k1d  = build_k1d_if(dlr_rf, idx, false);
+    auto &kf1 = k1d[0];
+    auto &kf2 = k1d[1];
+    auto &kb  = k1d[2];
+
+    // Factors of term t = 0, 1, 2 in first and second DLR frequency
+    auto ka = std::array<fmatrix const *, 3>{&kf1, &kf2, &kf1};
+    auto kc = std::array<fmatrix const *, 3>{&kf2, &kb, &kb};
+
+    auto res = fmatrix(omega.shape(0), niom);
+    auto blk = fmatrix(r, niom);
+    res      = 0;
 
     // Regular part
-    for (int k = 0; k < r; ++k) {
-      for (int l = 0; l < r; ++l) {
-        for (int n = 0; n < niom_dense; ++n) {
-          for (int m = 0; m < niom_dense; ++m) {
-            kmat(n * niom_dense + m, k * r + l)             = ker(nu_dense(m), dlr_rf(k)) * ker(nu_dense(n), dlr_rf(l));
-            kmat(n * niom_dense + m, r * r + k * r + l)     = ker(nu_dense(n), dlr_rf(k)) * ker(nu_dense(m) + nu_dense(n), dlr_rf(l));
-            kmat(n * niom_dense + m, 2 * r * r + k * r + l) = ker(nu_dense(m), dlr_rf(k)) * ker(nu_dense(m) + nu_dense(n), dlr_rf(l));
-          }
+    for (int t = 0; t < 3; ++t) {
+      for (int k = 0; k < r; ++k) {
+#pragma omp parallel for schedule(static) num_threads(get_num_threads())
+        for (int n = 0; n < niom; ++n) {
+          for (int l = 0; l < r; ++l) { blk(l, n) = (*ka[t])(n, k) * (*kc[t])(n, l); }
         }
+        res += omega(_, nda::range(t * r * r + k * r, t * r * r + (k + 1) * r)) * blk;
       }
     }
 
     // Singular part
-    for (int k = 0; k < r; ++k) {
-      for (int n = 0; n < niom_dense; ++n) {
-        for (int m = 0; m < niom_dense; ++m) {
-          if (m == -n - 1) {
-            kmat(n * niom_dense + m, 3 * r * r + k) = ker(nu_dense(m), dlr_rf(k));
-          } else {
-            kmat(n * niom_dense + m, 3 * r * r + k) = 0;
-          }
-        }
-      }
+#pragma omp parallel for schedule(static) num_threads(get_num_threads())
+    for (int n = 0; n < niom; ++n) {
+      bool sng = (idx(n, 0) == -idx(n, 1) - 1);
+      for (int k = 0; k < r; ++k) { blk(k, n) = sng ? kf1(n, k) : dcomplex(0); }
     }
+    res += omega(_, nda::range(3 * r * r, 3 * r * r + r)) * blk;
 
-    // // Pivoted QR to determine sampling nodes
-    // fmt::print("Pivoted QR to determine skeleton nodes...\n");
-    // auto start = std::chrono::high_resolution_clock::now();
-    // auto [q, nrm, piv] = pivrgs(kmat, eps);
-    // int niom_skel = piv.size();
-    // auto end = std::chrono::high_resolution_clock::now();
-    // fmt::print("time = {}\n", std::chrono::duration<double>(end -
-    // start).count());
+    return res;
+  }
 
-    // Pivoted QR to determine sampling nodes
-    auto kmatt = fmatrix(transpose(kmat));
-    auto start = std::chrono::high_resolution_clock::now();
-    auto piv   = nda::zeros<int>(niom_dense * niom_dense);
-    auto tau   = nda::vector<dcomplex>(3 * r * r + r);
-    nda::lapack::geqp3(kmatt, piv, tau);
+  // Obtain 2D DLR nodes
 
-    // Estimate rank
-    int niom_skel = 0;
-    for (int k = 0; k < 3 * r * r + r; ++k) {
-      if (abs(kmatt(k, k)) < eps) {
-        niom_skel = k;
-        break;
+  nda::array<int, 2> build_dlr2d_if_fullgrid(double lambda, int niom_dense, double eps, int tilesize, int nsketch, rankmethod_t rankmethod) {
+
+    // Get DLR frequencies
+    auto dlr_rf = build_dlr_rf(lambda, eps);
+    int r       = dlr_rf.size(); // # DLR basis functions
+    int ncoef   = 3 * r * r + r; // # 2D DLR basis functions
+
+    fmt::print("\nDLR cutoff Lambda = {}\n", lambda);
+    fmt::print("DLR tolerance epsilon = {}\n", eps);
+    fmt::print("# DLR basis functions = {}\n", r);
+
+    // Fine grid is the full niom_dense x niom_dense box of Matsubara frequency
+    // index pairs, with linear index n * niom_dense + m for the pair
+    // (m - niom_dense/2, n - niom_dense/2); it is never stored
+    int nfine = niom_dense * niom_dense;
+
+    // Columns of (sketched) transposed system matrix, regenerated on demand
+    auto getcols = [&](nda::vector_const_view<int> cols, fmatrix_const_view omega) {
+      auto idx = nda::array<int, 2>(cols.size(), 2);
+      for (int j = 0; j < cols.size(); ++j) {
+        auto [m, n] = ind2sub(cols(j), niom_dense);
+        idx(j, 0)   = m - niom_dense / 2;
+        idx(j, 1)   = n - niom_dense / 2;
       }
-    }
+      return build_k2d_if_t_sketch(dlr_rf, idx, omega);
+    };
+
+    auto start    = std::chrono::high_resolution_clock::now();
+    auto skel     = streaming_pivot_sketch(ncoef, nfine, getcols, eps, tilesize, nsketch, rankmethod);
+    auto end      = std::chrono::high_resolution_clock::now();
+    int niom_skel = skel.size();
 
     // Extract skeleton nodes from pivots
     auto dlr2d_if = nda::array<int, 2>(niom_skel, 2);
     for (int k = 0; k < niom_skel; ++k) {
-      auto [n1, n2]  = ind2sub(piv(k), niom_dense);
+      auto [n1, n2]  = ind2sub(skel(k), niom_dense);
       dlr2d_if(k, 0) = n1 - niom_dense / 2;
       dlr2d_if(k, 1) = n2 - niom_dense / 2;
     }
 
     fmt::print("DLR rank squared = {}\n", r * r);
-    fmt::print("System matrix rank = {}\n\n", niom_skel);
+    fmt::print("System matrix rank = {}\n", niom_skel);
+    fmt::print("Streaming pivoting ({}) time = {}\n\n", rankmethod_name(rankmethod), std::chrono::duration<double>(end - start).count());
 
     return dlr2d_if;
   }
 
-  void build_dlr2d_if_fullgrid(double lambda, int niom_dense, double eps, std::string path, std::string filename) {
-    auto dlr2d_if = build_dlr2d_if_fullgrid(lambda, niom_dense, eps);
+  void build_dlr2d_if_fullgrid(double lambda, int niom_dense, double eps, std::string path, std::string filename, int tilesize, int nsketch,
+                               rankmethod_t rankmethod) {
+    auto dlr2d_if = build_dlr2d_if_fullgrid(lambda, niom_dense, eps, tilesize, nsketch, rankmethod);
 
     // Write dlr2d_if to hdf5 file
     h5::file file(path + filename, 'w');
@@ -110,6 +275,14 @@ namespace dlr2d {
     return dlr2d_if;
   }
 
+  std::tuple<nda::array<int, 2>, nda::array<int, 2>> read_dlr2d_if_val(std::string path, std::string filename) {
+    h5::file file(path + filename, 'r');
+    h5::group mygroup(file);
+    auto dlr2d_if     = h5::read<nda::array<int, 2>>(mygroup, "dlr2d_if");
+    auto dlr2d_if_val = h5::read<nda::array<int, 2>>(mygroup, "dlr2d_if_val");
+    return {dlr2d_if, dlr2d_if_val};
+  }
+
   std::tuple<nda::array<int, 2>, nda::array<int, 2>> read_dlr2d_rfif(std::string path, std::string filename) {
     h5::file file(path + filename, 'r');
     h5::group mygroup(file);
@@ -118,9 +291,7 @@ namespace dlr2d {
     return {dlr2d_rfidx, dlr2d_if};
   }
 
-  nda::array<int, 2> build_dlr2d_if(double lambda, double eps) {
-
-    int rankmethod = 1;
+  nda::array<int, 2> build_dlr2d_if(double lambda, double eps, rankmethod_t rankmethod, statistic_t stat1, statistic_t stat2) {
 
     // Get DLR frequencies
     auto dlr_rf = build_dlr_rf(lambda, eps);
@@ -129,118 +300,143 @@ namespace dlr2d {
     fmt::print("\nDLR cutoff Lambda = {}\n", lambda);
     fmt::print("DLR tolerance epsilon = {}\n", eps);
     fmt::print("# DLR basis functions = {}\n", r);
-
-    // Get fermionic and bosonic DLR grids
-    auto ifops_fer  = imfreq_ops(lambda, dlr_rf, Fermion);
-    auto ifops_bos  = imfreq_ops(lambda, dlr_rf, Boson);
-    auto dlr_if_fer = ifops_fer.get_ifnodes();
-    auto dlr_if_bos = ifops_bos.get_ifnodes();
+    if (stat1 != Fermion || stat2 != Fermion) {
+      fmt::print("Statistics = ({}, {})\n", stat1 == Fermion ? "Fermion" : "Boson", stat2 == Fermion ? "Fermion" : "Boson");
+    }
 
     // Get fine 2D Matsubara frequency sampling grid
+    auto nu2didx = build_dlr2d_if_fine(lambda, dlr_rf, stat1, stat2);
+    int nfine    = nu2didx.shape(0);
+
+    // Get transposed system matrix for dense grid
+    auto kmatt = build_k2d_if_t(dlr_rf, nu2didx, stat1, stat2);
+
+    // Pivoted QR to determine sampling nodes
+    auto start = std::chrono::high_resolution_clock::now();
+    auto piv   = nda::zeros<int>(nfine);
+    auto tau   = nda::vector<dcomplex>(nfine);
+    blas_thread_scope blas;
+    nda::lapack::geqp3(kmatt, piv, tau);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    // Estimate rank
+    auto start_rank = std::chrono::high_resolution_clock::now();
+    int niom_skel   = qr_rank(kmatt, eps, rankmethod);
+    auto end_rank   = std::chrono::high_resolution_clock::now();
+
+    // Extract skeleton nodes from pivots
+    auto dlr2d_if = nda::array<int, 2>(niom_skel, 2);
+    for (int k = 0; k < niom_skel; ++k) {
+      dlr2d_if(k, 0) = nu2didx(piv(k), 0);
+      dlr2d_if(k, 1) = nu2didx(piv(k), 1);
+    }
+
+    fmt::print("DLR rank squared = {}\n", r * r);
+    fmt::print("System matrix rank = {}\n", niom_skel);
+    fmt::print("Pivoted QR time = {}\n", std::chrono::duration<double>(end - start).count());
+    fmt::print("Rank estimation ({}) time = {}\n\n", rankmethod_name(rankmethod), std::chrono::duration<double>(end_rank - start_rank).count());
+
+    return dlr2d_if;
+  }
+
+  void build_dlr2d_if(double lambda, double eps, std::string path, std::string filename, rankmethod_t rankmethod, statistic_t stat1,
+                      statistic_t stat2) {
+    auto dlr2d_if = build_dlr2d_if(lambda, eps, rankmethod, stat1, stat2);
+
+    // Write dlr2d_if to hdf5 file
+    h5::file file(path + filename, 'w');
+    h5::group mygroup(file);
+    h5::write(mygroup, "dlr2d_if", dlr2d_if);
+  }
+
+  nda::array<int, 2> build_dlr2d_if_fine(double lambda, nda::vector_const_view<double> dlr_rf, statistic_t stat1, statistic_t stat2) {
+
+    int r = dlr_rf.size(); // # DLR basis functions
+
+    // Get 1D DLR grids of the statistics of nu1, nu2 and nu1 + nu2
+    int off      = sum_offset(stat1, stat2);
+    auto ifops1  = imfreq_ops(lambda, dlr_rf, stat1);
+    auto ifops2  = imfreq_ops(lambda, dlr_rf, stat2);
+    auto ifops3  = imfreq_ops(lambda, dlr_rf, sum_statistic(stat1, stat2));
+    auto dlr_if1 = ifops1.get_ifnodes();
+    auto dlr_if2 = ifops2.get_ifnodes();
+    auto dlr_if3 = ifops3.get_ifnodes();
+
+    // Get fine 2D Matsubara frequency sampling grid: nu1 and nu2, nu2 and
+    // nu1 + nu2, and nu1 and nu1 + nu2 on 1D DLR grids, respectively. For
+    // fermionic nu1 and nu2, e.g., the second block is
+    // nu1 = 2*n_k*i*pi - (2*m_j+1)*i*pi = (2*(n_k-m_j-1)+1)*i*pi, nu2 = (2*m_j + 1)*i*pi
     auto nu2didx = nda::array<int, 2>(3 * r * r, 2);
     for (int m = 0; m < r; ++m) {
       for (int n = 0; n < r; ++n) {
-        nu2didx(m * r + n, 0) = dlr_if_fer(m); // nu1 = (2*m_j + 1)*i*pi
-        nu2didx(m * r + n, 1) = dlr_if_fer(n); // nu2 = (2*n_j + 1)*i*pi
+        nu2didx(m * r + n, 0) = dlr_if1(m);
+        nu2didx(m * r + n, 1) = dlr_if2(n);
 
-        nu2didx(r * r + m * r + n, 0) = dlr_if_bos(n) - dlr_if_fer(m) - 1; // nu1 = 2*n_k*i*pi - (2*m_j+1)*i*pi = (2*(n_k-m_j-1)+1)*i*pi
-        nu2didx(r * r + m * r + n, 1) = dlr_if_fer(m);                     // nu2 = (2*m_j + 1)*i*pi
+        nu2didx(r * r + m * r + n, 0) = dlr_if3(n) - dlr_if2(m) - off;
+        nu2didx(r * r + m * r + n, 1) = dlr_if2(m);
 
-        nu2didx(2 * r * r + m * r + n, 0) = dlr_if_fer(m);                     // nu1 = (2*m_j + 1)*i*pi
-        nu2didx(2 * r * r + m * r + n, 1) = dlr_if_bos(n) - dlr_if_fer(m) - 1; // nu2 = 2*n_k*i*pi - (2*m_j+1)*i*pi = (2*(n_k-m_j-1)+1)*i*pi
+        nu2didx(2 * r * r + m * r + n, 0) = dlr_if1(m);
+        nu2didx(2 * r * r + m * r + n, 1) = dlr_if3(n) - dlr_if1(m) - off;
       }
     }
 
-    auto nu2d = (2 * nu2didx + 1) * pi * 1i;
+    return nu2didx;
+  }
 
-    // Get system matrix for dense grid
-    auto kmat = fmatrix(3 * r * r, 3 * r * r + r);
+  fmatrix build_k2d_if_t(nda::vector_const_view<double> dlr_rf, nda::array_const_view<int, 2> nu2didx, statistic_t stat1, statistic_t stat2) {
+    int r = dlr_rf.size();
+    return assemble_kmatt(nu2didx, kmat_cols(r, 0, sng_terms(stat1, stat2)), build_k1d_if(dlr_rf, nu2didx, false, stat1, stat2), 1.0,
+                          sum_offset(stat1, stat2));
+  }
 
-    // Regular part
-    for (int k = 0; k < r; ++k) {
-      for (int l = 0; l < r; ++l) {
-        for (int n = 0; n < 3 * r * r; ++n) {
-
-          kmat(n, k * r + l) = k_if(nu2didx(n, 0), dlr_rf(k), Fermion) * k_if(nu2didx(n, 1), dlr_rf(l), Fermion);
-          // kmat(n, r * r + k * r + l) =
-          //     k_if(nu2didx(n, 1), dlr_rf(k), Fermion) *
-          //     my_k_if_boson(nu2didx(n, 0) + nu2didx(n, 1) + 1, dlr_rf(l));
-          // kmat(n, 2 * r * r + k * r + l) =
-          //     k_if(nu2didx(n, 0), dlr_rf(k), Fermion) *
-          //     my_k_if_boson(nu2didx(n, 0) + nu2didx(n, 1) + 1, dlr_rf(l));
-          kmat(n, r * r + k * r + l)     = k_if(nu2didx(n, 1), dlr_rf(k), Fermion) * k_if(nu2didx(n, 0) + nu2didx(n, 1) + 1, dlr_rf(l), Boson);
-          kmat(n, 2 * r * r + k * r + l) = k_if(nu2didx(n, 0), dlr_rf(k), Fermion) * k_if(nu2didx(n, 0) + nu2didx(n, 1) + 1, dlr_rf(l), Boson);
-
-          // kmat(n, k * r + l) =
-          //     ker(nu2d(n, 0), dlr_rf(k)) * ker(nu2d(n, 1), dlr_rf(l));
-          // kmat(n, r * r + k * r + l) = ker(nu2d(n, 1), dlr_rf(k)) *
-          //                              ker(nu2d(n, 0) + nu2d(n, 1), dlr_rf(l));
-          // kmat(n, 2 * r * r + k * r + l) =
-          //     ker(nu2d(n, 0), dlr_rf(k)) *
-          //     ker(nu2d(n, 0) + nu2d(n, 1), dlr_rf(l));
-        }
-      }
-    }
+  fmatrix build_k2d_if_t(nda::vector_const_view<double> dlr_rf, nda::array_const_view<int, 2> nu2didx, nda::array_const_view<int, 2> dlr2d_rfidx) {
+    return assemble_kmatt(nu2didx, dlr2d_rfidx, build_k1d_if(dlr_rf, nu2didx, false), 1.0);
+  }
 
-    // Singular part
-    for (int k = 0; k < r; ++k) {
-      for (int n = 0; n < 3 * r * r; ++n) {
-        if (nu2didx(n, 0) == -nu2didx(n, 1) - 1) {
-          kmat(n, 3 * r * r + k) = k_if(nu2didx(n, 0), dlr_rf(k), Fermion);
-        } else {
-          kmat(n, 3 * r * r + k) = 0;
-        }
-        // if (nu2d(n, 0) == -nu2d(n, 1)) {
-        //   kmat(n, 3 * r * r + k) = ker(nu2d(n, 0), dlr_rf(k));
-        // } else {
-        //   kmat(n, 3 * r * r + k) = 0;
-        // }
-      }
-    }
+  nda::array<int, 2> build_dlr2d_if_tournament(double lambda, double eps, int nchunk, rankmethod_t rankmethod) {
 
-    // Pivoted QR to determine sampling nodes
-    auto kmatt = fmatrix(transpose(kmat));
-    auto start = std::chrono::high_resolution_clock::now();
-    auto piv   = nda::zeros<int>(3 * r * r);
-    auto tau   = nda::vector<dcomplex>(3 * r * r);
-    nda::lapack::geqp3(kmatt, piv, tau);
+    // Get DLR frequencies
+    auto dlr_rf = build_dlr_rf(lambda, eps);
+    int r       = dlr_rf.size(); // # DLR basis functions
 
-    // Estimate rank
-    int niom_skel = 0;
-    if (rankmethod == 1) {
-      for (int k = 0; k < 3 * r * r; ++k) {
-        if (abs(kmatt(k, k)) < eps) {
-          niom_skel = k;
-          break;
-        }
-      }
-    } else {
-      double errsq = 0;
-      for (int k = 3 * r * r - 1; k >= 0; --k) {
-        errsq += pow(abs(kmatt(k, k)), 2);
-        if (sqrt(errsq) > eps) {
-          niom_skel = k;
-          break;
-        }
-      }
-    }
-    // int niom_skel = estimate_rank(kmatt, eps, 2.0, 100);
+    fmt::print("\nDLR cutoff Lambda = {}\n", lambda);
+    fmt::print("DLR tolerance epsilon = {}\n", eps);
+    fmt::print("# DLR basis functions = {}\n", r);
 
-    // Extract skeleton nodes from pivots
+    // Get fine 2D Matsubara frequency sampling grid
+    auto nu2didx = build_dlr2d_if_fine(lambda, dlr_rf);
+    int nfine    = nu2didx.shape(0);
+
+    // Columns of transposed system matrix, generated on demand
+    auto getcols = [&](nda::vector_const_view<int> cols) {
+      auto idx = nda::array<int, 2>(cols.size(), 2);
+      for (int j = 0; j < cols.size(); ++j) { idx(j, _) = nu2didx(cols(j), _); }
+      return build_k2d_if_t(dlr_rf, idx);
+    };
+
+    // Tournament pivoting to determine sampling nodes
+    auto start    = std::chrono::high_resolution_clock::now();
+    auto skel     = tournament_pivot(nfine, getcols, eps, nchunk, rankmethod);
+    auto end      = std::chrono::high_resolution_clock::now();
+    int niom_skel = skel.size();
+
+    // Extract skeleton nodes
     auto dlr2d_if = nda::array<int, 2>(niom_skel, 2);
     for (int k = 0; k < niom_skel; ++k) {
-      dlr2d_if(k, 0) = nu2didx(piv(k), 0);
-      dlr2d_if(k, 1) = nu2didx(piv(k), 1);
+      dlr2d_if(k, 0) = nu2didx(skel(k), 0);
+      dlr2d_if(k, 1) = nu2didx(skel(k), 1);
     }
 
     fmt::print("DLR rank squared = {}\n", r * r);
-    fmt::print("System matrix rank = {}\n\n", niom_skel);
+    fmt::print("System matrix rank = {}\n", niom_skel);
+    fmt::print("Tournament pivoting ({}, {} chunks) time = {}\n\n", rankmethod_name(rankmethod), nchunk,
+               std::chrono::duration<double>(end - start).count());
 
     return dlr2d_if;
   }
 
-  void build_dlr2d_if(double lambda, double eps, std::string path, std::string filename) {
-    auto dlr2d_if = build_dlr2d_if(lambda, eps);
+  void build_dlr2d_if_tournament(double lambda, double eps, int nchunk, std::string path, std::string filename, rankmethod_t rankmethod) {
+    auto dlr2d_if = build_dlr2d_if_tournament(lambda, eps, nchunk, rankmethod);
 
     // Write dlr2d_if to hdf5 file
     h5::file file(path + filename, 'w');
@@ -248,11 +444,7 @@ namespace dlr2d {
     h5::write(mygroup, "dlr2d_if", dlr2d_if);
   }
 
-  // Obtain 2D DLR nodes using reduced fine grid, mixed fermionic/bosonic
-  // representation, two terms
-  nda::array<int, 2> build_dlr2d_if_3term(double lambda, double eps) {
-
-    int rankmethod = 1;
+  std::tuple<nda::array<int, 2>, nda::vector<double>> build_dlr2d_if_profile(double lambda, double eps, rankmethod_t rankmethod) {
 
     // Get DLR frequencies
     auto dlr_rf = build_dlr_rf(lambda, eps);
@@ -262,116 +454,231 @@ namespace dlr2d {
     fmt::print("DLR tolerance epsilon = {}\n", eps);
     fmt::print("# DLR basis functions = {}\n", r);
 
-    // Get fermionic and bosonic DLR grids
-    auto ifops_fer  = imfreq_ops(lambda, dlr_rf, Fermion);
-    auto ifops_bos  = imfreq_ops(lambda, dlr_rf, Boson);
-    auto dlr_if_fer = ifops_fer.get_ifnodes();
-    auto dlr_if_bos = ifops_bos.get_ifnodes();
+    // Get fine 2D Matsubara frequency sampling grid and transposed system matrix
+    auto nu2didx = build_dlr2d_if_fine(lambda, dlr_rf);
+    auto kmatt   = build_k2d_if_t(dlr_rf, nu2didx);
+    int m        = kmatt.shape(0);
+    int nfine    = kmatt.shape(1);
 
-    // Get fine 2D Matsubara frequency sampling grid
-    auto nu2didx = nda::array<int, 2>(2 * r * r, 2);
-    for (int m = 0; m < r; ++m) {
-      for (int n = 0; n < r; ++n) {
+    // Pivoted QR
+    auto piv = nda::zeros<int>(nfine);
+    auto tau = nda::vector<dcomplex>(std::min(m, nfine));
+    blas_thread_scope blas;
+    nda::lapack::geqp3(kmatt, piv, tau);
+
+    // Fine grid nodes in pivot order, and rank profile
+    auto nodes = nda::array<int, 2>(nfine, 2);
+    for (int k = 0; k < nfine; ++k) { nodes(k, _) = nu2didx(piv(k), _); }
+    auto rprof = qr_profile(kmatt, rankmethod);
+
+    return {nodes, rprof};
+  }
 
-        nu2didx(m * r + n, 0) = dlr_if_bos(n) - dlr_if_fer(m) - 1; // nu1 = 2*n_k*i*pi - (2*m_j+1)*i*pi = (2*(n_k-m_j-1)+1)*i*pi
-        nu2didx(m * r + n, 1) = dlr_if_fer(m);                     // nu2 = (2*m_j + 1)*i*pi
+  nda::array<int, 2> truncate_dlr2d_if(nda::array_const_view<int, 2> nodes, nda::vector_const_view<double> rprof, double eps) {
 
-        nu2didx(r * r + m * r + n, 0) = dlr_if_fer(m);                     // nu1 = (2*m_j + 1)*i*pi
-        nu2didx(r * r + m * r + n, 1) = dlr_if_bos(n) - dlr_if_fer(m) - 1; // nu2 = 2*n_k*i*pi - (2*m_j+1)*i*pi = (2*(n_k-m_j-1)+1)*i*pi
+    int niom_skel = rprof.size();
+    for (int k = 0; k < rprof.size(); ++k) {
+      if (rprof(k) < eps) {
+        niom_skel = k;
+        break;
       }
     }
 
-    auto nu2d = (2 * nu2didx + 1) * pi * 1i;
+    return nda::array<int, 2>(nodes(nda::range(niom_skel), _));
+  }
 
-    // Get system matrix for dense grid
-    auto kmat = fmatrix(2 * r * r, 2 * r * r + r);
+  std::vector<nda::array<int, 2>> build_dlr2d_if_multieps(double lambda, nda::vector_const_view<double> epss, rankmethod_t rankmethod) {
 
-    // Regular part
-    for (int k = 0; k < r; ++k) {
-      for (int l = 0; l < r; ++l) {
-        for (int n = 0; n < 2 * r * r; ++n) {
-
-          // kmat(n, r * r + k * r + l) =
-          //     k_if(nu2didx(n, 1), dlr_rf(k), Fermion) *
-          //     my_k_if_boson(nu2didx(n, 0) + nu2didx(n, 1) + 1, dlr_rf(l));
-          // kmat(n, 2 * r * r + k * r + l) =
-          //     k_if(nu2didx(n, 0), dlr_rf(k), Fermion) *
-          //     my_k_if_boson(nu2didx(n, 0) + nu2didx(n, 1) + 1, dlr_rf(l));
-          kmat(n, k * r + l)         = k_if(nu2didx(n, 1), dlr_rf(k), Fermion) * k_if(nu2didx(n, 0) + nu2didx(n, 1) + 1, dlr_rf(l), Boson);
-          kmat(n, r * r + k * r + l) = k_if(nu2didx(n, 0), dlr_rf(k), Fermion) * k_if(nu2didx(n, 0) + nu2didx(n, 1) + 1, dlr_rf(l), Boson);
-
-          // kmat(n, k * r + l) =
-          //     ker(nu2d(n, 0), dlr_rf(k)) * ker(nu2d(n, 1), dlr_rf(l));
-          // kmat(n, r * r + k * r + l) = ker(nu2d(n, 1), dlr_rf(k)) *
-          //                              ker(nu2d(n, 0) + nu2d(n, 1), dlr_rf(l));
-          // kmat(n, 2 * r * r + k * r + l) =
-          //     ker(nu2d(n, 0), dlr_rf(k)) *
-          //     ker(nu2d(n, 0) + nu2d(n, 1), dlr_rf(l));
-        }
-      }
+    auto [nodes, rprof] = build_dlr2d_if_profile(lambda, min_element(epss), rankmethod);
+
+    auto dlr2d_ifs = std::vector<nda::array<int, 2>>();
+    for (int i = 0; i < epss.size(); ++i) {
+      dlr2d_ifs.push_back(truncate_dlr2d_if(nodes, rprof, epss(i)));
+      fmt::print("eps = {}: system matrix rank = {}\n", epss(i), dlr2d_ifs.back().shape(0));
     }
 
-    // Singular part
-    for (int k = 0; k < r; ++k) {
-      for (int n = 0; n < 2 * r * r; ++n) {
-        if (nu2didx(n, 0) == -nu2didx(n, 1) - 1) {
-          kmat(n, 2 * r * r + k) = k_if(nu2didx(n, 0), dlr_rf(k), Fermion);
-        } else {
-          kmat(n, 2 * r * r + k) = 0;
-        }
-        // if (nu2d(n, 0) == -nu2d(n, 1)) {
-        //   kmat(n, 3 * r * r + k) = ker(nu2d(n, 0), dlr_rf(k));
-        // } else {
-        //   kmat(n, 3 * r * r + k) = 0;
-        // }
-      }
+    return dlr2d_ifs;
+  }
+
+  std::tuple<nda::array<int, 2>, nda::array<int, 2>> build_dlr2d_if_val(double lambda, double eps, int nval, rankmethod_t rankmethod) {
+
+    auto [nodes, rprof] = build_dlr2d_if_profile(lambda, eps, rankmethod);
+
+    // Validation nodes follow 2D DLR grid in pivot order
+    auto dlr2d_if     = truncate_dlr2d_if(nodes, rprof, eps);
+    int niom          = dlr2d_if.shape(0);
+    nval              = std::min(nval, (int)nodes.shape(0) - niom);
+    auto dlr2d_if_val = nda::array<int, 2>(nodes(nda::range(niom, niom + nval), _));
+
+    fmt::print("System matrix rank = {}\n", niom);
+    fmt::print("# validation nodes = {}\n\n", nval);
+
+    return {dlr2d_if, dlr2d_if_val};
+  }
+
+  void build_dlr2d_if_val(double lambda, double eps, int nval, std::string path, std::string filename, rankmethod_t rankmethod) {
+    auto [dlr2d_if, dlr2d_if_val] = build_dlr2d_if_val(lambda, eps, nval, rankmethod);
+
+    // Write dlr2d_if and dlr2d_if_val to hdf5 file
+    h5::file file(path + filename, 'w');
+    h5::group mygroup(file);
+    h5::write(mygroup, "dlr2d_if", dlr2d_if);
+    h5::write(mygroup, "dlr2d_if_val", dlr2d_if_val);
+  }
+
+  std::vector<nda::array<int, 2>> build_dlr2d_if_multieps(double lambda, nda::vector_const_view<double> epss, std::string path,
+                                                          rankmethod_t rankmethod) {
+    auto dlr2d_ifs = build_dlr2d_if_multieps(lambda, epss, rankmethod);
+
+    // Write each dlr2d_if to hdf5 file
+    for (int i = 0; i < epss.size(); ++i) {
+      h5::file file(path + get_filename_multieps(lambda, epss(i)), 'w');
+      h5::group mygroup(file);
+      h5::write(mygroup, "dlr2d_if", dlr2d_ifs[i]);
     }
 
-    fmt::print("Fine system matrix shape = {} x {}\n", kmat.shape(0), kmat.shape(1));
+    return dlr2d_ifs;
+  }
 
-    // Pivoted QR to determine sampling nodes
-    auto kmatt = fmatrix(transpose(kmat));
-    auto start = std::chrono::high_resolution_clock::now();
-    auto piv   = nda::zeros<int>(2 * r * r);
-    auto tau   = nda::vector<dcomplex>(2 * r * r);
+  nda::array<int, 2> build_dlr2d_if_nested(double lambda, double eps, nda::array_const_view<int, 2> dlr2d_if_seed, rankmethod_t rankmethod) {
+
+    // Get DLR frequencies
+    auto dlr_rf = build_dlr_rf(lambda, eps);
+    int r       = dlr_rf.size(); // # DLR basis functions
+    int nseed   = dlr2d_if_seed.shape(0);
+
+    fmt::print("\nDLR cutoff Lambda = {}\n", lambda);
+    fmt::print("DLR tolerance epsilon = {}\n", eps);
+    fmt::print("# DLR basis functions = {}\n", r);
+    fmt::print("# seed nodes = {}\n", nseed);
+
+    // Fine grid: seed nodes, followed by fine grid nodes not already among them
+    auto nu2didx_fine = build_dlr2d_if_fine(lambda, dlr_rf);
+    auto seedset      = std::set<std::pair<int, int>>();
+    for (int k = 0; k < nseed; ++k) { seedset.insert({dlr2d_if_seed(k, 0), dlr2d_if_seed(k, 1)}); }
+
+    auto isnew = std::vector<bool>(nu2didx_fine.shape(0));
+    int nnew   = 0;
+    for (int n = 0; n < nu2didx_fine.shape(0); ++n) {
+      isnew[n] = !seedset.contains({nu2didx_fine(n, 0), nu2didx_fine(n, 1)});
+      if (isnew[n]) ++nnew;
+    }
+
+    auto nu2didx                  = nda::array<int, 2>(nseed + nnew, 2);
+    nu2didx(nda::range(nseed), _) = dlr2d_if_seed;
+    int j                         = nseed;
+    for (int n = 0; n < nu2didx_fine.shape(0); ++n) {
+      if (isnew[n]) { nu2didx(j++, _) = nu2didx_fine(n, _); }
+    }
+    int nfine = nu2didx.shape(0);
+
+    // Pivoted QR with seed nodes fixed as initial pivots
+    auto kmatt             = build_k2d_if_t(dlr_rf, nu2didx);
+    int m                  = kmatt.shape(0);
+    auto piv               = nda::zeros<int>(nfine);
+    auto tau               = nda::vector<dcomplex>(std::min(m, nfine));
+    piv(nda::range(nseed)) = 1;
+    blas_thread_scope blas;
     nda::lapack::geqp3(kmatt, piv, tau);
 
-    // Estimate rank
-    int niom_skel = 0;
-    if (rankmethod == 1) {
-      for (int k = 0; k < 2 * r * r; ++k) {
-        if (abs(kmatt(k, k)) < eps) {
-          niom_skel = k;
-          break;
-        }
+    // Estimate rank, always keeping seed nodes
+    auto rprof    = qr_profile(kmatt, rankmethod);
+    int niom_skel = rprof.size();
+    for (int k = nseed; k < rprof.size(); ++k) {
+      if (rprof(k) < eps) {
+        niom_skel = k;
+        break;
       }
-    } else {
-      double errsq = 0;
-      for (int k = 2 * r * r - 1; k >= 0; --k) {
-        errsq += pow(abs(kmatt(k, k)), 2);
-        if (sqrt(errsq) > eps) {
-          niom_skel = k;
-          break;
-        }
+    }
+    niom_skel = std::max(niom_skel, nseed);
+
+    // Extract skeleton nodes from pivots; seed nodes keep their order
+    auto dlr2d_if                  = nda::array<int, 2>(niom_skel, 2);
+    dlr2d_if(nda::range(nseed), _) = dlr2d_if_seed;
+    for (int k = nseed; k < niom_skel; ++k) {
+      dlr2d_if(k, 0) = nu2didx(piv(k), 0);
+      dlr2d_if(k, 1) = nu2didx(piv(k), 1);
+    }
+
+    fmt::print("DLR rank squared = {}\n", r * r);
+    fmt::print("System matrix rank = {} ({} new nodes)\n\n", niom_skel, niom_skel - nseed);
+
+    return dlr2d_if;
+  }
+
+  std::vector<nda::array<int, 2>> build_dlr2d_if_ladder(nda::vector_const_view<double> lambdas, double eps, rankmethod_t rankmethod) {
+
+    auto dlr2d_ifs = std::vector<nda::array<int, 2>>();
+    for (int i = 0; i < lambdas.size(); ++i) {
+      if (i == 0) {
+        dlr2d_ifs.push_back(build_dlr2d_if(lambdas(i), eps, rankmethod));
+      } else {
+        if (lambdas(i) < lambdas(i - 1)) throw std::runtime_error("DLR cutoffs must be increasing.");
+        dlr2d_ifs.push_back(build_dlr2d_if_nested(lambdas(i), eps, dlr2d_ifs.back(), rankmethod));
       }
     }
-    // int niom_skel = estimate_rank(kmatt, eps, 2.0, 100);
 
-    // Extract skeleton nodes from pivots
+    return dlr2d_ifs;
+  }
+
+  std::vector<nda::array<int, 2>> build_dlr2d_if_ladder(nda::vector_const_view<double> lambdas, double eps, std::string path,
+                                                        rankmethod_t rankmethod) {
+    auto dlr2d_ifs = build_dlr2d_if_ladder(lambdas, eps, rankmethod);
+
+    // Write each dlr2d_if to hdf5 file
+    for (int i = 0; i < lambdas.size(); ++i) {
+      h5::file file(path + get_filename(lambdas(i), eps), 'w');
+      h5::group mygroup(file);
+      h5::write(mygroup, "dlr2d_if", dlr2d_ifs[i]);
+    }
+
+    return dlr2d_ifs;
+  }
+
+  nda::array<int, 2> build_dlr2d_if_streaming(double lambda, double eps, int tilesize, int nsketch, rankmethod_t rankmethod) {
+
+    // Get DLR frequencies
+    auto dlr_rf = build_dlr_rf(lambda, eps);
+    int r       = dlr_rf.size(); // # DLR basis functions
+    int ncoef   = 3 * r * r + r; // # 2D DLR basis functions
+
+    fmt::print("\nDLR cutoff Lambda = {}\n", lambda);
+    fmt::print("DLR tolerance epsilon = {}\n", eps);
+    fmt::print("# DLR basis functions = {}\n", r);
+
+    // Get fine 2D Matsubara frequency sampling grid
+    auto nu2didx = build_dlr2d_if_fine(lambda, dlr_rf);
+    int nfine    = nu2didx.shape(0);
+
+    // Columns of (sketched) transposed system matrix, regenerated on demand
+    auto getcols = [&](nda::vector_const_view<int> cols, fmatrix_const_view omega) {
+      auto idx = nda::array<int, 2>(cols.size(), 2);
+      for (int j = 0; j < cols.size(); ++j) { idx(j, _) = nu2didx(cols(j), _); }
+      return build_k2d_if_t_sketch(dlr_rf, idx, omega);
+    };
+
+    auto start    = std::chrono::high_resolution_clock::now();
+    auto skel     = streaming_pivot_sketch(ncoef, nfine, getcols, eps, tilesize, nsketch, rankmethod);
+    auto end      = std::chrono::high_resolution_clock::now();
+    int niom_skel = skel.size();
+
+    // Extract skeleton nodes
     auto dlr2d_if = nda::array<int, 2>(niom_skel, 2);
     for (int k = 0; k < niom_skel; ++k) {
-      dlr2d_if(k, 0) = nu2didx(piv(k), 0);
-      dlr2d_if(k, 1) = nu2didx(piv(k), 1);
+      dlr2d_if(k, 0) = nu2didx(skel(k), 0);
+      dlr2d_if(k, 1) = nu2didx(skel(k), 1);
     }
 
     fmt::print("DLR rank squared = {}\n", r * r);
-    fmt::print("System matrix rank = {}\n\n", niom_skel);
+    fmt::print("System matrix rank = {}\n", niom_skel);
+    fmt::print("Streaming pivoting ({}) time = {}\n\n", rankmethod_name(rankmethod), std::chrono::duration<double>(end - start).count());
 
     return dlr2d_if;
   }
 
-  void build_dlr2d_if_3term(double lambda, double eps, std::string path, std::string filename) {
-    auto dlr2d_if = build_dlr2d_if_3term(lambda, eps);
+  void build_dlr2d_if_streaming(double lambda, double eps, int tilesize, int nsketch, std::string path, std::string filename,
+                                rankmethod_t rankmethod) {
+    auto dlr2d_if = build_dlr2d_if_streaming(lambda, eps, tilesize, nsketch, rankmethod);
 
     // Write dlr2d_if to hdf5 file
     h5::file file(path + filename, 'w');
@@ -379,10 +686,9 @@ namespace dlr2d {
     h5::write(mygroup, "dlr2d_if", dlr2d_if);
   }
 
-  // Obtain 2D DLR nodes using reduced fine grid, recompression of basis
-  std::pair<nda::array<int, 2>, nda::array<int, 2>> build_dlr2d_ifrf(double lambda, double eps) {
-
-    int rankmethod = 1;
+  // Obtain 2D DLR nodes using reduced fine grid, mixed fermionic/bosonic
+  // representation, two terms
+  nda::array<int, 2> build_dlr2d_if_3term(double lambda, double eps, rankmethod_t rankmethod) {
 
     // Get DLR frequencies
     auto dlr_rf = build_dlr_rf(lambda, eps);
@@ -392,148 +698,132 @@ namespace dlr2d {
     fmt::print("DLR tolerance epsilon = {}\n", eps);
     fmt::print("# DLR basis functions = {}\n", r);
 
-    // Get fermionic and bosonic DLR grids
-    auto ifops_fer  = imfreq_ops(lambda, dlr_rf, Fermion);
-    auto ifops_bos  = imfreq_ops(lambda, dlr_rf, Boson);
-    auto dlr_if_fer = ifops_fer.get_ifnodes();
-    auto dlr_if_bos = ifops_bos.get_ifnodes();
+    // Get fine 2D Matsubara frequency sampling grid: index pairs of the last
+    // two terms of the fine grid of build_dlr2d_if
+    auto nu2didx = nda::array<int, 2>(build_dlr2d_if_fine(lambda, dlr_rf)(nda::range(r * r, 3 * r * r), _));
 
-    // Get fine 2D Matsubara frequency sampling grid
-    auto nu2didx = nda::array<int, 2>(3 * r * r, 2);
-    for (int m = 0; m < r; ++m) {
-      for (int n = 0; n < r; ++n) {
-        nu2didx(m * r + n, 0) = dlr_if_fer(m); // nu1 = (2*m_j + 1)*i*pi
-        nu2didx(m * r + n, 1) = dlr_if_fer(n); // nu2 = (2*n_j + 1)*i*pi
+    auto nu2d = (2 * nu2didx + 1) * pi * 1i;
 
-        nu2didx(r * r + m * r + n, 0) = dlr_if_bos(n) - dlr_if_fer(m) - 1; // nu1 = 2*n_k*i*pi - (2*m_j+1)*i*pi = (2*(n_k-m_j-1)+1)*i*pi
-        nu2didx(r * r + m * r + n, 1) = dlr_if_fer(m);                     // nu2 = (2*m_j + 1)*i*pi
+    // Get transposed system matrix for dense grid
+    auto kmatt = assemble_kmatt(nu2didx, kmat_cols(r, 1), build_k1d_if(dlr_rf, nu2didx, false), 1.0);
 
-        nu2didx(2 * r * r + m * r + n, 0) = dlr_if_fer(m);                     // nu1 = (2*m_j + 1)*i*pi
-        nu2didx(2 * r * r + m * r + n, 1) = dlr_if_bos(n) - dlr_if_fer(m) - 1; // nu2 = 2*n_k*i*pi - (2*m_j+1)*i*pi = (2*(n_k-m_j-1)+1)*i*pi
-      }
-    }
+    fmt::print("Fine system matrix shape = {} x {}\n", kmatt.shape(1), kmatt.shape(0));
 
-    auto nu2d = (2 * nu2didx + 1) * pi * 1i;
+    // Pivoted QR to determine sampling nodes
+    auto start = std::chrono::high_resolution_clock::now();
+    auto piv   = nda::zeros<int>(2 * r * r);
+    auto tau   = nda::vector<dcomplex>(2 * r * r);
+    blas_thread_scope blas;
+    nda::lapack::geqp3(kmatt, piv, tau);
+    auto end = std::chrono::high_resolution_clock::now();
 
-    // Get system matrix for dense grid
-    auto kmat = fmatrix(3 * r * r, 3 * r * r + r);
+    // Estimate rank
+    auto start_rank = std::chrono::high_resolution_clock::now();
+    int niom_skel   = qr_rank(kmatt, eps, rankmethod);
+    auto end_rank   = std::chrono::high_resolution_clock::now();
 
-    // Regular part
-    for (int k = 0; k < r; ++k) {
-      for (int l = 0; l < r; ++l) {
-        for (int n = 0; n < 3 * r * r; ++n) {
-
-          kmat(n, k * r + l) = k_if(nu2didx(n, 0), dlr_rf(k), Fermion) * k_if(nu2didx(n, 1), dlr_rf(l), Fermion);
-          // kmat(n, r * r + k * r + l) =
-          //     k_if(nu2didx(n, 1), dlr_rf(k), Fermion) *
-          //     my_k_if_boson(nu2didx(n, 0) + nu2didx(n, 1) + 1, dlr_rf(l));
-          // kmat(n, 2 * r * r + k * r + l) =
-          //     k_if(nu2didx(n, 0), dlr_rf(k), Fermion) *
-          //     my_k_if_boson(nu2didx(n, 0) + nu2didx(n, 1) + 1, dlr_rf(l));
-          kmat(n, r * r + k * r + l)     = k_if(nu2didx(n, 1), dlr_rf(k), Fermion) * k_if(nu2didx(n, 0) + nu2didx(n, 1) + 1, dlr_rf(l), Boson);
-          kmat(n, 2 * r * r + k * r + l) = k_if(nu2didx(n, 0), dlr_rf(k), Fermion) * k_if(nu2didx(n, 0) + nu2didx(n, 1) + 1, dlr_rf(l), Boson);
-
-          // kmat(n, k * r + l) =
-          //     ker(nu2d(n, 0), dlr_rf(k)) * ker(nu2d(n, 1), dlr_rf(l));
-          // kmat(n, r * r + k * r + l) = ker(nu2d(n, 1), dlr_rf(k)) *
-          //                              ker(nu2d(n, 0) + nu2d(n, 1), dlr_rf(l));
-          // kmat(n, 2 * r * r + k * r + l) =
-          //     ker(nu2d(n, 0), dlr_rf(k)) *
-          //     ker(nu2d(n, 0) + nu2d(n, 1), dlr_rf(l));
-        }
-      }
+    // Extract skeleton nodes from pivots
+    auto dlr2d_if = nda::array<int, 2>(niom_skel, 2);
+    for (int k = 0; k < niom_skel; ++k) {
+      dlr2d_if(k, 0) = nu2didx(piv(k), 0);
+      dlr2d_if(k, 1) = nu2didx(piv(k), 1);
     }
 
-    // Singular part
-    for (int k = 0; k < r; ++k) {
-      for (int n = 0; n < 3 * r * r; ++n) {
-        if (nu2didx(n, 0) == -nu2didx(n, 1) - 1) {
-          kmat(n, 3 * r * r + k) = k_if(nu2didx(n, 0), dlr_rf(k), Fermion);
-        } else {
-          kmat(n, 3 * r * r + k) = 0;
-        }
-        // if (nu2d(n, 0) == -nu2d(n, 1)) {
-        //   kmat(n, 3 * r * r + k) = ker(nu2d(n, 0), dlr_rf(k));
-        // } else {
-        //   kmat(n, 3 * r * r + k) = 0;
-        // }
-      }
-    }
+    fmt::print("DLR rank squared = {}\n", r * r);
+    fmt::print("System matrix rank = {}\n", niom_skel);
+    fmt::print("Pivoted QR time = {}\n", std::chrono::duration<double>(end - start).count());
+    fmt::print("Rank estimation ({}) time = {}\n\n", rankmethod_name(rankmethod), std::chrono::duration<double>(end_rank - start_rank).count());
 
-    // Pivoted QR to determine basis
-    auto kmat_copy = fmatrix(kmat);
-    auto piv       = nda::zeros<int>(3 * r * r + r);
-    auto tau       = nda::vector<dcomplex>(3 * r * r + r);
-    nda::lapack::geqp3(kmat, piv, tau);
+    return dlr2d_if;
+  }
 
-    // Estimate rank
-    int r2d = 0;
-    if (rankmethod == 1) {
-      for (int k = 0; k < 3 * r * r + r; ++k) {
-        if (abs(kmat(k, k)) < eps) {
-          r2d = k;
-          break;
-        }
-      }
-    } else {
-      double errsq = 0;
-      for (int k = 3 * r * r + r - 1; k >= 0; --k) {
-        errsq += pow(abs(kmat(k, k)), 2);
-        if (sqrt(errsq) > eps) {
-          r2d = k;
-          break;
-        }
-      }
-    }
+  void build_dlr2d_if_3term(double lambda, double eps, std::string path, std::string filename, rankmethod_t rankmethod) {
+    auto dlr2d_if = build_dlr2d_if_3term(lambda, eps, rankmethod);
 
-    // Extract basis functions from pivots
-    auto dlr2d_rfidx = nda::array<int, 2>(r2d, 3);
-    int idx          = 0;
-    double k = 0, l = 0;
-    for (int i = 0; i < r2d; ++i) {
-      idx = piv(i);
-      if (idx < r * r) {
-        std::tie(k, l)    = ind2sub_c(idx, r);
-        dlr2d_rfidx(i, 0) = 0;
-        dlr2d_rfidx(i, 1) = k;
-        dlr2d_rfidx(i, 2) = l;
-      } else if (idx < 2 * r * r) {
-        std::tie(k, l)    = ind2sub_c(idx - r * r, r);
-        dlr2d_rfidx(i, 0) = 1;
-        dlr2d_rfidx(i, 1) = k;
-        dlr2d_rfidx(i, 2) = l;
-      } else if (idx < 3 * r * r) {
-        std::tie(k, l)    = ind2sub_c(idx - 2 * r * r, r);
-        dlr2d_rfidx(i, 0) = 2;
-        dlr2d_rfidx(i, 1) = k;
-        dlr2d_rfidx(i, 2) = l;
-      } else {
-        dlr2d_rfidx(i, 0) = 3;
-        dlr2d_rfidx(i, 1) = idx - 3 * r * r;
-      }
+    // Write dlr2d_if to hdf5 file
+    h5::file file(path + filename, 'w');
+    h5::group mygroup(file);
+    h5::write(mygroup, "dlr2d_if", dlr2d_if);
+  }
+
+  // Obtain 2D DLR nodes using reduced fine grid, recompression of basis. This
+  // is a two-sided interpolative decomposition of the fine grid kernel matrix:
+  // a pivoted QR on its columns selects the basis functions, and a pivoted QR
+  // on the rows of the selected columns selects the Matsubara frequency nodes.
+  // The selected columns are regenerated from the kernel rather than copied,
+  // so only one fine grid kernel matrix is held in memory at a time.
+  std::pair<nda::array<int, 2>, nda::array<int, 2>> build_dlr2d_ifrf(double lambda, double eps, rankmethod_t rankmethod) {
+
+    // Get DLR frequencies
+    auto dlr_rf = build_dlr_rf(lambda, eps);
+    int r       = dlr_rf.size(); // # DLR basis functions
+
+    fmt::print("\nDLR cutoff Lambda = {}\n", lambda);
+    fmt::print("DLR tolerance epsilon = {}\n", eps);
+    fmt::print("# DLR basis functions = {}\n", r);
+
+    // Get fine 2D Matsubara frequency sampling grid
+    auto nu2didx = build_dlr2d_if_fine(lambda, dlr_rf);
+    int nfine    = nu2didx.shape(0);
+
+    // Column skeletonization: select basis functions by pivoted QR of the
+    // system matrix on the fine grid
+    int r2d          = 0;
+    auto dlr2d_rfidx = nda::array<int, 2>();
+    auto start       = std::chrono::high_resolution_clock::now();
+    auto end         = start;
+    auto start_rank  = start;
+    auto end_rank    = start;
+    {
+      auto cols = kmat_cols(r, 0);
+      auto kmat = assemble_kmat(nu2didx, cols, build_k1d_if(dlr_rf, nu2didx, false), 1.0);
+
+      start    = std::chrono::high_resolution_clock::now();
+      auto piv = nda::zeros<int>(3 * r * r + r);
+      auto tau = nda::vector<dcomplex>(std::min(nfine, 3 * r * r + r));
+      blas_thread_scope blas;
+      nda::lapack::geqp3(kmat, piv, tau);
+      end = std::chrono::high_resolution_clock::now();
+
+      // Estimate rank
+      start_rank = std::chrono::high_resolution_clock::now();
+      r2d        = qr_rank(kmat, eps, rankmethod);
+      end_rank   = std::chrono::high_resolution_clock::now();
+
+      // Extract basis functions from pivots, in the column layout used both
+      // here and by build_k2d_if_t for the row skeletonization
+      dlr2d_rfidx = nda::array<int, 2>(r2d, 3);
+      for (int i = 0; i < r2d; ++i) { dlr2d_rfidx(i, _) = cols(piv(i), _); }
     }
 
-    auto kmat2 = fmatrix(r2d, 3 * r * r);
-    for (int k = 0; k < r2d; ++k) { kmat2(k, _) = kmat_copy(_, piv(k)); }
-    piv       = 0;
-    auto tau2 = nda::vector<dcomplex>(r2d);
-    nda::lapack::geqp3(kmat2, piv, tau);
+    // Row skeletonization: select Matsubara frequency nodes by pivoted QR of
+    // the transposed selected columns, regenerated from the kernel
+    auto start_row = std::chrono::high_resolution_clock::now();
+    auto kmatt     = build_k2d_if_t(dlr_rf, nu2didx, dlr2d_rfidx);
+    auto piv2      = nda::zeros<int>(nfine);
+    auto tau2      = nda::vector<dcomplex>(std::min(r2d, nfine));
+    blas_thread_scope blas;
+    nda::lapack::geqp3(kmatt, piv2, tau2);
+    auto end_row = std::chrono::high_resolution_clock::now();
 
     // Extract skeleton nodes from pivots
     auto dlr2d_if = nda::array<int, 2>(r2d, 2);
     for (int k = 0; k < r2d; ++k) {
-      dlr2d_if(k, 0) = nu2didx(piv(k), 0);
-      dlr2d_if(k, 1) = nu2didx(piv(k), 1);
+      dlr2d_if(k, 0) = nu2didx(piv2(k), 0);
+      dlr2d_if(k, 1) = nu2didx(piv2(k), 1);
     }
 
     fmt::print("DLR rank squared = {}\n", r * r);
-    fmt::print("System matrix rank = {}\n\n", r2d);
+    fmt::print("System matrix rank = {}\n", r2d);
+    fmt::print("Column pivoted QR time = {}\n", std::chrono::duration<double>(end - start).count());
+    fmt::print("Rank estimation ({}) time = {}\n", rankmethod_name(rankmethod), std::chrono::duration<double>(end_rank - start_rank).count());
+    fmt::print("Row pivoted QR time = {}\n\n", std::chrono::duration<double>(end_row - start_row).count());
 
     return std::make_pair(dlr2d_rfidx, dlr2d_if);
   }
 
-  void build_dlr2d_ifrf(double lambda, double eps, std::string path, std::string filename) {
-    auto [dlr2d_rfidx, dlr2d_if] = build_dlr2d_ifrf(lambda, eps);
+  void build_dlr2d_ifrf(double lambda, double eps, std::string path, std::string filename, rankmethod_t rankmethod) {
+    auto [dlr2d_rfidx, dlr2d_if] = build_dlr2d_ifrf(lambda, eps, rankmethod);
 
     // Write data to hdf5 file
     h5::file file(path + filename, 'w');
@@ -542,56 +832,13 @@ namespace dlr2d {
     h5::write(mygroup, "dlr2d_if", dlr2d_if);
   }
 
-  fmatrix build_cf2if(double beta, nda::vector<double> dlr_rf, nda::array<int, 2> dlr2d_if) {
+  fmatrix build_cf2if(double beta, nda::vector<double> dlr_rf, nda::array<int, 2> dlr2d_if, statistic_t stat1, statistic_t stat2) {
 
-    int r         = dlr_rf.size();
-    int niom_skel = dlr2d_if.shape(0);
+    int r = dlr_rf.size();
 
     // Get system matrix for dense grid
-    auto cf2if = fmatrix(niom_skel, 3 * r * r + r);
-    // std::complex<double> nu1 = 0, nu2 = 0;
-
-    // Regular part
-    for (int k = 0; k < r; ++k) {
-      for (int l = 0; l < r; ++l) {
-        for (int n = 0; n < niom_skel; ++n) {
-
-          cf2if(n, k * r + l) = beta * beta * k_if(dlr2d_if(n, 0), dlr_rf(k), Fermion) * k_if(dlr2d_if(n, 1), dlr_rf(l), Fermion);
-          // kmat(n, r * r + k * r + l) =
-          //     beta * beta * k_if(dlr2d_if(n, 1), dlr_rf(k), Fermion) *
-          //     my_k_if_boson(dlr2d_if(n, 0) + dlr2d_if(n, 1) + 1, dlr_rf(l));
-          // kmat(n, 2 * r * r + k * r + l) =
-          //     beta * beta * k_if(dlr2d_if(n, 0), dlr_rf(k), Fermion) *
-          //     my_k_if_boson(dlr2d_if(n, 0) + dlr2d_if(n, 1) + 1, dlr_rf(l));
-          cf2if(n, r * r + k * r + l) =
-             beta * beta * k_if(dlr2d_if(n, 1), dlr_rf(k), Fermion) * k_if_boson(dlr2d_if(n, 0) + dlr2d_if(n, 1) + 1, dlr_rf(l));
-          cf2if(n, 2 * r * r + k * r + l) =
-             beta * beta * k_if(dlr2d_if(n, 0), dlr_rf(k), Fermion) * k_if_boson(dlr2d_if(n, 0) + dlr2d_if(n, 1) + 1, dlr_rf(l));
-
-          // nu1 = (2 * dlr2d_if(n, 0) + 1) * pi * 1i;
-          // nu2 = (2 * dlr2d_if(n, 1) + 1) * pi * 1i;
-          // kmat(n, k * r + l) =
-          //     beta * beta * ker(nu1, dlr_rf(k)) * ker(nu2, dlr_rf(l));
-          // kmat(n, r * r + k * r + l) =
-          //     beta * beta * ker(nu2, dlr_rf(k)) * ker(nu1 + nu2, dlr_rf(l));
-          // kmat(n, 2 * r * r + k * r + l) =
-          //     beta * beta * ker(nu1, dlr_rf(k)) * ker(nu1 + nu2, dlr_rf(l));
-        }
-      }
-    }
-
-    // Singular part
-    for (int k = 0; k < r; ++k) {
-      for (int n = 0; n < niom_skel; ++n) {
-        // nu1 = (2 * dlr2d_if(n, 0) + 1) * pi * 1i;
-        if (dlr2d_if(n, 0) == -dlr2d_if(n, 1) - 1) {
-          cf2if(n, 3 * r * r + k) = beta * beta * k_if(dlr2d_if(n, 0), dlr_rf(k), Fermion);
-          // kmat(n, 3 * r * r + k) = beta * ker(nu1, dlr_rf(k));
-        } else {
-          cf2if(n, 3 * r * r + k) = 0;
-        }
-      }
-    }
+    auto cf2if = assemble_kmat(dlr2d_if, kmat_cols(r, 0, sng_terms(stat1, stat2)), build_k1d_if(dlr_rf, dlr2d_if, true, stat1, stat2), beta * beta,
+                               sum_offset(stat1, stat2));
 
     return cf2if;
   }
@@ -599,72 +846,94 @@ namespace dlr2d {
   // two terms K matrix
   fmatrix build_cf2if_3term(double beta, nda::vector<double> dlr_rf, nda::array<int, 2> dlr2d_if) {
 
-    int r         = dlr_rf.size();
-    int niom_skel = dlr2d_if.shape(0);
+    int r = dlr_rf.size();
 
     // Get system matrix for dense grid
-    auto kmat = fmatrix(niom_skel, 2 * r * r + r);
-    // std::complex<double> nu1 = 0, nu2 = 0;
+    auto kmat = assemble_kmat(dlr2d_if, kmat_cols(r, 1), build_k1d_if(dlr_rf, dlr2d_if, true), beta * beta);
 
-    // Regular part
-    for (int k = 0; k < r; ++k) {
-      for (int l = 0; l < r; ++l) {
-        for (int n = 0; n < niom_skel; ++n) {
+    return kmat;
+  }
 
-          kmat(n, k * r + l) = beta * beta * k_if(dlr2d_if(n, 1), dlr_rf(k), Fermion) * k_if_boson(dlr2d_if(n, 0) + dlr2d_if(n, 1) + 1, dlr_rf(l));
-          kmat(n, r * r + k * r + l) =
-             beta * beta * k_if(dlr2d_if(n, 0), dlr_rf(k), Fermion) * k_if_boson(dlr2d_if(n, 0) + dlr2d_if(n, 1) + 1, dlr_rf(l));
-        }
-      }
-    }
+  fmatrix build_cf2if_square(double beta, nda::vector<double> dlr_rf, nda::array<int, 2> dlr2d_rfidx, nda::array<int, 2> dlr2d_if) {
 
-    // Singular part
-    for (int k = 0; k < r; ++k) {
-      for (int n = 0; n < niom_skel; ++n) {
-        // nu1 = (2 * dlr2d_if(n, 0) + 1) * pi * 1i;
-        if (dlr2d_if(n, 0) == -dlr2d_if(n, 1) - 1) {
-          kmat(n, 2 * r * r + k) = beta * beta * k_if(dlr2d_if(n, 0), dlr_rf(k), Fermion);
-          // kmat(n, 3 * r * r + k) = beta * ker(nu1, dlr_rf(k));
-        } else {
-          kmat(n, 2 * r * r + k) = 0;
-        }
-      }
-    }
+    int r = dlr_rf.size();
+
+    // Get system matrix for dense grid
+    auto kmat = assemble_kmat(dlr2d_if, dlr2d_rfidx, build_k1d_if(dlr_rf, dlr2d_if, false), beta * beta);
 
     return kmat;
   }
 
-  fmatrix build_cf2if_square(double beta, nda::vector<double> dlr_rf, nda::array<int, 2> dlr2d_rfidx, nda::array<int, 2> dlr2d_if) {
+  std::tuple<nda::array<dcomplex, 3>, nda::array<dcomplex, 2>> vals2coefs_if_mixed(fmatrix cf2if, nda::vector_const_view<dcomplex> vals, int r,
+                                                                                  statistic_t stat1, statistic_t stat2) {
 
-    int r   = dlr_rf.size();
-    int r2d = dlr2d_if.shape(0);
+    auto sng           = sng_terms(stat1, stat2);
+    int m              = vals.size();
+    int n              = 3 * r * r + sng.size() * r;
+    auto tmp           = nda::array<dcomplex, 1>(std::max(m, n));
+    tmp(nda::range(m)) = vals;
 
-    // Get system matrix for dense grid
-    auto kmat = fmatrix(r2d, r2d);
+    auto s   = nda::vector<double>(std::min(m, n)); // Singular values (not needed)
+    int rank = 0;                                   // Rank (not needed)
+    nda::lapack::gelss(cf2if, tmp, s, 0.0, rank);
 
-    // Regular part
-    int k = 0, l = 0;
-    for (int i = 0; i < r2d; ++i) {
-      k = dlr2d_rfidx(i, 1);
-      l = dlr2d_rfidx(i, 2);
-      for (int n = 0; n < r2d; ++n) {
-        if (dlr2d_rfidx(i, 0) == 0) {
-          kmat(n, i) = beta * beta * k_if(dlr2d_if(n, 0), dlr_rf(k), Fermion) * k_if(dlr2d_if(n, 1), dlr_rf(l), Fermion);
-        } else if (dlr2d_rfidx(i, 0) == 1) {
-          kmat(n, i) = beta * beta * k_if(dlr2d_if(n, 1), dlr_rf(k), Fermion) * k_if(dlr2d_if(n, 0) + dlr2d_if(n, 1) + 1, dlr_rf(l), Boson);
-        } else if (dlr2d_rfidx(i, 0) == 2) {
-          kmat(n, i) = beta * beta * k_if(dlr2d_if(n, 0), dlr_rf(k), Fermion) * k_if(dlr2d_if(n, 0) + dlr2d_if(n, 1) + 1, dlr_rf(l), Boson);
-        } else {
-          if (dlr2d_if(n, 0) == -dlr2d_if(n, 1) - 1) {
-            kmat(n, i) = beta * beta * k_if(dlr2d_if(n, 0), dlr_rf(k), Fermion);
-          } else {
-            kmat(n, i) = 0;
-          }
-        }
+    auto coefreg                = nda::array<dcomplex, 3>(3, r, r);
+    auto coefsng                = nda::array<dcomplex, 2>(3, r);
+    reshape(coefreg, 3 * r * r) = tmp(nda::range(3 * r * r));
+    coefsng                     = 0;
+    for (int i = 0; i < int(sng.size()); ++i) { coefsng(sng[i], _) = tmp(nda::range(3 * r * r + i * r, 3 * r * r + (i + 1) * r)); }
+
+    return {coefreg, coefsng};
+  }
+
+  nda::vector<dcomplex> coefs2eval_if_mixed(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 3> gc_reg,
+                                            nda::array_const_view<dcomplex, 2> gc_sng, nda::array_const_view<int, 2> idx, statistic_t stat1,
+                                            statistic_t stat2) {
+
+    int r    = dlr_rf.size(); // # DLR basis functions
+    int npts = idx.shape(0);
+    int off  = sum_offset(stat1, stat2);
+
+    // Make sure coefficient arrays are 3xrxr and 3xr
+    if (gc_reg.shape(0) != 3 || gc_reg.shape(1) != r || gc_reg.shape(2) != r)
+      throw std::runtime_error("Regular coefficient array must be 3 x r x r.");
+    if (gc_sng.shape(0) != 3 || gc_sng.shape(1) != r) throw std::runtime_error("Singular coefficient array must be 3 x r.");
+
+    // 1D kernels at each point, as in build_cf2if
+    auto k1d  = build_k1d_if(dlr_rf, idx, true, stat1, stat2);
+    auto &k1  = k1d[0];
+    auto &k2  = k1d[1];
+    auto &k12 = k1d[2];
+
+    // Regular part: contract coefficients with first kernel of each term for
+    // all points at once, then take row-wise products with second kernel
+    auto c = std::array<fmatrix, 3>{fmatrix(r, r), fmatrix(r, r), fmatrix(r, r)};
+    for (int t = 0; t < 3; ++t) {
+      for (int k = 0; k < r; ++k) {
+        for (int l = 0; l < r; ++l) { c[t](k, l) = gc_reg(t, k, l); }
+      }
+    }
+    auto a0 = fmatrix(k1 * c[0]);
+    auto a1 = fmatrix(k2 * c[1]);
+    auto a2 = fmatrix(k1 * c[2]);
+
+    auto sng  = sng_terms(stat1, stat2);
+    auto vals = nda::vector<dcomplex>(npts);
+#pragma omp parallel for schedule(static) num_threads(get_num_threads())
+    for (int n = 0; n < npts; ++n) {
+      dcomplex v = 0;
+      for (int l = 0; l < r; ++l) { v += a0(n, l) * k2(n, l) + (a1(n, l) + a2(n, l)) * k12(n, l); }
+
+      // Singular part
+      for (int i : sng) {
+        if (!on_sng(i, idx(n, 0), idx(n, 1), off)) continue;
+        for (int k = 0; k < r; ++k) { v += (i == 1 ? k2(n, k) : k1(n, k)) * gc_sng(i, k); }
       }
+
+      vals(n) = beta * beta * v;
     }
 
-    return kmat;
+    return vals;
   }
 
   nda::array<dcomplex, 1> vals2coefs_if_square(fmatrix cf2if, nda::vector_const_view<dcomplex> vals) {
@@ -845,6 +1114,380 @@ namespace dlr2d {
     return g;
   }
 
+  // Evaluate 2D DLR expansion at a batch of index pairs
+  nda::vector<dcomplex> coefs2eval_if(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 3> gc_reg,
+                                      nda::array_const_view<dcomplex, 1> gc_sng, nda::array_const_view<int, 2> idx, int channel) {
+
+    if (channel != 1 && channel != 2) throw std::runtime_error("Invalid channel for dlr2d_coefs2eval.");
+
+    // Map to particle-particle convention; the expansion is then the action of
+    // the coefficients to values operator on these points
+    auto idxpp = nda::array<int, 2>(idx);
+    if (channel == 2) idxpp(_, 0) = -idx(_, 0) - 1;
+
+    return cf2if_operator(beta, dlr_rf, idxpp).apply(gc_reg, gc_sng);
+  }
+
+  nda::vector<dcomplex> coefs2eval_z(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 3> gc_reg,
+                                     nda::array_const_view<dcomplex, 1> gc_sng, nda::array_const_view<dcomplex, 2> z, int channel, double sngtol) {
+
+    int r    = dlr_rf.size(); // # DLR basis functions
+    int npts = z.shape(0);
+
+    // Make sure coefficient array is 3xrxr
+    if (gc_reg.shape(0) != 3) throw std::runtime_error("First dim of coefficient array must be 3.");
+    if ((gc_reg.shape(1) != r) || (gc_reg.shape(2) != r))
+      throw std::runtime_error(
+         "Second and third dims of coefficient array must "
+         "be # DLR basis functions r.");
+    if (z.shape(1) != 2) throw std::runtime_error("Complex frequency array must have two columns.");
+    if (channel != 1 && channel != 2) throw std::runtime_error("Invalid channel for dlr2d_coefs2eval.");
+
+    // Prefactors c(om) of 1D kernels c(om)/(z - om), read off from the cppdlr
+    // kernels at a Matsubara frequency away from zero
+    auto cf = nda::vector<dcomplex>(r);
+    auto cb = nda::vector<dcomplex>(r);
+    for (int k = 0; k < r; ++k) {
+      cf(k) = k_if(0, dlr_rf(k), Fermion) * (pi * 1i - dlr_rf(k));
+      cb(k) = k_if_boson(1, dlr_rf(k)) * (2 * pi * 1i - dlr_rf(k));
+    }
+
+    // 1D kernels at each point, in particle-particle convention, with
+    // frequencies in units of 1/beta
+    auto kf1 = fmatrix(npts, r);
+    auto kf2 = fmatrix(npts, r);
+    auto kb  = fmatrix(npts, r);
+    auto sng = nda::vector<int>(npts);
+#pragma omp parallel for schedule(static) num_threads(get_num_threads())
+    for (int n = 0; n < npts; ++n) {
+      dcomplex z1 = beta * ((channel == 1) ? z(n, 0) : -z(n, 0));
+      dcomplex z2 = beta * z(n, 1);
+      dcomplex zb = z1 + z2;
+      sng(n)      = (abs(zb) <= sngtol);
+      for (int k = 0; k < r; ++k) {
+        kf1(n, k) = cf(k) / (z1 - dlr_rf(k));
+        kf2(n, k) = cf(k) / (z2 - dlr_rf(k));
+        // Removable singularity of bosonic kernel at z = om = 0
+        kb(n, k) = (zb == 0.0 && dlr_rf(k) == 0) ? k_if_boson(0, 0.0) : cb(k) / (zb - dlr_rf(k));
+      }
+    }
+
+    // Regular part: term t contributes sum_l (ka * C_t)(n, l) kc(n, l), where
+    // ka and kc are the 1D kernel matrices of its two factors
+    auto vals = nda::vector<dcomplex>(npts);
+    auto cblk = fmatrix(r, r);
+    auto p    = fmatrix(npts, r);
+    vals      = 0;
+    auto ka   = std::array<fmatrix const *, 3>{&kf1, &kf2, &kf1};
+    auto kc   = std::array<fmatrix const *, 3>{&kf2, &kb, &kb};
+    for (int t = 0; t < 3; ++t) {
+      for (int k = 0; k < r; ++k) {
+        for (int l = 0; l < r; ++l) { cblk(k, l) = gc_reg(t, k, l); }
+      }
+      p = (*ka[t]) * cblk;
+      for (int l = 0; l < r; ++l) {
+        for (int n = 0; n < npts; ++n) { vals(n) += p(n, l) * (*kc[t])(n, l); }
+      }
+    }
+
+    // Singular part
+    for (int n = 0; n < npts; ++n) {
+      if (!sng(n)) continue;
+      for (int k = 0; k < r; ++k) { vals(n) += kf1(n, k) * gc_sng(k); }
+    }
+
+    vals *= beta * beta;
+
+    return vals;
+  }
+
+  // Fermi function 1/(exp(om) + 1)
+  static double fermi(double om) { return (om > 0) ? std::exp(-om) / (1 + std::exp(-om)) : 1 / (1 + std::exp(om)); }
+
+  // Regular part 1/(exp(om) - 1) - 1/om of Bose function
+  static double bose_reg(double om) {
+    if (std::abs(om) < 1e-3) return -0.5 + om / 12 - om * om * om / 720;
+    return 1 / std::expm1(om) - 1 / om;
+  }
+
+  nda::vector<dcomplex> sum_if_vals(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 3> gc_reg,
+                                    nda::array_const_view<dcomplex, 1> gc_sng, nda::vector_const_view<int> idx, int arg, int channel) {
+
+    int r    = dlr_rf.size(); // # DLR basis functions
+    int npts = idx.size();
+
+    // Make sure coefficient array is 3xrxr
+    if (gc_reg.shape(0) != 3) throw std::runtime_error("First dim of coefficient array must be 3.");
+    if ((gc_reg.shape(1) != r) || (gc_reg.shape(2) != r))
+      throw std::runtime_error(
+         "Second and third dims of coefficient array must "
+         "be # DLR basis functions r.");
+    if (arg != 1 && arg != 2) throw std::runtime_error("Summed argument must be 1 or 2.");
+    if (channel != 1 && channel != 2) throw std::runtime_error("Invalid channel for dlr2d_coefs2eval.");
+
+    // Prefactors c(om) of 1D kernels c(om)/(z - om) (see coefs2eval_z), and
+    // symmetric sums of fermionic and bosonic kernels over all frequencies,
+    // sf = c(om) (n_F(om) - 1/2) and sb = c(om) (-1/(exp(om) - 1) + 1/om - 1/2)
+    // + K_b(0, om), with the zero frequency term split off
+    auto cf = nda::vector<dcomplex>(r);
+    auto cb = nda::vector<dcomplex>(r);
+    auto sf = nda::vector<dcomplex>(r);
+    auto sb = nda::vector<dcomplex>(r);
+    for (int k = 0; k < r; ++k) {
+      cf(k) = k_if(0, dlr_rf(k), Fermion) * (pi * 1i - dlr_rf(k));
+      cb(k) = k_if_boson(1, dlr_rf(k)) * (2 * pi * 1i - dlr_rf(k));
+      sf(k) = cf(k) * (fermi(dlr_rf(k)) - 0.5);
+      sb(k) = cb(k) * (-bose_reg(dlr_rf(k)) - 0.5) + k_if_boson(0, dlr_rf(k));
+    }
+
+    // In the particle-particle convention, with x the summed and y the
+    // remaining fermionic index, each term is of one of the forms K_f(x) K_f(y),
+    // K_f(y) K_b(x+y+1), or K_f(x) K_b(x+y+1). Sums of the first two are
+    // 1D expansions in K_f(y) with coefficients a and b, and the third (with
+    // coefficients cc(k, l) of K_f(x, om_k) K_b(x+y+1, om_l)) is summed by
+    // partial fractions for each y.
+    auto a  = nda::vector<dcomplex>(r);
+    auto b  = nda::vector<dcomplex>(r);
+    auto cc = nda::matrix<dcomplex>(r, r);
+    for (int k = 0; k < r; ++k) {
+      a(k) = 0;
+      b(k) = 0;
+      for (int l = 0; l < r; ++l) {
+        if (arg == 2) {
+          a(k) += gc_reg(0, k, l) * sf(l);
+          b(k) += gc_reg(2, k, l) * sb(l);
+          cc(k, l) = gc_reg(1, k, l);
+        } else {
+          a(k) += gc_reg(0, l, k) * sf(l);
+          b(k) += gc_reg(1, k, l) * sb(l);
+          cc(k, l) = gc_reg(2, k, l);
+        }
+      }
+    }
+
+    auto vals = nda::vector<dcomplex>(npts);
+#pragma omp parallel for schedule(static) num_threads(get_num_threads())
+    for (int n = 0; n < npts; ++n) {
+
+      // Remaining index in particle-particle convention
+      int y = (arg == 1 || channel == 1) ? idx(n) : -idx(n) - 1;
+
+      // Singular part: the delta function picks out x = -y-1, at which the
+      // kernel in the first argument is evaluated
+      int ysng = (arg == 2) ? y : -y - 1;
+
+      dcomplex v = 0;
+      for (int k = 0; k < r; ++k) {
+        v += (a(k) + b(k)) * k_if(y, dlr_rf(k), Fermion) + gc_sng(k) * k_if(ysng, dlr_rf(k), Fermion);
+
+        // sum_x K_f(x, om_k) K_b(x+y+1, om_l): with D = om_k + i nu_y, the sum
+        // over x /= -y-1 is c_k c_l ((n_F(om_k) + n_B(om_l) - 1/om_l)/(D -
+        // om_l) + 1/((D - om_l) D)), which is regular at om_l = 0, and the
+        // term x = -y-1 is -c_k/D K_b(0, om_l)
+        dcomplex d = dlr_rf(k) + (2 * y + 1) * pi * 1i;
+        for (int l = 0; l < r; ++l) {
+          dcomplex dl = d - dlr_rf(l);
+          v += cc(k, l) * (cf(k) * cb(l) * ((fermi(dlr_rf(k)) + bose_reg(dlr_rf(l))) / dl + 1.0 / (dl * d)) - cf(k) / d * k_if_boson(0, dlr_rf(l)));
+        }
+      }
+
+      vals(n) = beta * v;
+    }
+
+    return vals;
+  }
+
+  nda::vector<dcomplex> sum_if(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 3> gc_reg,
+                               nda::array_const_view<dcomplex, 1> gc_sng, imfreq_ops const &ifops, int arg, int channel) {
+
+    auto vals = sum_if_vals(beta, dlr_rf, gc_reg, gc_sng, ifops.get_ifnodes(), arg, channel);
+    return ifops.vals2coefs(beta, vals);
+  }
+
+  nda::array<dcomplex, 2> coefs2vals_box(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 3> gc_reg,
+                                         nda::array_const_view<dcomplex, 1> gc_sng, int nbox, int channel) {
+
+    int r  = dlr_rf.size(); // # DLR basis functions
+    int n2 = 2 * nbox;      // # Matsubara frequencies per dimension in box
+
+    // Make sure coefficient array is 3xrxr
+    if (gc_reg.shape(0) != 3) throw std::runtime_error("First dim of coefficient array must be 3.");
+    if ((gc_reg.shape(1) != r) || (gc_reg.shape(2) != r))
+      throw std::runtime_error(
+         "Second and third dims of coefficient array must "
+         "be # DLR basis functions r.");
+    if (channel != 1 && channel != 2) throw std::runtime_error("Invalid channel for dlr2d_coefs2eval.");
+
+    // 1D kernels: fermionic at m = -nbox,...,nbox-1 (row m+nbox), bosonic at
+    // m+n+1 = -n2+1,...,n2-1 (row (m+nbox)+(n+nbox))
+    auto kf = fmatrix(n2, r);
+    auto kb = fmatrix(2 * n2 - 1, r);
+#pragma omp parallel for schedule(static) num_threads(get_num_threads())
+    for (int i = 0; i < 2 * n2 - 1; ++i) {
+      for (int k = 0; k < r; ++k) {
+        if (i < n2) kf(i, k) = k_if(i - nbox, dlr_rf(k), Fermion);
+        kb(i, k) = k_if_boson(i - n2 + 1, dlr_rf(k));
+      }
+    }
+
+    // First term: kf * C_0 * kf^T
+    auto cblk = fmatrix(r, r);
+    for (int k = 0; k < r; ++k) {
+      for (int l = 0; l < r; ++l) { cblk(k, l) = gc_reg(0, k, l); }
+    }
+    auto vals = fmatrix(kf * cblk * transpose(kf));
+
+    // Second and third terms: with B_t = kb * C_t^T, the value at (m, n) is
+    // the product of row (m+nbox)+(n+nbox) of B_t with row n+nbox (resp.
+    // m+nbox) of kf
+    auto b = std::array<fmatrix, 2>{};
+    for (int t = 1; t < 3; ++t) {
+      for (int k = 0; k < r; ++k) {
+        for (int l = 0; l < r; ++l) { cblk(l, k) = gc_reg(t, k, l); }
+      }
+      b[t - 1] = kb * cblk;
+    }
+    {
+      blas_thread_scope blas(1); // Small concurrent matrix-vector products
+#pragma omp parallel for schedule(static) num_threads(get_num_threads())
+      for (int i = 0; i < n2; ++i) { vals(_, i) += matvecmul(b[0](nda::range(i, i + n2), _), kf(i, _)); }
+#pragma omp parallel for schedule(static) num_threads(get_num_threads())
+      for (int i = 0; i < n2; ++i) { vals(i, _) += matvecmul(b[1](nda::range(i, i + n2), _), kf(i, _)); }
+    }
+
+    // Singular part, on the anti-diagonal m+n+1 = 0
+    for (int i = 0; i < n2; ++i) {
+      for (int k = 0; k < r; ++k) { vals(i, n2 - 1 - i) += kf(i, k) * gc_sng(k); }
+    }
+
+    vals *= beta * beta;
+
+    // Particle-hole channel: m -> -m-1 reverses the rows
+    auto box = nda::array<dcomplex, 2>(n2, n2);
+    for (int i = 0; i < n2; ++i) {
+      for (int j = 0; j < n2; ++j) { box(i, j) = vals(channel == 1 ? i : n2 - 1 - i, j); }
+    }
+
+    return box;
+  }
+
+  nda::array<int, 2> nuom2if(nda::array_const_view<int, 2> idx, int channel) {
+
+    if (channel != 1 && channel != 2) throw std::runtime_error("Invalid channel for nuom2if.");
+
+    int npts = idx.shape(0);
+    auto ab  = nda::array<int, 2>(npts, 2);
+    for (int i = 0; i < npts; ++i) {
+      ab(i, 0) = (channel == 1) ? idx(i, 0) : -idx(i, 0) - 1;
+      ab(i, 1) = idx(i, 1) - ab(i, 0) - 1;
+    }
+
+    return ab;
+  }
+
+  nda::array<int, 2> if2nuom(nda::array_const_view<int, 2> dlr2d_if, int channel) {
+
+    if (channel != 1 && channel != 2) throw std::runtime_error("Invalid channel for if2nuom.");
+
+    int npts = dlr2d_if.shape(0);
+    auto idx = nda::array<int, 2>(npts, 2);
+    for (int i = 0; i < npts; ++i) {
+      idx(i, 0) = (channel == 1) ? dlr2d_if(i, 0) : -dlr2d_if(i, 0) - 1;
+      idx(i, 1) = dlr2d_if(i, 0) + dlr2d_if(i, 1) + 1;
+    }
+
+    return idx;
+  }
+
+  nda::array<int, 2> build_dlr2d_if_nuom(double lambda, double eps, int channel, rankmethod_t rankmethod) {
+    return if2nuom(build_dlr2d_if(lambda, eps, rankmethod), channel);
+  }
+
+  fmatrix build_cf2if_nuom(double beta, nda::vector<double> dlr_rf, nda::array_const_view<int, 2> dlr2d_if_nuom, int channel) {
+    return build_cf2if(beta, dlr_rf, nuom2if(dlr2d_if_nuom, channel));
+  }
+
+  nda::vector<dcomplex> coefs2eval_if_nuom(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 3> gc_reg,
+                                           nda::array_const_view<dcomplex, 1> gc_sng, nda::array_const_view<int, 2> idx, int channel) {
+    return cf2if_operator(beta, dlr_rf, nuom2if(idx, channel)).apply(gc_reg, gc_sng);
+  }
+
+  nda::array<dcomplex, 2> coefs2vals_box_nuom(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 3> gc_reg,
+                                              nda::array_const_view<dcomplex, 1> gc_sng, int nnu, int nom, int channel) {
+
+    int r    = dlr_rf.size(); // # DLR basis functions
+    int nfer = 2 * nnu;       // # fermionic frequencies in box
+    int nbos = 2 * nom - 1;   // # bosonic frequencies in box
+    int kmax = nnu + nom;     // Fermionic kernel needed at indices -kmax,...,kmax-1
+
+    // Make sure coefficient array is 3xrxr
+    if (gc_reg.shape(0) != 3) throw std::runtime_error("First dim of coefficient array must be 3.");
+    if ((gc_reg.shape(1) != r) || (gc_reg.shape(2) != r))
+      throw std::runtime_error(
+         "Second and third dims of coefficient array must "
+         "be # DLR basis functions r.");
+    if (channel != 1 && channel != 2) throw std::runtime_error("Invalid channel for coefs2vals_box_nuom.");
+
+    // Expansion arguments: a depends on n_nu only, b = n_Omega - a - 1, and
+    // the bosonic argument is n_Omega itself
+    auto a = nda::vector<int>(nfer);
+    for (int i = 0; i < nfer; ++i) { a(i) = (channel == 1) ? i - nnu : nnu - i - 1; }
+
+    // 1D kernels: fermionic at -kmax,...,kmax-1 (row index+kmax), fermionic at
+    // a (row i), and bosonic at n_Omega (row n_Omega+nom-1)
+    auto kf = fmatrix(2 * kmax, r);
+    auto ka = fmatrix(nfer, r);
+    auto kb = fmatrix(nbos, r);
+#pragma omp parallel for schedule(static) num_threads(get_num_threads())
+    for (int i = 0; i < 2 * kmax; ++i) {
+      for (int k = 0; k < r; ++k) {
+        kf(i, k) = k_if(i - kmax, dlr_rf(k), Fermion);
+        if (i < nbos) kb(i, k) = k_if_boson(i - nom + 1, dlr_rf(k));
+      }
+    }
+    for (int i = 0; i < nfer; ++i) { ka(i, _) = kf(a(i) + kmax, _); }
+
+    // Third term: ka * C_2 * kb^T
+    auto cblk = fmatrix(r, r);
+    for (int k = 0; k < r; ++k) {
+      for (int l = 0; l < r; ++l) { cblk(k, l) = gc_reg(2, k, l); }
+    }
+    auto vals = fmatrix(ka * cblk * transpose(kb));
+
+    // First and second terms: with A = ka * C_0 and B = kb * C_1^T, the value
+    // at (n_nu, n_Omega) is the product of the row of kf at b with the sum of
+    // the corresponding rows of A and B
+    for (int k = 0; k < r; ++k) {
+      for (int l = 0; l < r; ++l) { cblk(k, l) = gc_reg(0, k, l); }
+    }
+    auto amat = fmatrix(ka * cblk);
+    for (int k = 0; k < r; ++k) {
+      for (int l = 0; l < r; ++l) { cblk(l, k) = gc_reg(1, k, l); }
+    }
+    auto bmat = fmatrix(kb * cblk);
+#pragma omp parallel for schedule(static) num_threads(get_num_threads())
+    for (int j = 0; j < nbos; ++j) {
+      for (int i = 0; i < nfer; ++i) {
+        int b      = (j - nom + 1) - a(i) - 1;
+        dcomplex v = 0;
+        for (int l = 0; l < r; ++l) { v += kf(b + kmax, l) * (amat(i, l) + bmat(j, l)); }
+        vals(i, j) += v;
+      }
+    }
+
+    // Singular part, at n_Omega = 0
+    for (int i = 0; i < nfer; ++i) {
+      for (int k = 0; k < r; ++k) { vals(i, nom - 1) += ka(i, k) * gc_sng(k); }
+    }
+
+    auto box = nda::array<dcomplex, 2>(nfer, nbos);
+    for (int i = 0; i < nfer; ++i) {
+      for (int j = 0; j < nbos; ++j) { box(i, j) = beta * beta * vals(i, j); }
+    }
+
+    return box;
+  }
+
   // Evaluate 2D DLR expansion with two terms
   // Channel = 1 for particle-particle, = 2 for particle-hole
   std::complex<double> coefs2eval_if_3term(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 3> gc_reg,
@@ -888,6 +1531,96 @@ namespace dlr2d {
     return g;
   }
 
+  std::tuple<double, double, double, double> measure_error_if(double beta, int niomtst,
+                                                              std::function<nda::vector<dcomplex>(nda::array_const_view<int, 2>)> const &fdlr,
+                                                              std::function<nda::vector<dcomplex>(nda::array_const_view<int, 2>)> const &ftru,
+                                                              int tilesize) {
+
+    int nrow  = std::max(1, tilesize / niomtst); // # rows of test grid per tile
+    int ntile = (niomtst + nrow - 1) / nrow;
+
+    // Norms of each tile
+    auto nrmsq_t  = nda::zeros<double>(ntile);
+    auto errsq_t  = nda::zeros<double>(ntile);
+    auto nrminf_t = nda::zeros<double>(ntile);
+    auto errinf_t = nda::zeros<double>(ntile);
+
+    auto tile = [&](int t) {
+      // Index pairs in tile
+      int m0   = -niomtst / 2 + t * nrow;
+      int m1   = std::min(m0 + nrow, niomtst / 2);
+      auto idx = nda::array<int, 2>((m1 - m0) * niomtst, 2);
+      for (int m = m0; m < m1; ++m) {
+        for (int n = -niomtst / 2; n < niomtst / 2; ++n) {
+          int i     = (m - m0) * niomtst + n + niomtst / 2;
+          idx(i, 0) = m;
+          idx(i, 1) = n;
+        }
+      }
+
+      // Accumulate norms
+      auto vals = fdlr(idx);
+      auto tru  = ftru(idx);
+      for (int i = 0; i < idx.shape(0); ++i) {
+        double a = std::abs(tru(i)), e = std::abs(tru(i) - vals(i));
+        nrmsq_t(t) += a * a;
+        errsq_t(t) += e * e;
+        nrminf_t(t) = std::max(nrminf_t(t), a);
+        errinf_t(t) = std::max(errinf_t(t), e);
+      }
+    };
+
+    // Inside a parallel region (e.g. when called from an OpenMP task), a
+    // nested parallel loop would run on a single thread, so the tiles are
+    // distributed as tasks to the threads of the enclosing team instead
+#ifdef _OPENMP
+    bool nested = omp_in_parallel();
+#else
+    bool nested = false;
+#endif
+    if (nested) {
+#pragma omp taskloop grainsize(1)
+      for (int t = 0; t < ntile; ++t) { tile(t); }
+    } else {
+      blas_thread_scope blas(1); // Concurrent evaluations by cf2if_operator
+#pragma omp parallel for schedule(dynamic) num_threads(get_num_threads())
+      for (int t = 0; t < ntile; ++t) { tile(t); }
+    }
+
+    double nrmsq  = sum(nrmsq_t), errsq = sum(errsq_t);
+    double nrminf = max_element(nrminf_t), errinf = max_element(errinf_t);
+
+    return {sqrt(nrmsq) / beta / beta, nrminf, sqrt(errsq) / beta / beta, errinf};
+  }
+
+  std::tuple<double, double> estimate_error_if(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 3> gc_reg,
+                                               nda::array_const_view<dcomplex, 1> gc_sng, nda::array_const_view<int, 2> dlr2d_if_val,
+                                               nda::vector_const_view<dcomplex> vals_val, int channel) {
+
+    // Residual at validation nodes
+    double err = 0;
+    if (dlr2d_if_val.shape(0) > 0) { err = max_element(abs(coefs2eval_if(beta, dlr_rf, gc_reg, gc_sng, dlr2d_if_val, channel) - vals_val)); }
+
+    // Largest coefficients overall and at extremal real frequencies
+    int r        = dlr_rf.size();
+    double cmax  = 0, ctail = 0;
+    auto extreme = [r](int k) { return k == 0 || k == r - 1; };
+    for (int t = 0; t < 3; ++t) {
+      for (int k = 0; k < r; ++k) {
+        for (int l = 0; l < r; ++l) {
+          cmax = std::max(cmax, abs(gc_reg(t, k, l)));
+          if (extreme(k) || extreme(l)) ctail = std::max(ctail, abs(gc_reg(t, k, l)));
+        }
+      }
+    }
+    for (int k = 0; k < r; ++k) {
+      cmax = std::max(cmax, abs(gc_sng(k)));
+      if (extreme(k)) ctail = std::max(ctail, abs(gc_sng(k)));
+    }
+
+    return {err, (cmax > 0) ? ctail / cmax : 0.0};
+  }
+
   std::tuple<nda::array<dcomplex, 3>, nda::array<dcomplex, 1>> uncompress_basis(int r, nda::array<int, 2> dlr2d_rfidx, nda::array<dcomplex, 1> gc) {
     int r2d = dlr2d_rfidx.shape(0);
 
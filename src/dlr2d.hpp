@@ -2,6 +2,9 @@
 
 #include "utils.hpp"
 
+#include <array>
+#include <vector>
+
 namespace dlr2d {
 
   /*!
@@ -15,18 +18,349 @@ namespace dlr2d {
  * of three-point functions", arXiv:2405.06716, which involves building the fine
  * Matsubara frequency grid from combinations of 1D DLR grid points.
  *
+ * By default both frequencies are fermionic. Other statistics of each leg, as
+ * for electron-phonon (boson/fermion) or Hedin-type and bosonic (boson/boson)
+ * three-point vertices, are selected by \p stat1 and \p stat2; the fine grid
+ * and basis are then those of \ref build_dlr2d_if_fine and \ref build_cf2if
+ * with the same statistics.
+ *
  * \param[in] lambda      DLR cutoff parameter
  * \param[in] eps         Error tolerance
  * \param[in] path        Path to directory in which to save 2D DLR Mat. freqs.
  * \param[in] filename    Name of file in which to save 2D DLR Mat. freqs.
+ * \param[in] rankmethod  Rank estimation strategy (see \ref qr_rank)
+ * \param[in] stat1       Statistics of first frequency
+ * \param[in] stat2       Statistics of second frequency
+ *
+ * \note For a fermionic Matsubara frequency i*nu_n = (2n+1)*pi/beta, we refer
+ * to n as its index. An index pair (m, n) corresponds to the 2D Matsubara
+ * frequency point (i nu_m, i nu_n). See \ref build_dlr2d_if_fine for other
+ * statistics.
+ */
+  void build_dlr2d_if(double lambda, double eps, std::string path, std::string filename, rankmethod_t rankmethod = DiagThreshold,
+                      statistic_t stat1 = Fermion, statistic_t stat2 = Fermion);
+
+  nda::array<int, 2> build_dlr2d_if(double lambda, double eps, rankmethod_t rankmethod = DiagThreshold, statistic_t stat1 = Fermion,
+                                    statistic_t stat2 = Fermion);
+
+  /*!
+ * \brief Obtain fine grid nodes in pivot order and pivoted QR profile of 2D
+ * DLR system matrix
+ *
+ * This function performs the same pivoted QR decomposition as \ref
+ * build_dlr2d_if, but rather than truncating at tolerance eps, it returns the
+ * fine grid nodes in pivot order together with the rank profile of the
+ * triangular factor for the given rank estimation strategy (see \ref
+ * qr_profile), e.g. the magnitudes |R_kk| of its diagonal entries for \ref
+ * DiagThreshold. The 2D DLR grid for any tolerance eps' >= eps can then be
+ * obtained as a prefix of the pivot order using \ref truncate_dlr2d_if,
+ * without a further factorization.
+ *
+ * \param[in] lambda      DLR cutoff parameter
+ * \param[in] eps         Error tolerance used to build 1D DLR basis
+ * \param[in] rankmethod  Rank estimation strategy (see \ref qr_profile)
+ *
+ * \return Fine 2D Matsubara frequency grid nodes in pivot order, and rank
+ * profile
+ */
+  std::tuple<nda::array<int, 2>, nda::vector<double>> build_dlr2d_if_profile(double lambda, double eps, rankmethod_t rankmethod = DiagThreshold);
+
+  /*!
+ * \brief Truncate pivot-ordered fine grid at a given tolerance
+ *
+ * \param[in] nodes  Fine grid nodes in pivot order
+ * \param[in] rprof  Pivoted QR rank profile
+ * \param[in] eps    Error tolerance
+ *
+ * \return 2D DLR Matsubara frequency grid, consisting of the nodes which
+ * precede the first k with rprof(k) < eps
+ *
+ * \note \p nodes and \p rprof should be obtained from \ref
+ * build_dlr2d_if_profile.
+ */
+  nda::array<int, 2> truncate_dlr2d_if(nda::array_const_view<int, 2> nodes, nda::vector_const_view<double> rprof, double eps);
+
+  /*!
+ * \brief Obtain 2D DLR Matsubara frequency grids for several error tolerances
+ * from a single pivoted QR decomposition
+ *
+ * The pivoted QR profile is computed once by \ref build_dlr2d_if_profile for
+ * the tightest tolerance in \p epss, and the grid for each tolerance is then
+ * obtained as a prefix of the pivot order by \ref truncate_dlr2d_if.
+ *
+ * If \p path is given, each grid is written to an HDF5 file in that path,
+ * with the filename given by \ref get_filename_multieps, so that it can be
+ * read using \ref read_dlr2d_if without overwriting a grid generated by \ref
+ * build_dlr2d_if.
+ *
+ * \param[in] lambda      DLR cutoff parameter
+ * \param[in] epss        Error tolerances
+ * \param[in] path        Path to directory in which to save 2D DLR Mat. freqs.
+ * \param[in] rankmethod  Rank estimation strategy (see \ref qr_profile)
+ *
+ * \return 2D DLR Matsubara frequency grids, in the order of \p epss
+ *
+ * \note The grid for a looser tolerance eps' is obtained from the 1D DLR
+ * basis for the tightest tolerance, rather than from that for eps'. It is
+ * therefore a valid sampling grid for the 1D DLR basis for eps', but it may
+ * differ slightly from, and be slightly larger than, the grid obtained by \ref
+ * build_dlr2d_if with tolerance eps'.
+ */
+  std::vector<nda::array<int, 2>> build_dlr2d_if_multieps(double lambda, nda::vector_const_view<double> epss, std::string path,
+                                                          rankmethod_t rankmethod = DiagThreshold);
+
+  std::vector<nda::array<int, 2>> build_dlr2d_if_multieps(double lambda, nda::vector_const_view<double> epss,
+                                                          rankmethod_t rankmethod = DiagThreshold);
+
+  /*!
+ * \brief Obtain 2D DLR Matsubara frequency grid together with validation
+ * nodes for a posteriori error estimation
+ *
+ * The validation nodes are the nval fine grid nodes which follow the 2D DLR
+ * grid in the pivot order of the pivoted QR decomposition (see \ref
+ * build_dlr2d_if_profile). These are the nodes at which the 2D DLR basis
+ * functions are least well interpolated by the 2D DLR grid, so the residual
+ * of a fit at these nodes is a cheap indicator of its error; see \ref
+ * estimate_error_if.
+ *
+ * If \p path is given, the grid and the validation nodes are written to an
+ * HDF5 file in that path, which can be read using \ref read_dlr2d_if or \ref
+ * read_dlr2d_if_val.
+ *
+ * \param[in] lambda      DLR cutoff parameter
+ * \param[in] eps         Error tolerance
+ * \param[in] nval        # validation nodes
+ * \param[in] path        Path to directory in which to save 2D DLR Mat. freqs.
+ * \param[in] filename    Name of file in which to save 2D DLR Mat. freqs.
+ * \param[in] rankmethod  Rank estimation strategy (see \ref qr_profile)
+ *
+ * \return 2D DLR Matsubara frequency grid and validation nodes
+ */
+  void build_dlr2d_if_val(double lambda, double eps, int nval, std::string path, std::string filename, rankmethod_t rankmethod = DiagThreshold);
+
+  std::tuple<nda::array<int, 2>, nda::array<int, 2>> build_dlr2d_if_val(double lambda, double eps, int nval, rankmethod_t rankmethod = DiagThreshold);
+
+  /*!
+ * \brief Obtain 2D DLR Matsubara frequency grid containing a given set of
+ * nodes
+ *
+ * This function uses the same fine grid and system matrix as \ref
+ * build_dlr2d_if, but the nodes \p dlr2d_if_seed are always selected, and
+ * placed first: they are added to the fine grid and held fixed as the initial
+ * pivots of the pivoted QR decomposition, which then only selects the
+ * additional nodes needed to resolve the system matrix to tolerance eps.
+ *
+ * \param[in] lambda         DLR cutoff parameter
+ * \param[in] eps            Error tolerance
+ * \param[in] dlr2d_if_seed  Nodes to be contained in the grid
+ * \param[in] rankmethod     Rank estimation strategy (see \ref qr_profile)
+ *
+ * \return 2D DLR Matsubara frequency grid, the first rows of which are given by
+ * \p dlr2d_if_seed
+ *
+ * \note If \p dlr2d_if_seed is the 2D DLR grid for a smaller cutoff, values
+ * of a function sampled on that grid remain valid samples on the first rows of
+ * the new grid, and only the remaining nodes need to be sampled.
+ */
+  nda::array<int, 2> build_dlr2d_if_nested(double lambda, double eps, nda::array_const_view<int, 2> dlr2d_if_seed,
+                                           rankmethod_t rankmethod = DiagThreshold);
+
+  /*!
+ * \brief Obtain nested 2D DLR Matsubara frequency grids for an increasing
+ * sequence of DLR cutoffs
+ *
+ * The grid for lambdas(0) is obtained using \ref build_dlr2d_if, and the grid
+ * for each subsequent cutoff is obtained using \ref build_dlr2d_if_nested,
+ * seeded with the grid for the previous cutoff. The grids are therefore
+ * nested: each one contains the previous one as its first rows.
+ *
+ * If \p path is given, each grid is written to an HDF5 file in that path,
+ * with the standard filename given by \ref get_filename, so that it can be
+ * read using \ref read_dlr2d_if in place of a grid generated by \ref
+ * build_dlr2d_if.
+ *
+ * \param[in] lambdas     Increasing sequence of DLR cutoff parameters
+ * \param[in] eps         Error tolerance
+ * \param[in] path        Path to directory in which to save 2D DLR Mat. freqs.
+ * \param[in] rankmethod  Rank estimation strategy (see \ref qr_rank)
+ *
+ * \return Nested 2D DLR Matsubara frequency grids
+ */
+  std::vector<nda::array<int, 2>> build_dlr2d_if_ladder(nda::vector_const_view<double> lambdas, double eps, std::string path,
+                                                        rankmethod_t rankmethod = DiagThreshold);
+
+  std::vector<nda::array<int, 2>> build_dlr2d_if_ladder(nda::vector_const_view<double> lambdas, double eps, rankmethod_t rankmethod = DiagThreshold);
+
+  /*!
+ * \brief Obtain 2D DLR Matsubara frequency grid using tournament pivoting
+ *
+ * This function generates an HDF5 file in the specified path containing the
+ * 2D DLR Matsubara frequency grid points in terms of Matsubara frequency index
+ * pairs.
+ *
+ * It uses the same fine grid and system matrix as \ref build_dlr2d_if, but
+ * rather than a single pivoted QR decomposition of the full system matrix, it
+ * selects the skeleton nodes by tournament pivoting (see \ref
+ * tournament_pivot): the fine grid is split into \p nchunk chunks, skeleton
+ * nodes are selected from each chunk in parallel, and the winners are merged in
+ * a reduction tree. The columns of the transposed system matrix corresponding
+ * to each chunk are generated on demand, so the full system matrix is never
+ * formed.
+ *
+ * \param[in] lambda      DLR cutoff parameter
+ * \param[in] eps         Error tolerance
+ * \param[in] nchunk      # chunks into which fine grid is split
+ * \param[in] path        Path to directory in which to save 2D DLR Mat. freqs.
+ * \param[in] filename    Name of file in which to save 2D DLR Mat. freqs.
+ * \param[in] rankmethod  Rank estimation strategy (see \ref qr_rank)
  *
  * \note For a fermionic Matsubara frequency i*nu_n = (2n+1)*pi/beta, we refer
  * to n as its index. An index pair (m, n) corresponds to the 2D Matsubara
  * frequency point (i nu_m, i nu_n).
  */
-  void build_dlr2d_if(double lambda, double eps, std::string path, std::string filename);
+  void build_dlr2d_if_tournament(double lambda, double eps, int nchunk, std::string path, std::string filename,
+                                 rankmethod_t rankmethod = DiagThreshold);
 
-  nda::array<int, 2> build_dlr2d_if(double lambda, double eps);
+  nda::array<int, 2> build_dlr2d_if_tournament(double lambda, double eps, int nchunk, rankmethod_t rankmethod = DiagThreshold);
+
+  /*!
+ * \brief Obtain 2D DLR Matsubara frequency grid with bounded memory
+ *
+ * This function generates an HDF5 file in the specified path containing the
+ * 2D DLR Matsubara frequency grid points in terms of Matsubara frequency index
+ * pairs.
+ *
+ * It uses the same fine grid and system matrix as \ref build_dlr2d_if, but
+ * never forms the full system matrix. The fine grid is processed in tiles of
+ * \p tilesize nodes by streaming pivoting (see \ref streaming_pivot), and the
+ * kernel matrix of each tile is regenerated from the separable 1D kernels when
+ * needed rather than stored. If \p nsketch > 0, the columns of each tile are
+ * furthermore compressed from 3r^2 + r to \p nsketch entries by a fixed
+ * Gaussian sketch before pivoting (see \ref streaming_pivot_sketch). The sketch
+ * is applied to blocks of r rows of the kernel matrix of a tile as they are
+ * generated, so the unsketched tile is never formed. Peak memory is then
+ * proportional to \p nsketch x (niom_skel + tilesize) + \p nsketch x (3r^2 +
+ * r) + r x tilesize, rather than to 3r^2 x (3r^2 + r). If the sketch turns out
+ * to be too small to resolve the rank of the system matrix, \p nsketch is
+ * doubled and the selection is repeated.
+ *
+ * \param[in] lambda      DLR cutoff parameter
+ * \param[in] eps         Error tolerance
+ * \param[in] tilesize    # fine grid nodes per tile
+ * \param[in] nsketch     Sketch dimension (=0 for no sketching)
+ * \param[in] path        Path to directory in which to save 2D DLR Mat. freqs.
+ * \param[in] filename    Name of file in which to save 2D DLR Mat. freqs.
+ * \param[in] rankmethod  Rank estimation strategy (see \ref qr_rank)
+ *
+ * \note For a fermionic Matsubara frequency i*nu_n = (2n+1)*pi/beta, we refer
+ * to n as its index. An index pair (m, n) corresponds to the 2D Matsubara
+ * frequency point (i nu_m, i nu_n).
+ *
+ * \note With sketching, the tolerance eps is applied to the pivoted QR
+ * decomposition of the sketched matrix, which preserves column norms only in
+ * expectation. The resulting grid may therefore differ slightly in size from
+ * that obtained by \ref build_dlr2d_if.
+ */
+  void build_dlr2d_if_streaming(double lambda, double eps, int tilesize, int nsketch, std::string path, std::string filename,
+                                rankmethod_t rankmethod = DiagThreshold);
+
+  nda::array<int, 2> build_dlr2d_if_streaming(double lambda, double eps, int tilesize, int nsketch, rankmethod_t rankmethod = DiagThreshold);
+
+  /*!
+ * \brief Obtain fine 2D Matsubara frequency grid from combinations of 1D DLR
+ * grid points
+ *
+ * This is the fine grid of 3r^2 Matsubara frequency index pairs from which
+ * \ref build_dlr2d_if selects the 2D DLR Matsubara frequency grid. The three
+ * blocks of r^2 index pairs are chosen such that the arguments of the 1D
+ * kernels in the corresponding terms of the 2D DLR coincide with 1D DLR
+ * Matsubara frequencies of the corresponding statistics.
+ *
+ * The first and second frequencies nu1, nu2 have statistics \p stat1 and
+ * \p stat2. The statistics of nu1 + nu2 follow: bosonic if \p stat1 =
+ * \p stat2, and fermionic otherwise.
+ *
+ * \param[in] lambda  DLR cutoff parameter
+ * \param[in] dlr_rf  1D DLR real frequencies
+ * \param[in] stat1   Statistics of first frequency
+ * \param[in] stat2   Statistics of second frequency
+ *
+ * \return Fine 2D Matsubara frequency grid as an array containing Mat. freq.
+ * index pairs
+ *
+ * \note For a Matsubara frequency i*om_n = (2n+zeta)*pi/beta, with zeta = 1
+ * for fermions and zeta = 0 for bosons, we refer to n as its index. The index
+ * of nu1 + nu2 is then m+n+1 if both frequencies are fermionic, and m+n
+ * otherwise.
+ */
+  nda::array<int, 2> build_dlr2d_if_fine(double lambda, nda::vector_const_view<double> dlr_rf, statistic_t stat1 = Fermion,
+                                         statistic_t stat2 = Fermion);
+
+  /*!
+ * \brief Evaluate 1D DLR kernels at Matsubara frequency index pairs
+ *
+ * Row j of each returned niom x r matrix contains the 1D kernels, at the 1D
+ * DLR real frequencies, of the index pair nu2didx(j, _): in its first and
+ * second frequencies, with statistics \p stat1 and \p stat2, and in their
+ * sum, with the statistics of the sum (see \ref build_dlr2d_if_fine). These
+ * are the factors of all 2D DLR basis functions at the index pairs.
+ *
+ * \param[in] dlr_rf   1D DLR real frequencies
+ * \param[in] nu2didx  Matsubara frequency index pairs
+ * \param[in] kbos_alt Whether bosonic kernels are cppdlr's k_if_boson, as
+ * used for fitting and evaluation (see \ref build_cf2if), rather than
+ * k_if(n, om, Boson), as used for grid selection (see \ref build_k2d_if_t)
+ * \param[in] stat1    Statistics of first frequency
+ * \param[in] stat2    Statistics of second frequency
+ *
+ * \return 1D kernels in first frequency, second frequency and their sum,
+ * without factors of beta
+ */
+  std::array<fmatrix, 3> build_k1d_if(nda::vector_const_view<double> dlr_rf, nda::array_const_view<int, 2> nu2didx, bool kbos_alt,
+                                      statistic_t stat1 = Fermion, statistic_t stat2 = Fermion);
+
+  /*!
+ * \brief Build transposed 2D DLR kernel matrix for a set of Matsubara
+ * frequency index pairs
+ *
+ * Column j of the returned (3r^2 + nsng r) x niom matrix contains the values
+ * of the 2D DLR basis functions (three regular terms followed by the nsng
+ * singular terms, in the same order as the columns of \ref build_cf2if with
+ * the same statistics) at the index pair nu2didx(j, _), without the factor
+ * beta^2. The 1D kernels are evaluated once per index pair, and the 2D basis
+ * functions are formed from their products.
+ *
+ * \param[in] dlr_rf  1D DLR real frequencies
+ * \param[in] nu2didx Matsubara frequency index pairs
+ * \param[in] stat1   Statistics of first frequency
+ * \param[in] stat2   Statistics of second frequency
+ *
+ * \return Transposed kernel matrix
+ *
+ * \note The bosonic 1D kernels are cppdlr's k_if(n, om, Boson), which is
+ * used for grid selection throughout, rather than the k_if_boson used by
+ * \ref build_cf2if for fitting and evaluation. The two differ by a factor
+ * depending only on om, i.e. by a scaling of the basis functions, and so
+ * select grids for the same space of functions.
+ */
+  fmatrix build_k2d_if_t(nda::vector_const_view<double> dlr_rf, nda::array_const_view<int, 2> nu2didx, statistic_t stat1 = Fermion,
+                         statistic_t stat2 = Fermion);
+
+  /*!
+ * \brief Build transposed compressed 2D DLR kernel matrix for a set of
+ * Matsubara frequency index pairs
+ *
+ * This function differs from \ref build_k2d_if_t in that only the 2D DLR basis
+ * functions selected by \ref build_dlr2d_ifrf are evaluated, so the returned
+ * matrix is r2d x niom, with rows ordered as in \p dlr2d_rfidx.
+ *
+ * \param[in] dlr_rf      1D DLR real frequencies
+ * \param[in] nu2didx     Matsubara frequency index pairs
+ * \param[in] dlr2d_rfidx Compressed 2D DLR real frequency index pairs
+ *
+ * \return Transposed compressed kernel matrix
+ */
+  fmatrix build_k2d_if_t(nda::vector_const_view<double> dlr_rf, nda::array_const_view<int, 2> nu2didx, nda::array_const_view<int, 2> dlr2d_rfidx);
 
   /*!
  * \brief Obtain 2D DLR Matsubara frequency grid using three-term DLR
@@ -43,14 +377,15 @@ namespace dlr2d {
  * \param[in] eps         Error tolerance
  * \param[in] path        Path to directory in which to save 2D DLR Mat. freqs.
  * \param[in] filename    Name of file in which to save 2D DLR Mat. freqs.
+ * \param[in] rankmethod  Rank estimation strategy (see \ref qr_rank)
  *
  * \note For a fermionic Matsubara frequency i*nu_n = (2n+1)*pi/beta, we refer
  * to n as its index. An index pair (m, n) corresponds to the 2D Matsubara
  * frequency point (i nu_m, i nu_n).
  */
-  void build_dlr2d_if_3term(double lambda, double eps, std::string path, std::string filename);
+  void build_dlr2d_if_3term(double lambda, double eps, std::string path, std::string filename, rankmethod_t rankmethod = DiagThreshold);
 
-  nda::array<int, 2> build_dlr2d_if_3term(double lambda, double eps);
+  nda::array<int, 2> build_dlr2d_if_3term(double lambda, double eps, rankmethod_t rankmethod = DiagThreshold);
 
   /*!
  * \brief Obtain 2D DLR Matsubara frequency grid and compressed 2D DLR real
@@ -61,31 +396,33 @@ namespace dlr2d {
  * pairs and the 2D DLR real frequency grid points in terms of 1D DLR real
  * frequency grid index pairs.
  *
- * To generate the 2D DLR Matsubara frequency grid, it uses the same method as
- * in \ref build_dlr2d_if. It then compresses the 2D DLR real frequency grid
- * using the pivoted Gram-Schmidt algorithm on the columns of the row-compressed
- * kernel matrix.
+ * The kernel matrix on the fine grid of \ref build_dlr2d_if_fine is
+ * skeletonized from both sides. A pivoted QR decomposition of its columns
+ * selects the compressed 2D DLR real frequency grid, and a pivoted QR
+ * decomposition of the rows of the selected columns, which are regenerated
+ * from the kernel rather than stored, selects the 2D DLR Matsubara frequency
+ * grid. Both grids have the same size, so the resulting system matrix (see
+ * \ref build_cf2if_square) is square.
  *
  * \param[in] lambda      DLR cutoff parameter
  * \param[in] eps         Error tolerance
  * \param[in] path        Path to directory in which to save 2D DLR Mat. freqs.
  * \param[in] filename    Name of file in which to save 2D DLR Mat. freqs.
+ * \param[in] rankmethod  Rank estimation strategy (see \ref qr_rank)
  *
  * \note For a fermionic Matsubara frequency i*nu_n = (2n+1)*pi/beta, we refer
  * to n as its index. An index pair (m, n) corresponds to the 2D Matsubara
  * frequency point (i nu_m, i nu_n).
  *
- * \note THIS FUNCTION IS OLD AND MAY NOT WORK PROPERLY. TEST BEFORE USING.
- *
  * \note This is not the method proposed in Kiese et al., "Discrete Lehmann
  * representation of three-point functions", arXiv:2405.06716, which does not
  * recompress the 2D DLR real frequency grid. That method yields an
  * "overcomplete" representation, whereas this method yields a fully compressed
  * representation.
  */
-  void build_dlr2d_ifrf(double lambda, double eps, std::string path, std::string filename);
+  void build_dlr2d_ifrf(double lambda, double eps, std::string path, std::string filename, rankmethod_t rankmethod = DiagThreshold);
 
-  std::pair<nda::array<int, 2>, nda::array<int, 2>> build_dlr2d_ifrf(double lambda, double eps);
+  std::pair<nda::array<int, 2>, nda::array<int, 2>> build_dlr2d_ifrf(double lambda, double eps, rankmethod_t rankmethod = DiagThreshold);
 
   /*!
  * \brief Obtain 2D DLR Matsubara frequency grid, using all Matsubara
@@ -95,27 +432,42 @@ namespace dlr2d {
  * 2D DLR Matsubara frequency grid points in terms of Matsubara frequency index
  * pairs.
  *
+ * The fine grid consists of all index pairs (m, n) with -niom_dense/2 <= m, n <
+ * niom_dense/2, and the skeleton nodes are selected from it by streaming
+ * pivoting (see \ref streaming_pivot) in tiles of \p tilesize nodes, as in
+ * \ref build_dlr2d_if_streaming. Neither the fine grid nor the
+ * niom_dense^2 x (3r^2 + r) system matrix is stored; the kernel matrix of each
+ * tile is regenerated from the separable 1D kernels when needed, and memory is
+ * bounded by (3r^2 + r) x (niom_skel + tilesize), or \p nsketch x (niom_skel +
+ * tilesize + 3r^2 + r) + r x tilesize if a Gaussian sketch of dimension
+ * \p nsketch > 0 is used, since the sketch is then applied to blocks of r rows
+ * of the kernel matrix of a tile as they are generated.
+ *
  * \param[in] lambda      DLR cutoff parameter
  * \param[in] niom_dense  # Matsubara frequencies per dimension in fine grid
  * \param[in] eps         Error tolerance
  * \param[in] path        Path to directory in which to save 2D DLR Mat. freqs.
  * \param[in] filename    Name of file in which to save 2D DLR Mat. freqs.
+ * \param[in] tilesize    # fine grid nodes per tile
+ * \param[in] nsketch     Sketch dimension (=0 for no sketching)
+ * \param[in] rankmethod  Rank estimation strategy (see \ref qr_rank)
  *
  * \note For a fermionic Matsubara frequency i*nu_n = (2n+1)*pi/beta, we refer
  * to n as its index. An index pair (m, n) corresponds to the 2D Matsubara
  * frequency point (i nu_m, i nu_n).
  *
- * \note THIS FUNCTION IS OLD AND MAY NOT WORK PROPERLY. TEST BEFORE USING.
- *
  * \note This is not the standard way of generating the 2D DLR grid, and will be
- * slow for large values of the DLR cutoff Lambda and tolerance epsilon. The
- * function build_dlr2d_if is the standard, more efficient approach, and
- * corresponds to the method proposed in Kiese et al., "Discrete Lehmann
- * representation of three-point functions", arXiv:2405.06716.
+ * slow for large values of the DLR cutoff Lambda and tolerance epsilon. It is
+ * intended to generate reference grids against which to validate grids
+ * obtained by \ref build_dlr2d_if, which is the standard, more efficient
+ * approach, and corresponds to the method proposed in Kiese et al., "Discrete
+ * Lehmann representation of three-point functions", arXiv:2405.06716.
  */
-  void build_dlr2d_if_fullgrid(double lambda, int niom_dense, double eps, std::string path, std::string filename);
+  void build_dlr2d_if_fullgrid(double lambda, int niom_dense, double eps, std::string path, std::string filename, int tilesize = 4096,
+                               int nsketch = 0, rankmethod_t rankmethod = DiagThreshold);
 
-  nda::array<int, 2> build_dlr2d_if_fullgrid(double lambda, int niom_dense, double eps);
+  nda::array<int, 2> build_dlr2d_if_fullgrid(double lambda, int niom_dense, double eps, int tilesize = 4096, int nsketch = 0,
+                                             rankmethod_t rankmethod = DiagThreshold);
 
   /*!
  * \brief Read 2D DLR Matsubara frequency grid from file
@@ -155,17 +507,55 @@ namespace dlr2d {
  */
   std::tuple<nda::array<int, 2>, nda::array<int, 2>> read_dlr2d_rfif(std::string path, std::string filename);
 
+  /*!
+ * \brief Read 2D DLR Matsubara frequency grid and validation nodes from file
+ *
+ * \param[in] path     Path to directory containing 2D DLR Mat. freqs.
+ * \param[in] filename Name of file containing 2D DLR Mat. freqs.
+ *
+ * \return 2D DLR Matsubara frequency grid and validation nodes
+ *
+ * \note The file should be produced using \ref build_dlr2d_if_val.
+ */
+  std::tuple<nda::array<int, 2>, nda::array<int, 2>> read_dlr2d_if_val(std::string path, std::string filename);
+
   /*!
  * \brief Build matrix which maps coefficients of a 2D DLR expansion to its
  * values on the 2D DLR imaginary (Matsubara) frequency grid
  *
+ * The regular part consists of the three terms beta^2 K_1(nu1) K_2(nu2),
+ * beta^2 K_2(nu2) K_12(nu1 + nu2) and beta^2 K_1(nu1) K_12(nu1 + nu2), where
+ * K_1, K_2 and K_12 are the 1D kernels of the statistics of nu1, nu2 and
+ * nu1 + nu2 (see \ref build_dlr2d_if_fine). The singular part contains one
+ * term of r coefficients for each bosonic frequency, supported where that
+ * frequency vanishes:
+ *
+ * 0. beta^2 delta(nu1 + nu2 = 0) K_1(nu1), if nu1 + nu2 is bosonic,
+ * 1. beta^2 delta(nu1 = 0) K_2(nu2), if nu1 is bosonic,
+ * 2. beta^2 delta(nu2 = 0) K_1(nu1), if nu2 is bosonic.
+ *
+ * The columns of the matrix are the 3r^2 regular basis functions, followed by
+ * the singular basis functions of the terms present, in the order above. For
+ * the default fermionic frequencies, only term 0 is present.
+ *
+ * Fermionic 1D kernels are cppdlr's k_if(n, om, Fermion), and bosonic 1D
+ * kernels are k_if_boson(n, om), for every leg; the evaluators (\ref
+ * coefs2eval_if, \ref coefs2eval_if_mixed) use the same kernels.
+ *
  * \param[in] beta      Inverse temperature
  * \param[in] dlr_rf    1D DLR real frequencies
  * \param[in] dlr2d_if  2D DLR imaginary frequency grid
+ * \param[in] stat1     Statistics of first frequency
+ * \param[in] stat2     Statistics of second frequency
  *
  * \return Coefficients to values matrix
+ *
+ * \note For statistics other than the default, the coefficients are obtained
+ * by \ref vals2coefs_if_mixed and evaluated by \ref coefs2eval_if_mixed,
+ * which store the singular part as one row per singular term.
  */
-  fmatrix build_cf2if(double beta, nda::vector<double> dlr_rf, nda::array<int, 2> dlr2d_if);
+  fmatrix build_cf2if(double beta, nda::vector<double> dlr_rf, nda::array<int, 2> dlr2d_if, statistic_t stat1 = Fermion,
+                      statistic_t stat2 = Fermion);
 
   /*!
  * \brief Build matrix which maps coefficients of a 2D DLR expansion to its
@@ -202,6 +592,45 @@ namespace dlr2d {
  */
   fmatrix build_cf2if_square(double beta, nda::vector<double> dlr_rf, nda::array<int, 2> dlr2d_rfidx, nda::array<int, 2> dlr2d_if);
 
+  /*!
+ * \brief Transform values of a 2D DLR expansion with given statistics of each
+ * leg on a 2D Matsubara frequency grid to its coefficients
+ *
+ * \param[in] cf2if  Coefficients to values matrix
+ * \param[in] vals   Values of 2D DLR expansion on 2D Mat. freq. grid
+ * \param[in] r      # basis functions in 1D DLR
+ * \param[in] stat1  Statistics of first frequency
+ * \param[in] stat2  Statistics of second frequency
+ *
+ * \return 2D DLR regular expansion coefficients (3 x r x r) and singular
+ * expansion coefficients (3 x r, with row i the coefficients of singular term
+ * i of \ref build_cf2if, and zero rows for terms not present)
+ *
+ * \note The matrix \p cf2if should be obtained using \ref build_cf2if with
+ * the same statistics.
+ */
+  std::tuple<nda::array<dcomplex, 3>, nda::array<dcomplex, 2>> vals2coefs_if_mixed(fmatrix cf2if, nda::vector_const_view<dcomplex> vals, int r,
+                                                                                  statistic_t stat1, statistic_t stat2);
+
+  /*!
+ * \brief Evaluate a 2D DLR expansion with given statistics of each leg at a
+ * batch of Matsubara frequency points
+ *
+ * \param[in] beta    Inverse temperature
+ * \param[in] dlr_rf  1D DLR real frequencies
+ * \param[in] gc_reg  2D DLR regular expansion coefficients
+ * \param[in] gc_sng  2D DLR singular expansion coefficients, in the format of
+ * \ref vals2coefs_if_mixed
+ * \param[in] idx     Matsubara frequency index pairs
+ * \param[in] stat1   Statistics of first frequency
+ * \param[in] stat2   Statistics of second frequency
+ *
+ * \return Values of 2D DLR expansion at the given points
+ */
+  nda::vector<dcomplex> coefs2eval_if_mixed(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 3> gc_reg,
+                                            nda::array_const_view<dcomplex, 2> gc_sng, nda::array_const_view<int, 2> idx, statistic_t stat1,
+                                            statistic_t stat2);
+
   /*!
  * \brief Transform values of a 2D DLR expansion on the 2D DLR imaginary
  * (Matsubara) frequency grid to its coefficients
@@ -308,6 +737,273 @@ namespace dlr2d {
   std::complex<double> coefs2eval_if(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 3> gc_reg,
                                      nda::array_const_view<dcomplex, 1> gc_sng, int m, int n, int channel);
 
+  /*!
+ * \brief Evaluate a 2D DLR expansion at a batch of fermionic/fermionic
+ * Matsubara frequency points
+ *
+ * This function differs from the scalar version of \ref coefs2eval_if in
+ * that the 1D kernels are evaluated once per point, and the expansion is
+ * evaluated for all points at once using matrix-matrix products (see \ref
+ * cf2if_operator).
+ *
+ * \param[in] beta    Inverse temperature
+ * \param[in] dlr_rf  1D DLR real frequencies
+ * \param[in] gc_reg  2D DLR regular expansion coefficients
+ * \param[in] gc_sng  1D DLR singular expansion coefficients
+ * \param[in] idx     Matsubara frequency index pairs (m, n)
+ * \param[in] channel Channel index (=1 for particle-particle, =2 for
+ * particle-hole)
+ *
+ * \return Values of 2D DLR expansion at the given points
+ */
+  nda::vector<dcomplex> coefs2eval_if(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 3> gc_reg,
+                                      nda::array_const_view<dcomplex, 1> gc_sng, nda::array_const_view<int, 2> idx, int channel);
+
+  /*!
+ * \brief Evaluate a 2D DLR expansion at a batch of complex frequency points
+ *
+ * The 2D DLR basis functions are products of 1D kernels of the Lehmann form
+ * c(om)/(z - om), which are analytic in z away from the real frequencies om.
+ * This function evaluates the continuation of the expansion to arbitrary
+ * complex frequency pairs (z1, z2), e.g. z = omega + i*eta just above the real
+ * axis to obtain retarded quantities, in the same way as the batched \ref
+ * coefs2eval_if: the 1D kernels are evaluated once per point, and the
+ * regular part is evaluated for all points at once using matrix-matrix
+ * products. The prefactors c(om) are taken from the cppdlr kernels, so that
+ * at z1 = i nu_m, z2 = i nu_n the result agrees with \ref coefs2eval_if at
+ * the index pair (m, n).
+ *
+ * The singular part is supported only at z1 + z2 = 0 (after the channel
+ * mapping), and has no continuation away from it. It is added for points with
+ * |beta (z1 + z2)| <= \p sngtol, and omitted otherwise. With the default
+ * tolerance, it is included exactly on the anti-diagonal of the Matsubara
+ * grid, and the result off the anti-diagonal is the continuation of the
+ * regular part alone.
+ *
+ * \param[in] beta    Inverse temperature
+ * \param[in] dlr_rf  1D DLR real frequencies
+ * \param[in] gc_reg  2D DLR regular expansion coefficients
+ * \param[in] gc_sng  1D DLR singular expansion coefficients
+ * \param[in] z       Complex frequency pairs (z1, z2), one per row
+ * \param[in] channel Channel index (=1 for particle-particle, =2 for
+ * particle-hole)
+ * \param[in] sngtol  Dimensionless tolerance for inclusion of singular part,
+ * compared with |beta (z1 + z2)|, i.e. in units of 1/beta. Since adjacent
+ * bosonic Matsubara frequencies differ by 2 pi / beta, any value below 2 pi
+ * selects exactly the anti-diagonal on the Matsubara grid.
+ *
+ * \return Values of 2D DLR expansion at the given points
+ *
+ * \note As in \ref coefs2eval_if, in the particle-hole channel the first
+ * argument is mapped z1 -> -z1 before evaluation, which maps the upper half
+ * plane to the lower one.
+ */
+  nda::vector<dcomplex> coefs2eval_z(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 3> gc_reg,
+                                     nda::array_const_view<dcomplex, 1> gc_sng, nda::array_const_view<dcomplex, 2> z, int channel,
+                                     double sngtol = 1e-12);
+
+  /*!
+ * \brief Sum a 2D DLR expansion over one of its Matsubara frequency arguments
+ *
+ * Computes (1/beta) sum_{nu_2} G(i nu_1, i nu_2) (arg = 2) or (1/beta)
+ * sum_{nu_1} G(i nu_1, i nu_2) (arg = 1) at the given indices of the
+ * remaining argument, where G is evaluated as in \ref coefs2eval_if. Since each
+ * term is a product of 1D Lehmann kernels, the sums are given in closed form
+ * by Fermi and Bose occupation factors at the 1D DLR real frequencies, at a
+ * cost of O(r^2) per point after an O(r^2) precomputation. Sums which are only
+ * conditionally convergent are taken symmetrically, i.e. as the limit of sums
+ * over boxes -N <= n < N, which is the limit of truncated box summation.
+ *
+ * \param[in] beta    Inverse temperature
+ * \param[in] dlr_rf  1D DLR real frequencies
+ * \param[in] gc_reg  2D DLR regular expansion coefficients
+ * \param[in] gc_sng  1D DLR singular expansion coefficients
+ * \param[in] idx     Indices of remaining (fermionic) Matsubara frequency
+ * \param[in] arg     Argument to sum over (=1 for nu_1, =2 for nu_2)
+ * \param[in] channel Channel index (=1 for particle-particle, =2 for
+ * particle-hole)
+ *
+ * \return Values of partial sum at the given indices
+ */
+  nda::vector<dcomplex> sum_if_vals(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 3> gc_reg,
+                                    nda::array_const_view<dcomplex, 1> gc_sng, nda::vector_const_view<int> idx, int arg, int channel);
+
+  /*!
+ * \brief Sum a 2D DLR expansion over one of its Matsubara frequency arguments,
+ * and represent the result by a 1D DLR expansion
+ *
+ * The partial sum (see \ref sum_if_vals) is evaluated on the 1D DLR Matsubara
+ * frequency grid of \p ifops and fit by a 1D DLR expansion. Terms in which the
+ * summed frequency appears in both a fermionic and the bosonic kernel yield
+ * poles at differences om_k - om_l of 1D DLR real frequencies, so \p ifops
+ * should be built with cutoff 2 lambda, where lambda is the cutoff of the 2D
+ * DLR expansion, for the fit to be accurate to the 2D DLR tolerance.
+ *
+ * \param[in] beta    Inverse temperature
+ * \param[in] dlr_rf  1D DLR real frequencies of 2D DLR expansion
+ * \param[in] gc_reg  2D DLR regular expansion coefficients
+ * \param[in] gc_sng  1D DLR singular expansion coefficients
+ * \param[in] ifops   Fermionic 1D DLR imaginary frequency operations object
+ * for result
+ * \param[in] arg     Argument to sum over (=1 for nu_1, =2 for nu_2)
+ * \param[in] channel Channel index (=1 for particle-particle, =2 for
+ * particle-hole)
+ *
+ * \return 1D DLR expansion coefficients of partial sum, in the basis of \p
+ * ifops
+ */
+  nda::vector<dcomplex> sum_if(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 3> gc_reg,
+                               nda::array_const_view<dcomplex, 1> gc_sng, imfreq_ops const &ifops, int arg, int channel);
+
+  /*!
+ * \brief Evaluate a 2D DLR expansion on a full box of fermionic/fermionic
+ * Matsubara frequency points
+ *
+ * The box consists of the index pairs (m, n) with -nbox <= m, n < nbox. The
+ * first regular term is evaluated by two matrix-matrix products with the 1D
+ * fermionic kernel matrix. The other two regular terms depend on the index
+ * pair through m+n+1 and only one of m, n, so after contracting the
+ * coefficients with the 1D bosonic kernel matrix, each column (resp. row) of
+ * the box is the product of a contiguous block of rows of the result with a
+ * row of the fermionic kernel matrix. The cost is O(nbox^2 r), rather than
+ * the O(nbox^2 r^2) of pointwise evaluation.
+ *
+ * \param[in] beta    Inverse temperature
+ * \param[in] dlr_rf  1D DLR real frequencies
+ * \param[in] gc_reg  2D DLR regular expansion coefficients
+ * \param[in] gc_sng  1D DLR singular expansion coefficients
+ * \param[in] nbox    Half-width of box
+ * \param[in] channel Channel index (=1 for particle-particle, =2 for
+ * particle-hole)
+ *
+ * \return 2*nbox x 2*nbox array of values of 2D DLR expansion, with entry
+ * (m+nbox, n+nbox) at index pair (m, n)
+ */
+  nda::array<dcomplex, 2> coefs2vals_box(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 3> gc_reg,
+                                         nda::array_const_view<dcomplex, 1> gc_sng, int nbox, int channel);
+
+  /*!
+ * \brief Convert fermion/boson Matsubara frequency index pairs to arguments of
+ * a 2D DLR expansion
+ *
+ * A three-point function of one fermionic frequency nu and one bosonic
+ * frequency Omega is represented by a 2D DLR expansion in the
+ * particle-particle convention, evaluated at the index pair (a, b) with a+b+1
+ * equal to the index of Omega, so that the bosonic kernel is applied at Omega
+ * directly. In the particle-particle channel, (nu, Omega) = (nu_1, nu_1 +
+ * nu_2), and (a, b) = (n_nu, n_Omega - n_nu - 1). In the particle-hole
+ * channel, (nu, Omega) = (nu_1, nu_2 - nu_1), and (a, b) = (-n_nu - 1, n_nu +
+ * n_Omega), which is the pair at which \ref coefs2eval_if evaluates the
+ * expansion for the index pair (n_nu, n_nu + n_Omega) with channel = 2. The
+ * singular part of the expansion contributes at n_Omega = 0.
+ *
+ * \param[in] idx     Index pairs (n_nu, n_Omega)
+ * \param[in] channel Channel index (=1 for particle-particle, =2 for
+ * particle-hole)
+ *
+ * \return Index pairs (a, b) of expansion arguments
+ *
+ * \note For a bosonic Matsubara frequency i*Omega_n = 2n*pi/beta, we refer to
+ * n as its index.
+ */
+  nda::array<int, 2> nuom2if(nda::array_const_view<int, 2> idx, int channel);
+
+  /*!
+ * \brief Convert arguments of a 2D DLR expansion to fermion/boson Matsubara
+ * frequency index pairs
+ *
+ * This is the inverse of \ref nuom2if. Applied to the 2D DLR Matsubara
+ * frequency grid, it gives the points (n_nu, n_Omega) at which a function of
+ * the given channel must be sampled to be fitted (see \ref build_cf2if_nuom).
+ *
+ * \param[in] dlr2d_if Index pairs (a, b) of expansion arguments
+ * \param[in] channel  Channel index (=1 for particle-particle, =2 for
+ * particle-hole)
+ *
+ * \return Index pairs (n_nu, n_Omega)
+ */
+  nda::array<int, 2> if2nuom(nda::array_const_view<int, 2> dlr2d_if, int channel);
+
+  /*!
+ * \brief Obtain 2D DLR Matsubara frequency grid in fermion/boson convention
+ *
+ * The grid is that of \ref build_dlr2d_if, converted by \ref if2nuom.
+ *
+ * \param[in] lambda      DLR cutoff parameter
+ * \param[in] eps         Error tolerance
+ * \param[in] channel     Channel index (=1 for particle-particle, =2 for
+ * particle-hole)
+ * \param[in] rankmethod  Rank estimation strategy (see \ref qr_rank)
+ *
+ * \return 2D DLR Matsubara frequency grid as an array containing index pairs
+ * (n_nu, n_Omega)
+ */
+  nda::array<int, 2> build_dlr2d_if_nuom(double lambda, double eps, int channel, rankmethod_t rankmethod = DiagThreshold);
+
+  /*!
+ * \brief Build matrix which maps coefficients of a 2D DLR expansion to its
+ * values on a 2D DLR grid in fermion/boson convention
+ *
+ * The returned matrix is used with \ref vals2coefs_if, with the values given
+ * in the order of the points of \p dlr2d_if_nuom.
+ *
+ * \param[in] beta          Inverse temperature
+ * \param[in] dlr_rf        1D DLR real frequencies
+ * \param[in] dlr2d_if_nuom 2D DLR grid of index pairs (n_nu, n_Omega)
+ * \param[in] channel       Channel index (=1 for particle-particle, =2 for
+ * particle-hole)
+ *
+ * \return Coefficients to values matrix
+ */
+  fmatrix build_cf2if_nuom(double beta, nda::vector<double> dlr_rf, nda::array_const_view<int, 2> dlr2d_if_nuom, int channel);
+
+  /*!
+ * \brief Evaluate a 2D DLR expansion at a batch of fermion/boson Matsubara
+ * frequency points
+ *
+ * \param[in] beta    Inverse temperature
+ * \param[in] dlr_rf  1D DLR real frequencies
+ * \param[in] gc_reg  2D DLR regular expansion coefficients
+ * \param[in] gc_sng  1D DLR singular expansion coefficients
+ * \param[in] idx     Index pairs (n_nu, n_Omega)
+ * \param[in] channel Channel index (=1 for particle-particle, =2 for
+ * particle-hole)
+ *
+ * \return Values of 2D DLR expansion at the given points
+ *
+ * \note See \ref nuom2if for the frequency convention.
+ */
+  nda::vector<dcomplex> coefs2eval_if_nuom(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 3> gc_reg,
+                                           nda::array_const_view<dcomplex, 1> gc_sng, nda::array_const_view<int, 2> idx, int channel);
+
+  /*!
+ * \brief Evaluate a 2D DLR expansion on a full box of fermion/boson Matsubara
+ * frequency points
+ *
+ * The box consists of the index pairs (n_nu, n_Omega) with -nnu <= n_nu < nnu
+ * and -nom < n_Omega < nom. The bosonic kernel depends only on n_Omega, and
+ * each fermionic kernel only on n_nu or on a combination of n_nu and n_Omega
+ * which is a contiguous range of indices along each column of the box, so all
+ * terms are evaluated from tabulated 1D kernels contracted with the
+ * coefficients, at cost O(nnu nom r).
+ *
+ * \param[in] beta    Inverse temperature
+ * \param[in] dlr_rf  1D DLR real frequencies
+ * \param[in] gc_reg  2D DLR regular expansion coefficients
+ * \param[in] gc_sng  1D DLR singular expansion coefficients
+ * \param[in] nnu     Half-width of box in fermionic frequency
+ * \param[in] nom     # non-negative bosonic frequencies in box
+ * \param[in] channel Channel index (=1 for particle-particle, =2 for
+ * particle-hole)
+ *
+ * \return 2*nnu x (2*nom-1) array of values of 2D DLR expansion, with entry
+ * (n_nu+nnu, n_Omega+nom-1) at index pair (n_nu, n_Omega)
+ *
+ * \note See \ref nuom2if for the frequency convention.
+ */
+  nda::array<dcomplex, 2> coefs2vals_box_nuom(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 3> gc_reg,
+                                              nda::array_const_view<dcomplex, 1> gc_sng, int nnu, int nom, int channel);
+
   /*!
  * \brief Evaluate a 2D DLR expansion at a given fermionic/fermionic Matsubara
  * frequency point, using three-term DLR
@@ -332,6 +1028,68 @@ namespace dlr2d {
   std::complex<double> coefs2eval_if_3term(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 3> gc_reg,
                                            nda::array_const_view<dcomplex, 1> gc_sng, int m, int n, int channel);
 
+  /*!
+ * \brief Measure error of a 2D DLR expansion against a reference function on a
+ * dense square test grid
+ *
+ * The test grid consists of the index pairs (m, n) with -niomtst/2 <= m, n <
+ * niomtst/2. It is processed in tiles of about tilesize points, in parallel
+ * over tiles, and the norms are accumulated tile by tile, so the values on the
+ * full test grid are never stored. If the function is called inside a
+ * parallel region, for example from an OpenMP task, the tiles are processed
+ * as tasks by the threads of the enclosing team. The expansion and the reference function
+ * are evaluated by \p fdlr and \p ftru, which receive the index pairs of a
+ * tile and should be batched (for example, the batched version of \ref
+ * coefs2eval_if), and which must be safe to call concurrently.
+ *
+ * \param[in] beta     Inverse temperature
+ * \param[in] niomtst  # Matsubara frequencies per dimension in test grid
+ * \param[in] fdlr     Evaluator of 2D DLR expansion at index pairs
+ * \param[in] ftru     Evaluator of reference function at index pairs
+ * \param[in] tilesize # test points per tile
+ *
+ * \return L2 norm and Linf norm of reference function, and L2 and Linf errors
+ *
+ * \note L2 norms are sums over the test grid scaled by 1/beta^2.
+ */
+  std::tuple<double, double, double, double> measure_error_if(double beta, int niomtst,
+                                                              std::function<nda::vector<dcomplex>(nda::array_const_view<int, 2>)> const &fdlr,
+                                                              std::function<nda::vector<dcomplex>(nda::array_const_view<int, 2>)> const &ftru,
+                                                              int tilesize = 65536);
+
+  /*!
+ * \brief Estimate error of a 2D DLR expansion from its residual at validation
+ * nodes
+ *
+ * This function returns two indicators, computed in O(nval r^2) work, which
+ * can be used in place of a comparison with the true function on a dense test
+ * grid:
+ *
+ * - The maximum residual of the expansion at the validation nodes.
+ * - The ratio of the largest coefficient at the extremal 1D DLR real
+ * frequencies (first or last, in either argument) to the largest coefficient
+ * overall. A value close to 1 suggests that the DLR cutoff is too small.
+ *
+ * \param[in] beta         Inverse temperature
+ * \param[in] dlr_rf       1D DLR real frequencies
+ * \param[in] gc_reg       2D DLR regular expansion coefficients
+ * \param[in] gc_sng       1D DLR singular expansion coefficients
+ * \param[in] dlr2d_if_val Validation nodes
+ * \param[in] vals_val     Values of function at validation nodes
+ * \param[in] channel      Channel index (=1 for particle-particle, =2 for
+ * particle-hole)
+ *
+ * \return Maximum residual at validation nodes, and coefficient tail ratio
+ *
+ * \note The validation nodes should be obtained using \ref
+ * build_dlr2d_if_val, and are interpreted as in \ref coefs2eval_if, so that
+ * vals_val(j) is the value at the point at which \ref coefs2eval_if evaluates
+ * the expansion for the index pair dlr2d_if_val(j, _) and \p channel.
+ */
+  std::tuple<double, double> estimate_error_if(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 3> gc_reg,
+                                               nda::array_const_view<dcomplex, 1> gc_sng, nda::array_const_view<int, 2> dlr2d_if_val,
+                                               nda::vector_const_view<dcomplex> vals_val, int channel);
+
   /*!
  * \brief Convert compressed 2D DLR expansion coefficients to ordinary
  * (overcomplete) 2D DLR expansion coefficient storage format
@@ -0,0 +1,362 @@
+#include "dlr3d.hpp"
+
+#include <array>
+#include <fmt/format.h>
+#include <set>
+
+namespace dlr2d {
+
+  using namespace cppdlr;
+
+  // Pair partitions {{a, b}, {c, d}} of the four fermionic frequencies, stored
+  // as {a, b, c, d}
+  static constexpr int pairs3d[3][4] = {{0, 1, 2, 3}, {0, 2, 1, 3}, {0, 3, 1, 2}};
+
+  // Indices of all four fermionic frequencies of an index triple
+  static std::array<int, 4> fer_indices(int n1, int n2, int n3) { return {n1, n2, n3, -n1 - n2 - n3 - 2}; }
+
+  nda::array<int, 2> build_dlr3d_if_fine(double lambda, nda::vector_const_view<double> dlr_rf) {
+
+    int r = dlr_rf.size();
+
+    // Get fermionic and bosonic DLR grids
+    auto ifops_fer  = imfreq_ops(lambda, dlr_rf, Fermion);
+    auto ifops_bos  = imfreq_ops(lambda, dlr_rf, Boson);
+    auto dlr_if_fer = ifops_fer.get_ifnodes();
+    auto dlr_if_bos = ifops_bos.get_ifnodes();
+
+    // For regular term with fermionic arguments nu_x, nu_y and bosonic argument
+    // nu_x + nu_x', place nu_x, nu_y and nu_x + nu_x' on 1D DLR grids; the
+    // remaining frequency nu_y' then follows from nu_1 + ... + nu_4 = 0
+    auto nodes = std::set<std::array<int, 3>>();
+    for (int t = 0; t < 12; ++t) {
+      auto const &pr = pairs3d[t / 4];
+      int x          = pr[(t % 4) / 2];
+      int xp         = pr[1 - (t % 4) / 2];
+      int y          = pr[2 + t % 2];
+      int yp         = pr[3 - t % 2];
+      for (int i = 0; i < r; ++i) {
+        for (int j = 0; j < r; ++j) {
+          for (int k = 0; k < r; ++k) {
+            auto n = std::array<int, 4>{};
+            n[x]   = dlr_if_fer(i);
+            n[xp]  = dlr_if_bos(j) - dlr_if_fer(i) - 1;
+            n[y]   = dlr_if_fer(k);
+            n[yp]  = -n[x] - n[xp] - n[y] - 2;
+            nodes.insert({n[0], n[1], n[2]});
+          }
+        }
+      }
+    }
+
+    auto nu3didx = nda::array<int, 2>(nodes.size(), 3);
+    int i        = 0;
+    for (auto const &n : nodes) {
+      for (int q = 0; q < 3; ++q) { nu3didx(i, q) = n[q]; }
+      ++i;
+    }
+
+    return nu3didx;
+  }
+
+  fmatrix build_k3d_if_t(nda::vector_const_view<double> dlr_rf, nda::array_const_view<int, 2> nu3didx) {
+
+    int r    = dlr_rf.size();
+    int r2   = r * r;
+    int r3   = r * r * r;
+    int niom = nu3didx.shape(0);
+
+    auto kmatt = fmatrix(12 * r3 + 3 * r2, niom);
+
+#pragma omp parallel for schedule(static) num_threads(get_num_threads())
+    for (int n = 0; n < niom; ++n) {
+
+      // 1D kernels at this index triple: fermionic in each frequency, bosonic
+      // in the pair sum of each partition
+      auto nf = fer_indices(nu3didx(n, 0), nu3didx(n, 1), nu3didx(n, 2));
+      auto kf = nda::matrix<dcomplex>(4, r);
+      auto kb = nda::matrix<dcomplex>(3, r);
+      for (int k = 0; k < r; ++k) {
+        for (int q = 0; q < 4; ++q) { kf(q, k) = k_if(nf[q], dlr_rf(k), Fermion); }
+        for (int p = 0; p < 3; ++p) { kb(p, k) = k_if(nf[pairs3d[p][0]] + nf[pairs3d[p][1]] + 1, dlr_rf(k), Boson); }
+      }
+
+      // Regular part
+      for (int t = 0; t < 12; ++t) {
+        int p = t / 4;
+        int x = pairs3d[p][(t % 4) / 2];
+        int y = pairs3d[p][2 + t % 2];
+        for (int k = 0; k < r; ++k) {
+          for (int l = 0; l < r; ++l) {
+            dcomplex kxb = kf(x, k) * kb(p, l);
+            for (int m = 0; m < r; ++m) { kmatt(t * r3 + k * r2 + l * r + m, n) = kxb * kf(y, m); }
+          }
+        }
+      }
+
+      // Singular part
+      for (int p = 0; p < 3; ++p) {
+        bool sng = (nf[pairs3d[p][0]] + nf[pairs3d[p][1]] + 1 == 0);
+        for (int k = 0; k < r; ++k) {
+          for (int m = 0; m < r; ++m) {
+            kmatt(12 * r3 + p * r2 + k * r + m, n) = sng ? kf(pairs3d[p][0], k) * kf(pairs3d[p][2], m) : dcomplex(0);
+          }
+        }
+      }
+    }
+
+    return kmatt;
+  }
+
+  // Columns of transposed 3D DLR system matrix at Matsubara frequency index
+  // triples idx, multiplied from the left by the sketching matrix omega (see
+  // build_k3d_if_t). The sketch is applied to one block of r rows (fixed term
+  // and first two DLR frequencies) at a time, as it is generated, so that the
+  // full (12r^3 + 3r^2) x niom block is never formed. If omega is empty, the
+  // unsketched columns are returned.
+  static fmatrix build_k3d_if_t_sketch(nda::vector_const_view<double> dlr_rf, nda::array_const_view<int, 2> idx, fmatrix_const_view omega) {
+
+    if (omega.shape(0) == 0) { return build_k3d_if_t(dlr_rf, idx); }
+
+    int r    = dlr_rf.size();
+    int r2   = r * r;
+    int r3   = r * r * r;
+    int niom = idx.shape(0);
+
+    // 1D kernels at each index triple: fermionic in each frequency, bosonic in
+    // the pair sum of each partition
+    auto kf  = nda::array<dcomplex, 3>(4, niom, r);
+    auto kb  = nda::array<dcomplex, 3>(3, niom, r);
+    auto sng = nda::array<bool, 2>(3, niom);
+#pragma omp parallel for schedule(static) num_threads(get_num_threads())
+    for (int n = 0; n < niom; ++n) {
+      auto nf = fer_indices(idx(n, 0), idx(n, 1), idx(n, 2));
+      for (int p = 0; p < 3; ++p) { sng(p, n) = (nf[pairs3d[p][0]] + nf[pairs3d[p][1]] + 1 == 0); }
+      for (int k = 0; k < r; ++k) {
+        for (int q = 0; q < 4; ++q) { kf(q, n, k) = k_if(nf[q], dlr_rf(k), Fermion); }
+        for (int p = 0; p < 3; ++p) { kb(p, n, k) = k_if(nf[pairs3d[p][0]] + nf[pairs3d[p][1]] + 1, dlr_rf(k), Boson); }
+      }
+    }
+
+    auto res = fmatrix(omega.shape(0), niom);
+    auto blk = fmatrix(r, niom);
+    res      = 0;
+
+    // Regular part
+    for (int t = 0; t < 12; ++t) {
+      int p = t / 4;
+      int x = pairs3d[p][(t % 4) / 2];
+      int y = pairs3d[p][2 + t % 2];
+      for (int k = 0; k < r; ++k) {
+        for (int l = 0; l < r; ++l) {
+#pragma omp parallel for schedule(static) num_threads(get_num_threads())
+          for (int n = 0; n < niom; ++n) {
+            dcomplex kxb = kf(x, n, k) * kb(p, n, l);
+            for (int m = 0; m < r; ++m) { blk(m, n) = kxb * kf(y, n, m); }
+          }
+          int i0 = t * r3 + k * r2 + l * r;
+          res += omega(_, nda::range(i0, i0 + r)) * blk;
+        }
+      }
+    }
+
+    // Singular part
+    for (int p = 0; p < 3; ++p) {
+      for (int k = 0; k < r; ++k) {
+#pragma omp parallel for schedule(static) num_threads(get_num_threads())
+        for (int n = 0; n < niom; ++n) {
+          for (int m = 0; m < r; ++m) { blk(m, n) = sng(p, n) ? kf(pairs3d[p][0], n, k) * kf(pairs3d[p][2], n, m) : dcomplex(0); }
+        }
+        int i0 = 12 * r3 + p * r2 + k * r;
+        res += omega(_, nda::range(i0, i0 + r)) * blk;
+      }
+    }
+
+    return res;
+  }
+
+  nda::array<int, 2> build_dlr3d_if(double lambda, double eps, int tilesize, int nsketch) {
+
+    // Get DLR frequencies
+    auto dlr_rf = build_dlr_rf(lambda, eps);
+    int r       = dlr_rf.size();              // # DLR basis functions
+    int ncoef   = 12 * r * r * r + 3 * r * r; // # 3D DLR basis functions
+
+    fmt::print("\nDLR cutoff Lambda = {}\n", lambda);
+    fmt::print("DLR tolerance epsilon = {}\n", eps);
+    fmt::print("# DLR basis functions = {}\n", r);
+
+    // Get fine 3D Matsubara frequency sampling grid
+    auto nu3didx = build_dlr3d_if_fine(lambda, dlr_rf);
+    int nfine    = nu3didx.shape(0);
+
+    fmt::print("# fine grid nodes = {}\n", nfine);
+
+    // Columns of (sketched) transposed system matrix, regenerated on demand
+    auto getcols = [&](nda::vector_const_view<int> cols, fmatrix_const_view omega) {
+      auto idx = nda::array<int, 2>(cols.size(), 3);
+      for (int j = 0; j < cols.size(); ++j) { idx(j, _) = nu3didx(cols(j), _); }
+      return build_k3d_if_t_sketch(dlr_rf, idx, omega);
+    };
+
+    auto start    = std::chrono::high_resolution_clock::now();
+    auto skel     = streaming_pivot_sketch(ncoef, nfine, getcols, eps, tilesize, nsketch);
+    auto end      = std::chrono::high_resolution_clock::now();
+    int niom_skel = skel.size();
+
+    // Extract skeleton nodes
+    auto dlr3d_if = nda::array<int, 2>(niom_skel, 3);
+    for (int k = 0; k < niom_skel; ++k) { dlr3d_if(k, _) = nu3didx(skel(k), _); }
+
+    fmt::print("DLR rank cubed = {}\n", r * r * r);
+    fmt::print("System matrix rank = {}\n", niom_skel);
+    fmt::print("Streaming pivoting time = {}\n\n", std::chrono::duration<double>(end - start).count());
+
+    return dlr3d_if;
+  }
+
+  void build_dlr3d_if(double lambda, double eps, std::string path, std::string filename, int tilesize, int nsketch) {
+    auto dlr3d_if = build_dlr3d_if(lambda, eps, tilesize, nsketch);
+
+    // Write dlr3d_if to hdf5 file
+    h5::file file(path + filename, 'w');
+    h5::group mygroup(file);
+    h5::write(mygroup, "dlr3d_if", dlr3d_if);
+  }
+
+  nda::array<int, 2> read_dlr3d_if(std::string path, std::string filename) {
+    h5::file file(path + filename, 'r');
+    h5::group mygroup(file);
+    return h5::read<nda::array<int, 2>>(mygroup, "dlr3d_if");
+  }
+
+  fmatrix build_cf3if(double beta, nda::vector<double> dlr_rf, nda::array<int, 2> dlr3d_if) {
+
+    auto cf3if = fmatrix(transpose(build_k3d_if_t(dlr_rf, dlr3d_if)));
+    cf3if *= beta * beta * beta;
+
+    return cf3if;
+  }
+
+  std::tuple<nda::array<dcomplex, 4>, nda::array<dcomplex, 3>> vals2coefs_if3d(fmatrix cf3if, nda::vector_const_view<dcomplex> vals, int r) {
+
+    int m              = vals.size();
+    int nreg           = 12 * r * r * r;
+    int n              = nreg + 3 * r * r;
+    auto tmp           = nda::array<dcomplex, 1>(std::max(m, n));
+    tmp(nda::range(m)) = vals;
+
+    auto s   = nda::vector<double>(std::min(m, n)); // Singular values (not needed)
+    int rank = 0;                                   // Rank (not needed)
+    nda::lapack::gelss(cf3if, tmp, s, 0.0, rank);
+
+    auto coefreg                = nda::array<dcomplex, 4>(12, r, r, r);
+    auto coefsng                = nda::array<dcomplex, 3>(3, r, r);
+    reshape(coefreg, nreg)      = tmp(nda::range(nreg));
+    reshape(coefsng, 3 * r * r) = tmp(nda::range(nreg, n));
+
+    return {coefreg, coefsng};
+  }
+
+  std::tuple<nda::array<dcomplex, 5>, nda::array<dcomplex, 4>>
+  vals2coefs_if3d_many(fmatrix cf3if, nda::array_const_view<dcomplex, 2, nda::F_layout> vals, int r) {
+
+    int m                 = vals.shape(0);
+    int nrhs              = vals.shape(1);
+    int nreg              = 12 * r * r * r;
+    int n                 = nreg + 3 * r * r;
+    auto tmp              = fmatrix(std::max(m, n), nrhs);
+    tmp(nda::range(m), _) = vals;
+
+    auto s   = nda::vector<double>(std::min(m, n)); // Singular values (not needed)
+    int rank = 0;                                   // Rank (not needed)
+    nda::lapack::gelss(cf3if, tmp, s, 0.0, rank);
+
+    auto coefreg = nda::array<dcomplex, 5>(nrhs, 12, r, r, r);
+    auto coefsng = nda::array<dcomplex, 4>(nrhs, 3, r, r);
+
+    for (int j = 0; j < nrhs; ++j) {
+      reshape(coefreg(j, _, _, _, _), nreg)   = tmp(nda::range(nreg), j);
+      reshape(coefsng(j, _, _, _), 3 * r * r) = tmp(nda::range(nreg, n), j);
+    }
+
+    return {coefreg, coefsng};
+  }
+
+  nda::vector<dcomplex> coefs2eval_if3d(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 4> gc_reg,
+                                        nda::array_const_view<dcomplex, 3> gc_sng, nda::array_const_view<int, 2> idx) {
+
+    int r    = dlr_rf.size(); // # DLR basis functions
+    int r2   = r * r;
+    int npts = idx.shape(0);
+
+    // Make sure coefficient arrays are 12xrxrxr and 3xrxr
+    if (gc_reg.shape(0) != 12 || gc_reg.shape(1) != r || gc_reg.shape(2) != r || gc_reg.shape(3) != r)
+      throw std::runtime_error("Regular coefficient array must be 12 x r x r x r.");
+    if (gc_sng.shape(0) != 3 || gc_sng.shape(1) != r || gc_sng.shape(2) != r)
+      throw std::runtime_error("Singular coefficient array must be 3 x r x r.");
+    if (idx.shape(1) != 3) throw std::runtime_error("Index array must be npts x 3.");
+
+    // 1D kernels at each point: fermionic in each of the four frequencies,
+    // bosonic in the pair sum of each partition
+    auto kf    = std::array<fmatrix, 4>{fmatrix(npts, r), fmatrix(npts, r), fmatrix(npts, r), fmatrix(npts, r)};
+    auto kb    = std::array<fmatrix, 3>{fmatrix(npts, r), fmatrix(npts, r), fmatrix(npts, r)};
+    auto nbsum = nda::array<int, 2>(npts, 3);
+#pragma omp parallel for schedule(static) num_threads(get_num_threads())
+    for (int n = 0; n < npts; ++n) {
+      auto nf = fer_indices(idx(n, 0), idx(n, 1), idx(n, 2));
+      for (int p = 0; p < 3; ++p) { nbsum(n, p) = nf[pairs3d[p][0]] + nf[pairs3d[p][1]] + 1; }
+      for (int k = 0; k < r; ++k) {
+        for (int q = 0; q < 4; ++q) { kf[q](n, k) = k_if(nf[q], dlr_rf(k), Fermion); }
+        for (int p = 0; p < 3; ++p) { kb[p](n, k) = k_if(nbsum(n, p), dlr_rf(k), Boson); }
+      }
+    }
+
+    auto vals = nda::vector<dcomplex>(npts);
+    vals      = 0;
+
+    // Regular part: contract coefficients with kernel in nu_x for all points
+    // at once, then apply kernels in pair sum and nu_y pointwise
+    auto cblk = fmatrix(r, r2);
+    for (int t = 0; t < 12; ++t) {
+      int p = t / 4;
+      int x = pairs3d[p][(t % 4) / 2];
+      int y = pairs3d[p][2 + t % 2];
+      for (int k = 0; k < r; ++k) {
+        for (int l = 0; l < r; ++l) {
+          for (int m = 0; m < r; ++m) { cblk(k, l * r + m) = gc_reg(t, k, l, m); }
+        }
+      }
+      auto d = fmatrix(kf[x] * cblk);
+
+#pragma omp parallel for schedule(static) num_threads(get_num_threads())
+      for (int n = 0; n < npts; ++n) {
+        dcomplex v = 0;
+        for (int l = 0; l < r; ++l) {
+          dcomplex w = 0;
+          for (int m = 0; m < r; ++m) { w += d(n, l * r + m) * kf[y](n, m); }
+          v += kb[p](n, l) * w;
+        }
+        vals(n) += v;
+      }
+    }
+
+    // Singular part, on the planes nu_a + nu_b = 0
+    auto sblk = fmatrix(r, r);
+    for (int p = 0; p < 3; ++p) {
+      for (int k = 0; k < r; ++k) {
+        for (int m = 0; m < r; ++m) { sblk(k, m) = gc_sng(p, k, m); }
+      }
+      auto d = fmatrix(kf[pairs3d[p][0]] * sblk);
+      for (int n = 0; n < npts; ++n) {
+        if (nbsum(n, p) != 0) continue;
+        for (int m = 0; m < r; ++m) { vals(n) += d(n, m) * kf[pairs3d[p][2]](n, m); }
+      }
+    }
+
+    vals *= beta * beta * beta;
+
+    return vals;
+  }
+
+} // namespace dlr2d
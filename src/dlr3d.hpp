@@ -0,0 +1,172 @@
+#pragma once
+
+#include "utils.hpp"
+
+namespace dlr2d {
+
+  /*!
+ * \brief Obtain fine 3D Matsubara frequency grid from combinations of 1D DLR
+ * grid points
+ *
+ * A four-point function of fermionic Matsubara frequencies nu_1, nu_2, nu_3,
+ * nu_4 = -(nu_1 + nu_2 + nu_3) is represented by a 3D DLR expansion with 12
+ * regular terms and 3 singular terms (see \ref build_cf3if). Each regular
+ * term is a product of a fermionic 1D kernel in some nu_x, a bosonic 1D kernel
+ * in the sum nu_x + nu_x' of nu_x and one other frequency, and a fermionic 1D
+ * kernel in one of the remaining two frequencies nu_y. As for \ref
+ * build_dlr2d_if_fine, for each regular term the fine grid contains the r^3
+ * index triples for which the three kernel arguments coincide with 1D DLR
+ * Matsubara frequencies. Duplicate index triples are removed.
+ *
+ * \param[in] lambda  DLR cutoff parameter
+ * \param[in] dlr_rf  1D DLR real frequencies
+ *
+ * \return Fine 3D Matsubara frequency grid as an array containing Mat. freq.
+ * index triples
+ *
+ * \note For a fermionic Matsubara frequency i*nu_n = (2n+1)*pi/beta, we refer
+ * to n as its index. An index triple (n1, n2, n3) corresponds to the 3D
+ * Matsubara frequency point (i nu_n1, i nu_n2, i nu_n3), and the fourth
+ * frequency has index n4 = -n1-n2-n3-2.
+ */
+  nda::array<int, 2> build_dlr3d_if_fine(double lambda, nda::vector_const_view<double> dlr_rf);
+
+  /*!
+ * \brief Build transposed 3D DLR kernel matrix for a set of Matsubara
+ * frequency index triples
+ *
+ * Column j of the returned (12r^3 + 3r^2) x niom matrix contains the values
+ * of the 3D DLR basis functions (12 regular terms followed by 3 singular
+ * terms, in the same order as the columns of \ref build_cf3if) at the index
+ * triple nu3didx(j, _), without the factor beta^3.
+ *
+ * \param[in] dlr_rf  1D DLR real frequencies
+ * \param[in] nu3didx Matsubara frequency index triples
+ *
+ * \return Transposed kernel matrix
+ */
+  fmatrix build_k3d_if_t(nda::vector_const_view<double> dlr_rf, nda::array_const_view<int, 2> nu3didx);
+
+  /*!
+ * \brief Obtain 3D DLR Matsubara frequency grid for four-point functions
+ *
+ * This function generates an HDF5 file in the specified path containing the
+ * 3D DLR Matsubara frequency grid points in terms of Matsubara frequency index
+ * triples.
+ *
+ * It is the 3D analogue of \ref build_dlr2d_if_streaming: the skeleton nodes
+ * are selected from the fine grid of \ref build_dlr3d_if_fine by streaming
+ * pivoting (see \ref streaming_pivot), in tiles of \p tilesize nodes, with the
+ * kernel matrix of each tile regenerated from the separable 1D kernels when
+ * needed (see \ref build_k3d_if_t). With up to 12r^3 fine grid nodes and
+ * 12r^3 + 3r^2 basis functions, the full system matrix is too large to be
+ * stored except for small r. If \p nsketch > 0, the columns of each tile are
+ * compressed to \p nsketch entries by a Gaussian sketch before pivoting, and
+ * \p nsketch is doubled if it turns out to be too small to resolve the rank
+ * (see \ref streaming_pivot_sketch). The sketch is applied to blocks of r rows
+ * of the kernel matrix of a tile as they are generated, so only the sketched
+ * \p nsketch x \p tilesize tile is ever formed.
+ *
+ * \param[in] lambda      DLR cutoff parameter
+ * \param[in] eps         Error tolerance
+ * \param[in] path        Path to directory in which to save 3D DLR Mat. freqs.
+ * \param[in] filename    Name of file in which to save 3D DLR Mat. freqs.
+ * \param[in] tilesize    # fine grid nodes per tile
+ * \param[in] nsketch     Sketch dimension (=0 for no sketching)
+ *
+ * \note See \ref build_dlr3d_if_fine for the index convention.
+ */
+  void build_dlr3d_if(double lambda, double eps, std::string path, std::string filename, int tilesize = 4096, int nsketch = 0);
+
+  nda::array<int, 2> build_dlr3d_if(double lambda, double eps, int tilesize = 4096, int nsketch = 0);
+
+  /*!
+ * \brief Read 3D DLR Matsubara frequency grid from file
+ *
+ * \param[in] path     Path to directory containing 3D DLR Mat. freqs.
+ * \param[in] filename Name of file containing 3D DLR Mat. freqs.
+ *
+ * \return 3D DLR Matsubara frequency grid as an array containing Mat. freq.
+ * index triples
+ *
+ * \note The file should be produced using \ref build_dlr3d_if.
+ */
+  nda::array<int, 2> read_dlr3d_if(std::string path, std::string filename);
+
+  /*!
+ * \brief Build matrix which maps coefficients of a 3D DLR expansion to its
+ * values on the 3D DLR imaginary (Matsubara) frequency grid
+ *
+ * The four frequencies are grouped into the three pair partitions {{1,2},
+ * {3,4}}, {{1,3},{2,4}} and {{1,4},{2,3}}. For partition p = 0, 1, 2, with
+ * pairs {a,b} and {c,d}, the regular terms t = 4p + 2i + j, i, j = 0, 1, are
+ *
+ * beta^3 K_f(nu_x, om_k) K_b(nu_a + nu_b, om_l) K_f(nu_y, om_m),
+ *
+ * where x = a (i = 0) or b (i = 1), and y = c (j = 0) or d (j = 1), with
+ * coefficient index (t, k, l, m). The singular term p is
+ *
+ * beta^3 delta(nu_a + nu_b = 0) K_f(nu_a, om_k) K_f(nu_c, om_m),
+ *
+ * with coefficient index (p, k, m).
+ *
+ * \param[in] beta      Inverse temperature
+ * \param[in] dlr_rf    1D DLR real frequencies
+ * \param[in] dlr3d_if  3D DLR imaginary frequency grid
+ *
+ * \return Coefficients to values matrix
+ */
+  fmatrix build_cf3if(double beta, nda::vector<double> dlr_rf, nda::array<int, 2> dlr3d_if);
+
+  /*!
+ * \brief Transform values of a 3D DLR expansion on the 3D DLR imaginary
+ * (Matsubara) frequency grid to its coefficients
+ *
+ * \param[in] cf3if  Coefficients to values matrix
+ * \param[in] vals   Values of 3D DLR expansion on 3D DLR Mat. freq. grid
+ * \param[in] r      # basis functions in 1D DLR
+ *
+ * \return 3D DLR regular (12 x r x r x r) and singular (3 x r x r) expansion
+ * coefficients
+ *
+ * \note The matrix \p cf3if should be obtained using \ref build_cf3if.
+ */
+  std::tuple<nda::array<dcomplex, 4>, nda::array<dcomplex, 3>> vals2coefs_if3d(fmatrix cf3if, nda::vector_const_view<dcomplex> vals, int r);
+
+  /*!
+ * \brief Transform values of multiple 3D DLR expansions on the 3D DLR
+ * imaginary (Matsubara) frequency grid to their coefficients
+ *
+ * \param[in] cf3if  Coefficients to values matrix
+ * \param[in] vals   Values of 3D DLR expansions on 3D DLR Mat. freq. grid, one
+ * per column
+ * \param[in] r      # basis functions in 1D DLR
+ *
+ * \return 3D DLR regular and singular expansion coefficients, with the index
+ * of the expansion first
+ */
+  std::tuple<nda::array<dcomplex, 5>, nda::array<dcomplex, 4>>
+  vals2coefs_if3d_many(fmatrix cf3if, nda::array_const_view<dcomplex, 2, nda::F_layout> vals, int r);
+
+  /*!
+ * \brief Evaluate a 3D DLR expansion at a batch of Matsubara frequency points
+ *
+ * For each regular term, the coefficients are contracted with the fermionic
+ * 1D kernels in the first argument by a single matrix-matrix product for all
+ * points, and the remaining two kernels are applied pointwise, at total cost
+ * O(npts r^3).
+ *
+ * \param[in] beta    Inverse temperature
+ * \param[in] dlr_rf  1D DLR real frequencies
+ * \param[in] gc_reg  3D DLR regular expansion coefficients
+ * \param[in] gc_sng  3D DLR singular expansion coefficients
+ * \param[in] idx     Matsubara frequency index triples (n1, n2, n3)
+ *
+ * \return Values of 3D DLR expansion at the given points
+ *
+ * \note See \ref build_dlr3d_if_fine for the index convention.
+ */
+  nda::vector<dcomplex> coefs2eval_if3d(double beta, nda::vector<double> dlr_rf, nda::array_const_view<dcomplex, 4> gc_reg,
+                                        nda::array_const_view<dcomplex, 3> gc_sng, nda::array_const_view<int, 2> idx);
+
+} // namespace dlr2d
@@ -0,0 +1,57 @@
+#include "parameters.hpp"
+
+#include <filesystem>
+#include <fmt/format.h>
+
+namespace dlr2d {
+
+  using namespace cppdlr;
+
+  double choose_lambda(double beta, double omega_max) { return std::max(1.0, pow(2.0, std::ceil(std::log2(beta * omega_max)))); }
+
+  double choose_lambda(double beta, std::function<dcomplex(int)> const &g, double eps, double lambda_max) {
+
+    // Sample function on validation grid
+    auto dlr_rf_max = build_dlr_rf(lambda_max, eps);
+    auto ifops_max  = imfreq_ops(lambda_max, dlr_rf_max, Fermion);
+    auto valnodes   = ifops_max.get_ifnodes();
+    int nval        = valnodes.size();
+    auto gval       = nda::vector<dcomplex>(nval);
+    for (int j = 0; j < nval; ++j) { gval(j) = g(valnodes(j)); }
+    double gmax = max_element(abs(gval));
+
+    for (double lambda = 1; lambda < lambda_max; lambda *= 2) {
+
+      // Obtain DLR expansion from samples on DLR grid
+      auto dlr_rf = build_dlr_rf(lambda, eps);
+      auto ifops  = imfreq_ops(lambda, dlr_rf, Fermion);
+      auto nodes  = ifops.get_ifnodes();
+      auto gk     = nda::vector<dcomplex>(nodes.size());
+      for (int k = 0; k < nodes.size(); ++k) { gk(k) = g(nodes(k)); }
+      auto gc = ifops.vals2coefs(beta, gk);
+
+      // Measure error on validation grid
+      double err = 0;
+      for (int j = 0; j < nval; ++j) { err = std::max(err, abs(ifops.coefs2eval(beta, gc, valnodes(j)) - gval(j))); }
+
+      fmt::print("Lambda = {}: relative error = {}\n", lambda, err / gmax);
+      if (err <= 10 * eps * gmax) return lambda;
+    }
+
+    return lambda_max;
+  }
+
+  double choose_eps(double noise) { return std::max(1e-14, pow(10.0, std::floor(std::log10(noise)))); }
+
+  nda::array<int, 2> load_or_build_dlr2d_if(double lambda, double eps, std::string path) {
+
+    auto filename = get_filename(lambda, eps);
+    if (!std::filesystem::exists(path + filename)) {
+      fmt::print("2D DLR grid {} not found; building it...\n", path + filename);
+      build_dlr2d_if(lambda, eps, path, filename);
+    }
+
+    return read_dlr2d_if(path, filename);
+  }
+
+} // namespace dlr2d
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "dlr2d.hpp"
+
+namespace dlr2d {
+
+  /*!
+ * \brief Choose DLR cutoff from a bound on the spectral support
+ *
+ * For a function whose spectral function is supported in [-omega_max,
+ * omega_max], a DLR cutoff lambda = beta * omega_max is sufficient. The result
+ * is rounded up to a power of 2, the cutoffs for which 2D DLR grids are
+ * generated (see generate_dlr2d_if), and is at least 1.
+ *
+ * \param[in] beta      Inverse temperature
+ * \param[in] omega_max Bound on spectral support
+ *
+ * \return DLR cutoff parameter
+ */
+  double choose_lambda(double beta, double omega_max);
+
+  /*!
+ * \brief Choose DLR cutoff from samples of a fermionic 1D function
+ *
+ * For increasing powers of 2, lambda, up to lambda_max, the function is
+ * sampled on the 1D DLR Matsubara frequency grid for lambda, its DLR expansion
+ * is obtained, and the expansion is compared to the function on the 1D DLR
+ * grid for lambda_max. The smallest lambda for which the error is below 10 *
+ * eps, relative to the maximum of the function on the latter grid, is
+ * returned. The 1D Green's function is typically a cheap proxy for the 2D
+ * functions of the same system.
+ *
+ * \param[in] beta       Inverse temperature
+ * \param[in] g          Function of fermionic Matsubara frequency index
+ * \param[in] eps        Error tolerance
+ * \param[in] lambda_max Largest DLR cutoff parameter to consider
+ *
+ * \return DLR cutoff parameter
+ */
+  double choose_lambda(double beta, std::function<dcomplex(int)> const &g, double eps, double lambda_max);
+
+  /*!
+ * \brief Choose DLR tolerance from noise level of data
+ *
+ * Fitting to a tolerance below the noise level of the data increases the DLR
+ * rank without improving accuracy, so eps is chosen as the largest power of 10
+ * not exceeding the noise level, and is at least 1e-14.
+ *
+ * \param[in] noise Noise level of data
+ *
+ * \return DLR tolerance
+ */
+  double choose_eps(double noise);
+
+  /*!
+ * \brief Read 2D DLR Matsubara frequency grid, building it if necessary
+ *
+ * The grid is read from the file named by \ref get_filename in the specified
+ * path if it exists; otherwise, it is built using \ref build_dlr2d_if and
+ * saved to that file for later use.
+ *
+ * \param[in] lambda DLR cutoff parameter
+ * \param[in] eps    Error tolerance
+ * \param[in] path   Path to directory containing 2D DLR grid data
+ *
+ * \return 2D DLR Matsubara frequency grid
+ */
+  nda::array<int, 2> load_or_build_dlr2d_if(double lambda, double eps, std::string path);
+
+} // namespace dlr2d
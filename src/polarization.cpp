@@ -232,6 +232,349 @@ namespace dlr2d {
     return pol;
   }
 
+  polarization_plan::polarization_plan(double beta, double lambda, double eps, imfreq_ops const &ifops_fer, imfreq_ops const &ifops_bos)
+     : beta(beta) {
+
+    auto dlr_rf     = ifops_bos.get_rfnodes();
+    auto dlr_if_fer = ifops_fer.get_ifnodes();
+    auto dlr_if_bos = ifops_bos.get_ifnodes();
+    r               = dlr_rf.size();
+
+    // Get finer DLR tau discretization
+    double lambda2 = 2 * lambda;
+    auto dlr_rf2   = build_dlr_rf(lambda2, eps);
+    r2             = dlr_rf2.size();
+    auto itops2    = imtime_ops(lambda2, dlr_rf2);
+
+    // 1D DLR transforms as dense matrices, obtained by applying them to the
+    // identity
+    auto eye   = nda::matrix<dcomplex>(nda::eye<dcomplex>(r));
+    auto eye2  = nda::matrix<dcomplex>(nda::eye<dcomplex>(r2));
+    cf2iffer   = nda::matrix<dcomplex>(ifops_fer.coefs2vals(beta, eye));
+    cf2itfine  = nda::matrix<dcomplex>(build_k_it(itops2.get_itnodes(), dlr_rf));
+    if2itfine  = cf2itfine * nda::matrix<dcomplex>(ifops_fer.vals2coefs(beta, eye));
+    auto it2cf = nda::matrix<dcomplex>(itops2.vals2coefs(eye2));
+
+    // Fine tau vals -> bosonic imag freq vals
+    auto cffine2if = nda::matrix<dcomplex>(r, r2);
+    for (int k = 0; k < r2; ++k) {
+      for (int j = 0; j < r; ++j) { cffine2if(j, k) = k_if(dlr_if_bos(j), dlr_rf2(k), Boson); }
+    }
+    itfine2ib = beta * cffine2if * it2cf;
+
+    // beta/(i Omega_m - omega_k) and beta/(i nu_n - omega_k)
+    kkif     = nda::matrix<dcomplex>(r, r);
+    knuif    = nda::matrix<dcomplex>(r, r);
+    auto inu = (2 * dlr_if_fer + 1) * pi * 1i;
+    for (int j = 0; j < r; ++j) {
+      for (int k = 0; k < r; ++k) {
+        kkif(j, k)  = beta * k_if_boson(dlr_if_bos(j), dlr_rf(k));
+        knuif(j, k) = beta / (inu(j) - dlr_rf(k));
+      }
+    }
+
+    m0idx = -1;
+    for (int j = 0; j < r; ++j) {
+      if (dlr_if_bos(j) == 0) {
+        m0idx = j;
+        break;
+      }
+    }
+
+    // Workspace
+    fit   = nda::vector<dcomplex>(r2);
+    git   = nda::vector<dcomplex>(r2);
+    fif   = nda::vector<dcomplex>(r);
+    gif   = nda::vector<dcomplex>(r);
+    polit = nda::vector<dcomplex>(r2);
+    pol   = nda::vector<dcomplex>(r);
+    fkif  = nda::matrix<dcomplex>(r, r);
+    gkif  = nda::matrix<dcomplex>(r, r);
+    fkit  = nda::matrix<dcomplex>(r2, r);
+    gkit  = nda::matrix<dcomplex>(r2, r);
+    tmp1  = nda::matrix<dcomplex>(r2, r);
+    tmp2  = nda::matrix<dcomplex>(r2, r);
+    tmp3  = nda::matrix<dcomplex>(r2, r);
+    tmp31 = nda::matrix<dcomplex>(r, r);
+  }
+
+  void polarization_plan::prepare(nda::array_const_view<dcomplex, 1> fc, nda::array_const_view<dcomplex, 1> gc) {
+
+    // F(tau), G(tau), F(i nu_n), G(i nu_n)
+    nda::blas::gemv(1.0, cf2itfine, fc, 0.0, fit);
+    nda::blas::gemv(1.0, cf2itfine, gc, 0.0, git);
+    nda::blas::gemv(1.0, cf2iffer, fc, 0.0, fif);
+    nda::blas::gemv(1.0, cf2iffer, gc, 0.0, gif);
+
+    // F_k(i nu_n) = F(i nu_n)/(i nu_n - omega_k), G_k(i nu_n) = G(i
+    // nu_n)/(i nu_n - omega_k), and their values in tau
+    for (int j = 0; j < r; ++j) {
+      for (int k = 0; k < r; ++k) {
+        fkif(j, k) = fif(j) * knuif(j, k);
+        gkif(j, k) = gif(j) * knuif(j, k);
+      }
+    }
+    nda::blas::gemm(1.0, if2itfine, fkif, 0.0, fkit);
+    nda::blas::gemm(1.0, if2itfine, gkif, 0.0, gkit);
+
+    for (int j = 0; j < r2; ++j) {
+      for (int k = 0; k < r; ++k) {
+        tmp1(j, k) = fit(j) * gkit(j, k);
+        tmp2(j, k) = git(j) * fkit(j, k);
+      }
+    }
+
+    // Contribution to polarization from constant part of vertex
+    for (int j = 0; j < r2; ++j) { polit(j) = fit(j) * git(j); }
+    nda::blas::gemv(1.0, itfine2ib, polit, 0.0, pol);
+  }
+
+  void polarization_plan::add_mixed(nda::array_const_view<dcomplex, 2> lamb1, nda::array_const_view<dcomplex, 2> lamb2,
+                                    nda::array_const_view<dcomplex, 1> lambc_sing) {
+
+    // Terms with a bosonic factor
+    nda::blas::gemm(1.0, tmp1, lamb1, 0.0, tmp3);
+    nda::blas::gemm(1.0, tmp2, lamb2, 1.0, tmp3);
+    nda::blas::gemm(1.0, itfine2ib, tmp3, 0.0, tmp31);
+    for (int j = 0; j < r; ++j) {
+      for (int k = 0; k < r; ++k) { pol(j) += kkif(j, k) * tmp31(j, k); }
+    }
+
+    // Singular part
+    if (m0idx >= 0) {
+      nda::blas::gemv(1.0, tmp2, lambc_sing, 0.0, polit);
+      pol(m0idx) += beta * nda::blas::dot(itfine2ib(m0idx, _), polit);
+    }
+  }
+
+  nda::vector<dcomplex> polarization_plan::execute(nda::array_const_view<dcomplex, 1> fc, nda::array_const_view<dcomplex, 1> gc,
+                                                   nda::array_const_view<dcomplex, 3> lambc, nda::array_const_view<dcomplex, 1> lambc_sing) {
+
+    prepare(fc, gc);
+
+    // First non-constant term of vertex
+    nda::blas::gemm(1.0, fkit, lambc(0, _, _), 0.0, tmp3);
+    for (int j = 0; j < r2; ++j) {
+      polit(j) = 0;
+      for (int k = 0; k < r; ++k) { polit(j) += gkit(j, k) * tmp3(j, k); }
+    }
+    nda::blas::gemv(1.0, itfine2ib, polit, 1.0, pol);
+
+    add_mixed(lambc(1, _, _), lambc(2, _, _), lambc_sing);
+
+    return pol;
+  }
+
+  nda::vector<dcomplex> polarization_plan::execute_3term(nda::array_const_view<dcomplex, 1> fc, nda::array_const_view<dcomplex, 1> gc,
+                                                         nda::array_const_view<dcomplex, 3> lambc, nda::array_const_view<dcomplex, 1> lambc_sing) {
+
+    prepare(fc, gc);
+    add_mixed(lambc(0, _, _), lambc(1, _, _), lambc_sing);
+
+    return pol;
+  }
+
+  polarization_res_plan::polarization_res_plan(double beta, imfreq_ops const &ifops_fer, imfreq_ops const &ifops_bos) {
+
+    auto dlr_rf     = ifops_fer.get_rfnodes();
+    auto dlr_if_fer = ifops_fer.get_ifnodes();
+    auto dlr_if_bos = ifops_bos.get_ifnodes();
+    r               = dlr_rf.size();
+    auto ej         = dlr_rf / beta; // Convert to physical units
+    auto om_dlr     = (2 * dlr_if_bos * pi * 1i) / beta;
+
+    // Pole denominators
+    hilb    = nda::matrix<dcomplex>(r, r);
+    hilbm   = nda::array<dcomplex, 3>(r, r, r);
+    hilbmsq = nda::array<dcomplex, 3>(r, r, r);
+    for (int j = 0; j < r; ++j) {
+      for (int k = 0; k < r; ++k) { hilb(j, k) = (j == k) ? 0.0 : 1.0 / (ej(j) - ej(k)); }
+    }
+    for (int m = 0; m < r; ++m) {
+      for (int j = 0; j < r; ++j) {
+        for (int k = 0; k < r; ++k) {
+          hilbm(m, j, k)   = 1.0 / (om_dlr(m) - ej(j) - ej(k));
+          hilbmsq(m, j, k) = hilbm(m, j, k) * hilbm(m, j, k);
+        }
+      }
+    }
+
+    // Fermi factors and their derivatives
+    nf   = nda::vector<double>(r);
+    nfm  = nda::vector<double>(r);
+    nfp  = nda::vector<double>(r);
+    nfpm = nda::vector<double>(r);
+    for (int j = 0; j < r; ++j) {
+      nf(j)   = -k_it(0.0, beta * ej(j));
+      nfm(j)  = -k_it(0.0, -ej(j), beta);
+      nfp(j)  = beta * k_it(0.0, ej(j), beta) * k_it(1.0, ej(j), beta);
+      nfpm(j) = beta * k_it(0.0, -ej(j), beta) * k_it(1.0, -ej(j), beta);
+    }
+
+    tanhlm = nda::matrix<dcomplex>(r, r);
+    for (int l = 0; l < r; ++l) {
+      for (int m = 0; m < r; ++m) { tanhlm(l, m) = tanh(beta * ej(l) / 2) / (om_dlr(m) - ej(l)); }
+    }
+
+    m0idx = -1;
+    for (int m = 0; m < r; ++m) {
+      if (dlr_if_bos(m) == 0) {
+        m0idx = m;
+        break;
+      }
+    }
+
+    // Zero bosonic frequency: Green's functions at i nu_k and -i nu_k, and
+    // vertex at (i nu_k, -i nu_k), as dense matrices, and fermionic imag freq
+    // vals -> tau = 0 value
+    cf2ifpos  = nda::matrix<dcomplex>(r, r);
+    cf2ifneg  = nda::matrix<dcomplex>(r, r);
+    auto unit = nda::vector<dcomplex>(r);
+    for (int l = 0; l < r; ++l) {
+      unit    = 0;
+      unit(l) = 1;
+      for (int k = 0; k < r; ++k) {
+        cf2ifpos(k, l) = ifops_fer.coefs2eval(beta, unit, dlr_if_fer(k));
+        cf2ifneg(k, l) = ifops_fer.coefs2eval(beta, unit, -dlr_if_fer(k) - 1);
+      }
+    }
+
+    auto idx0 = nda::array<int, 2>(r, 2);
+    for (int k = 0; k < r; ++k) {
+      idx0(k, 0) = dlr_if_fer(k);
+      idx0(k, 1) = -dlr_if_fer(k) - 1;
+    }
+    cf2if0 = build_cf2if(beta, dlr_rf, idx0);
+
+    auto kit0 = nda::vector<dcomplex>(r);
+    for (int k = 0; k < r; ++k) { kit0(k) = k_it(0.0, ej(k), beta); }
+    auto eye = nda::matrix<dcomplex>(nda::eye<dcomplex>(r));
+    if2pol0  = transpose(nda::matrix<dcomplex>(ifops_fer.vals2coefs(beta, eye))) * kit0;
+
+    // Workspace
+    lamb0jl    = nda::matrix<dcomplex>(r, r);
+    lamb0jk    = nda::matrix<dcomplex>(r, r);
+    lamb0mj    = nda::matrix<dcomplex>(r, r);
+    lamb0mjsq  = nda::matrix<dcomplex>(r, r);
+    lamb0mj2   = nda::matrix<dcomplex>(r, r);
+    lamb0mj2sq = nda::matrix<dcomplex>(r, r);
+    lamb1km    = nda::matrix<dcomplex>(r, r);
+    lamb2km    = nda::matrix<dcomplex>(r, r);
+    hilbf      = nda::vector<dcomplex>(r);
+    hilbg      = nda::vector<dcomplex>(r);
+    hf         = nda::vector<dcomplex>(r);
+    hg         = nda::vector<dcomplex>(r);
+    hfsq       = nda::vector<dcomplex>(r);
+    hgsq       = nda::vector<dcomplex>(r);
+    hl1        = nda::vector<dcomplex>(r);
+    hl2        = nda::vector<dcomplex>(r);
+    hilbl1     = nda::vector<dcomplex>(r);
+    hilbl2     = nda::vector<dcomplex>(r);
+    rsum1      = nda::vector<dcomplex>(r);
+    rsum2      = nda::vector<dcomplex>(r);
+    pol        = nda::vector<dcomplex>(r);
+    lambv      = nda::vector<dcomplex>(3 * r * r + r);
+  }
+
+  nda::vector<dcomplex> polarization_res_plan::execute(nda::array_const_view<dcomplex, 1> fc, nda::array_const_view<dcomplex, 1> gc,
+                                                       nda::array_const_view<dcomplex, 3> lambc, nda::array_const_view<dcomplex, 1> lambc_sing) {
+
+    // Contractions of vertex coefficients with pole denominators (see
+    // polarization_res)
+    nda::blas::gemm(1.0, hilb, lambc(0, _, _), 0.0, lamb0jl);
+    nda::blas::gemm(1.0, lambc(1, _, _), tanhlm, 0.0, lamb1km);
+    nda::blas::gemm(1.0, lambc(2, _, _), tanhlm, 0.0, lamb2km);
+    for (int j = 0; j < r; ++j) {
+      for (int k = 0; k < r; ++k) {
+        lamb0jk(j, k) = 0;
+        for (int l = 0; l < r; ++l) { lamb0jk(j, k) += lambc(0, k, l) * hilb(j, l); }
+      }
+    }
+    for (int m = 0; m < r; ++m) {
+      for (int j = 0; j < r; ++j) {
+        lamb0mj(m, j)    = 0;
+        lamb0mjsq(m, j)  = 0;
+        lamb0mj2(m, j)   = 0;
+        lamb0mj2sq(m, j) = 0;
+        for (int l = 0; l < r; ++l) {
+          lamb0mj(m, j) += lambc(0, j, l) * hilbm(m, j, l);
+          lamb0mjsq(m, j) += lambc(0, j, l) * hilbmsq(m, j, l);
+          lamb0mj2(m, j) += lambc(0, l, j) * hilbm(m, j, l);
+          lamb0mj2sq(m, j) += lambc(0, l, j) * hilbmsq(m, j, l);
+        }
+      }
+    }
+    nda::blas::gemv(1.0, hilb, fc, 0.0, hilbf);
+    nda::blas::gemv(1.0, hilb, gc, 0.0, hilbg);
+
+    // Residues at nonzero bosonic frequencies, for all terms of the vertex
+    pol = 0;
+    for (int m = 0; m < r; ++m) {
+      if (m == m0idx) { continue; }
+
+      auto hm   = hilbm(m, _, _);
+      auto hmsq = hilbmsq(m, _, _);
+      nda::blas::gemv(1.0, hm, fc, 0.0, hf);
+      nda::blas::gemv(1.0, hm, gc, 0.0, hg);
+      nda::blas::gemv(1.0, hmsq, fc, 0.0, hfsq);
+      nda::blas::gemv(1.0, hmsq, gc, 0.0, hgsq);
+      nda::blas::gemv(1.0, hm, lamb1km(_, m), 0.0, hl1);
+      nda::blas::gemv(1.0, hm, lamb2km(_, m), 0.0, hl2);
+      nda::blas::gemv(1.0, hilb, lamb1km(_, m), 0.0, hilbl1);
+      nda::blas::gemv(1.0, hilb, lamb2km(_, m), 0.0, hilbl2);
+      for (int j = 0; j < r; ++j) {
+        rsum1(j) = 0;
+        rsum2(j) = 0;
+        for (int k = 0; k < r; ++k) {
+          rsum1(j) += hm(j, k) * lamb0jl(j, k);
+          rsum2(j) += hm(j, k) * lamb0jk(j, k);
+        }
+      }
+
+      dcomplex p = 0;
+      for (int j = 0; j < r; ++j) {
+        auto l0 = lamb0mj(m, j), l0sq = lamb0mjsq(m, j), l02 = lamb0mj2(m, j), l02sq = lamb0mj2sq(m, j);
+        auto l1 = lamb1km(j, m), l2 = lamb2km(j, m);
+
+        // First term
+        p += nf(j) * hg(j) * (fc(j) * rsum1(j) + hilbf(j) * l0);
+        p += fc(j) * (nfp(j) * hg(j) * l0 + nf(j) * hgsq(j) * l0 + nf(j) * hg(j) * l0sq);
+        p -= nfm(j) * hf(j) * (gc(j) * rsum2(j) + hilbg(j) * l02);
+        p += gc(j) * (nfpm(j) * hf(j) * l02 - nfm(j) * hfsq(j) * l02 - nfm(j) * hf(j) * l02sq);
+
+        // Second term
+        p += fc(j) * nf(j) * hg(j) * hl1(j);
+        p -= nfm(j) * hf(j) * (gc(j) * hilbl1(j) + hilbg(j) * l1);
+        p += gc(j) * l1 * (nfpm(j) * hf(j) - nfm(j) * hfsq(j));
+
+        // Third term
+        p -= gc(j) * nfm(j) * hf(j) * hl2(j);
+        p += nf(j) * hg(j) * (fc(j) * hilbl2(j) + hilbf(j) * l2);
+        p += fc(j) * l2 * (nfp(j) * hg(j) + nf(j) * hgsq(j));
+      }
+      pol(m) = -p;
+    }
+
+    // Zero bosonic frequency, from summand F(i nu_k) G(-i nu_k) Lambda(i nu_k,
+    // -i nu_k) on the fermionic grid, evaluated at tau = 0
+    if (m0idx >= 0) {
+      for (int t = 0; t < 3; ++t) {
+        for (int k = 0; k < r; ++k) {
+          for (int l = 0; l < r; ++l) { lambv((t * r + k) * r + l) = lambc(t, k, l); }
+        }
+      }
+      lambv(nda::range(3 * r * r, 3 * r * r + r)) = lambc_sing;
+      nda::blas::gemv(1.0, cf2ifpos, fc, 0.0, hf);
+      nda::blas::gemv(1.0, cf2ifneg, gc, 0.0, hg);
+      nda::blas::gemv(1.0, cf2if0, lambv, 0.0, rsum1);
+
+      pol(m0idx) = 0;
+      for (int k = 0; k < r; ++k) { pol(m0idx) += if2pol0(k) * hf(k) * hg(k) * rsum1(k); }
+    }
+
+    return pol;
+  }
+
   // Compute polarization
   nda::vector<dcomplex> polarization_res(double beta, imfreq_ops const &ifops_fer, imfreq_ops const &ifops_bos, nda::array_const_view<dcomplex, 1> fc,
                                          nda::array_const_view<dcomplex, 1> gc, nda::array_const_view<dcomplex, 3> lambc,
@@ -16,7 +16,148 @@ namespace dlr2d {
                                            nda::array_const_view<dcomplex, 1> fc, nda::array_const_view<dcomplex, 1> gc,
                                            nda::array_const_view<dcomplex, 3> lambc, nda::array_const_view<dcomplex, 1> lambc_sing);
 
-  // Compute polarization by residue calculus-based algorithm
+  /*!
+ * \brief Precomputed data and workspace for repeated evaluation of the
+ * polarization by the convolution-based algorithm
+ *
+ * The functions \ref polarization and \ref polarization_3term rebuild a finer
+ * DLR imaginary time discretization and several transformation matrices, and
+ * allocate about a dozen intermediate arrays, on every call. This class builds
+ * everything that depends only on beta, lambda, eps and the 1D DLR grids once,
+ * folding the 1D DLR transforms into dense matrices, and keeps all
+ * intermediate arrays as members, which are overwritten in place by BLAS
+ * calls. A call to \ref execute then allocates only the returned vector.
+ *
+ * Since the workspace is shared between calls, a plan must not be used by
+ * several threads at once; concurrent callers should each use their own plan.
+ *
+ * \note The residue calculus-based algorithm has its own plan, \ref
+ * polarization_res_plan. The 2D DLR fit of the vertex is not part of a plan;
+ * for repeated fits on a fixed grid, \ref dlr2d_if_ops::vals2coefs reuses a
+ * precomputed pseudoinverse in place of \ref vals2coefs_if.
+ */
+  class polarization_plan {
+
+    public:
+    /*!
+   * \brief Constructor
+   *
+   * \param[in] beta      Inverse temperature
+   * \param[in] lambda    DLR cutoff parameter
+   * \param[in] eps       Error tolerance
+   * \param[in] ifops_fer Fermionic 1D DLR imaginary frequency operations object
+   * \param[in] ifops_bos Bosonic 1D DLR imaginary frequency operations object
+   */
+    polarization_plan(double beta, double lambda, double eps, cppdlr::imfreq_ops const &ifops_fer, cppdlr::imfreq_ops const &ifops_bos);
+
+    /*!
+   * \brief Compute polarization, as in \ref polarization
+   *
+   * \param[in] fc         1D DLR coefficients of first Green's function
+   * \param[in] gc         1D DLR coefficients of second Green's function
+   * \param[in] lambc      2D DLR regular expansion coefficients of vertex
+   * \param[in] lambc_sing 1D DLR singular expansion coefficients of vertex
+   *
+   * \return Polarization on bosonic 1D DLR Matsubara frequency grid
+   */
+    nda::vector<dcomplex> execute(nda::array_const_view<dcomplex, 1> fc, nda::array_const_view<dcomplex, 1> gc,
+                                  nda::array_const_view<dcomplex, 3> lambc, nda::array_const_view<dcomplex, 1> lambc_sing);
+
+    /*!
+   * \brief Compute polarization using 3 term Lehmann representation, as in
+   * \ref polarization_3term
+   */
+    nda::vector<dcomplex> execute_3term(nda::array_const_view<dcomplex, 1> fc, nda::array_const_view<dcomplex, 1> gc,
+                                        nda::array_const_view<dcomplex, 3> lambc, nda::array_const_view<dcomplex, 1> lambc_sing);
+
+    private:
+    double beta;                     ///< Inverse temperature
+    int r;                           ///< # basis functions in 1D DLR
+    int r2;                          ///< # basis functions in finer 1D DLR
+    int m0idx;                       ///< Index of zero bosonic frequency in bosonic grid (-1 if none)
+    nda::matrix<dcomplex> cf2iffer;  ///< Coefs -> fermionic imag freq vals
+    nda::matrix<dcomplex> cf2itfine; ///< Coefs -> fine tau vals
+    nda::matrix<dcomplex> if2itfine; ///< Fermionic imag freq vals -> fine tau vals
+    nda::matrix<dcomplex> itfine2ib; ///< Fine tau vals -> bosonic imag freq vals, times beta
+    nda::matrix<dcomplex> kkif;      ///< beta/(i Omega_m - omega_k)
+    nda::matrix<dcomplex> knuif;     ///< beta/(i nu_n - omega_k)
+
+    // Workspace
+    nda::vector<dcomplex> fit, git, fif, gif, polit, pol;
+    nda::matrix<dcomplex> fkif, gkif, fkit, gkit, tmp1, tmp2, tmp3, tmp31;
+
+    // Fill fit, git, fkit, gkit, tmp1, tmp2, and initialize pol with
+    // contribution of constant part of vertex
+    void prepare(nda::array_const_view<dcomplex, 1> fc, nda::array_const_view<dcomplex, 1> gc);
+
+    // Add contribution of second and third (or first and second, for 3 term
+    // representation) non-constant terms, and singular part, of vertex
+    void add_mixed(nda::array_const_view<dcomplex, 2> lamb1, nda::array_const_view<dcomplex, 2> lamb2,
+                   nda::array_const_view<dcomplex, 1> lambc_sing);
+  };
+
+  /*!
+ * \brief Precomputed data and workspace for repeated evaluation of the
+ * polarization by the residue calculus-based algorithm
+ *
+ * The function \ref polarization_res builds the r x r x r pole denominators,
+ * the Fermi factors, and about ten r x r intermediate arrays on every call,
+ * and allocates further temporaries in its loops over bosonic frequencies.
+ * This class builds everything that depends only on beta and the 1D DLR grids
+ * once, including the evaluation of the vertex at the zero bosonic frequency
+ * as a dense matrix, and keeps all intermediate arrays as members, which are
+ * overwritten in place. A call to \ref execute then allocates only the
+ * returned vector.
+ *
+ * As for \ref polarization_plan, a plan must not be used by several threads
+ * at once.
+ */
+  class polarization_res_plan {
+
+    public:
+    /*!
+   * \brief Constructor
+   *
+   * \param[in] beta      Inverse temperature
+   * \param[in] ifops_fer Fermionic 1D DLR imaginary frequency operations object
+   * \param[in] ifops_bos Bosonic 1D DLR imaginary frequency operations object
+   */
+    polarization_res_plan(double beta, cppdlr::imfreq_ops const &ifops_fer, cppdlr::imfreq_ops const &ifops_bos);
+
+    /*!
+   * \brief Compute polarization, as in \ref polarization_res
+   *
+   * \param[in] fc         1D DLR coefficients of first Green's function
+   * \param[in] gc         1D DLR coefficients of second Green's function
+   * \param[in] lambc      2D DLR regular expansion coefficients of vertex
+   * \param[in] lambc_sing 1D DLR singular expansion coefficients of vertex
+   *
+   * \return Polarization on bosonic 1D DLR Matsubara frequency grid
+   */
+    nda::vector<dcomplex> execute(nda::array_const_view<dcomplex, 1> fc, nda::array_const_view<dcomplex, 1> gc,
+                                  nda::array_const_view<dcomplex, 3> lambc, nda::array_const_view<dcomplex, 1> lambc_sing);
+
+    private:
+    int r;                           ///< # basis functions in 1D DLR
+    int m0idx;                       ///< Index of zero bosonic frequency in bosonic grid (-1 if none)
+    nda::matrix<dcomplex> hilb;      ///< 1/(E_j - E_k) for j /= k, 0 for j = k
+    nda::array<dcomplex, 3> hilbm;   ///< 1/(i omega_m - E_j - E_k)
+    nda::array<dcomplex, 3> hilbmsq; ///< 1/(i omega_m - E_j - E_k)^2
+    nda::vector<double> nf, nfm;     ///< Fermi factors n(E_j), n(-E_j)
+    nda::vector<double> nfp, nfpm;   ///< beta n(E_j) (1 - n(E_j)), and same for -E_j
+    nda::matrix<dcomplex> tanhlm;    ///< tanh(beta E_l/2)/(i omega_m - E_l)
+    nda::matrix<dcomplex> cf2ifpos;  ///< Coefs -> vals at i nu_k
+    nda::matrix<dcomplex> cf2ifneg;  ///< Coefs -> vals at -i nu_k
+    fmatrix cf2if0;                  ///< 2D DLR coefs -> vertex at (i nu_k, -i nu_k)
+    nda::vector<dcomplex> if2pol0;   ///< Fermionic imag freq vals -> value at tau = 0
+
+    // Workspace
+    nda::matrix<dcomplex> lamb0jl, lamb0jk, lamb0mj, lamb0mjsq, lamb0mj2, lamb0mj2sq, lamb1km, lamb2km;
+    nda::vector<dcomplex> hilbf, hilbg, hf, hg, hfsq, hgsq, hl1, hl2, hilbl1, hilbl2, rsum1, rsum2, lambv, pol;
+  };
+
+  // Compute polarization by residue calculus-based algorithm. For repeated
+  // calls, see polarization_res_plan.
   nda::vector<dcomplex> polarization_res(double beta, cppdlr::imfreq_ops const &ifops_fer, cppdlr::imfreq_ops const &ifops_bos,
                                          nda::array_const_view<dcomplex, 1> fc, nda::array_const_view<dcomplex, 1> gc,
                                          nda::array_const_view<dcomplex, 3> lambc, nda::array_const_view<dcomplex, 1> lambc_sing);
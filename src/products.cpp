@@ -0,0 +1,130 @@
+#include "products.hpp"
+
+namespace dlr2d {
+
+  using namespace cppdlr;
+
+  dlr2d_if_ops::dlr2d_if_ops(double beta, nda::vector<double> dlr_rf, nda::array<int, 2> dlr2d_if)
+     : beta(beta), r(dlr_rf.size()), dlr2d_if(dlr2d_if), op(beta, dlr_rf, dlr2d_if) {
+
+    int niom  = dlr2d_if.shape(0);
+    int ncoef = 3 * r * r + r;
+
+    // Pseudoinverse of coefficients to values matrix, from least squares
+    // solution with identity right hand side
+    auto cf2if = build_cf2if(beta, dlr_rf, dlr2d_if);
+    auto tmp   = fmatrix(std::max(niom, ncoef), niom);
+    tmp        = 0;
+    for (int i = 0; i < niom; ++i) { tmp(i, i) = 1; }
+
+    auto s   = nda::vector<double>(std::min(niom, ncoef)); // Singular values (not needed)
+    int rank = 0;                                          // Rank (not needed)
+    nda::lapack::gelss(cf2if, tmp, s, 0.0, rank);
+
+    pinv = tmp(nda::range(ncoef), _);
+  }
+
+  std::tuple<nda::array<dcomplex, 3>, nda::array<dcomplex, 1>> dlr2d_if_ops::vals2coefs(nda::vector_const_view<dcomplex> vals) const {
+
+    auto coef = nda::vector<dcomplex>(pinv * vals);
+
+    auto coefreg                = nda::array<dcomplex, 3>(3, r, r);
+    auto coefsng                = nda::array<dcomplex, 1>(r);
+    reshape(coefreg, 3 * r * r) = coef(nda::range(3 * r * r));
+    coefsng                     = coef(nda::range(3 * r * r, 3 * r * r + r));
+
+    return {coefreg, coefsng};
+  }
+
+  std::tuple<nda::array<dcomplex, 4>, nda::array<dcomplex, 2>> dlr2d_if_ops::vals2coefs_many(fmatrix_const_view vals) const {
+
+    int nrhs  = vals.shape(1);
+    auto coef = fmatrix(pinv * vals);
+
+    auto coefreg = nda::array<dcomplex, 4>(nrhs, 3, r, r);
+    auto coefsng = nda::array<dcomplex, 2>(nrhs, r);
+
+    for (int j = 0; j < nrhs; ++j) {
+      reshape(coefreg(j, _, _, _), 3 * r * r) = coef(nda::range(3 * r * r), j);
+      coefsng(j, _)                           = coef(nda::range(3 * r * r, 3 * r * r + r), j);
+    }
+
+    return {coefreg, coefsng};
+  }
+
+  nda::vector<dcomplex> dlr2d_if_ops::vals_1d(imfreq_ops const &ifops, nda::array_const_view<dcomplex, 1> gc, int leg, int channel) const {
+
+    if (channel != 1 && channel != 2) throw std::runtime_error("Invalid channel for vals_1d.");
+    if (leg < 0 || leg > 2) throw std::runtime_error("Leg must be 0, 1 or 2.");
+
+    int niom  = dlr2d_if.shape(0);
+    auto vals = nda::vector<dcomplex>(niom);
+    for (int i = 0; i < niom; ++i) {
+      // Index pair (m, n) in the convention of the channel
+      int m = (channel == 1) ? dlr2d_if(i, 0) : -dlr2d_if(i, 0) - 1;
+      int n = dlr2d_if(i, 1);
+      // Bosonic frequency of the channel, nu1 + nu2 or nu2 - nu1
+      int mn  = (channel == 1) ? m + n + 1 : n - m;
+      int idx = (leg == 0) ? m : ((leg == 1) ? n : mn);
+      vals(i) = ifops.coefs2eval(beta, gc, idx);
+    }
+
+    return vals;
+  }
+
+  // Values of gl(nu1) gr(nu2) on 2D DLR grid, with (nu1, nu2) in the
+  // convention of the channel
+  static nda::vector<dcomplex> vals_pair(dlr2d_if_ops const &ops, imfreq_ops const &ifops_fer, nda::array_const_view<dcomplex, 1> gl,
+                                         nda::array_const_view<dcomplex, 1> gr, int channel) {
+    auto vl = ops.vals_1d(ifops_fer, gl, 0, channel);
+    auto vr = ops.vals_1d(ifops_fer, gr, 1, channel);
+    for (int i = 0; i < vl.size(); ++i) { vl(i) *= vr(i); }
+    return vl;
+  }
+
+  std::tuple<nda::array<dcomplex, 3>, nda::array<dcomplex, 1>> mul_if(dlr2d_if_ops const &ops, imfreq_ops const &ifops_fer,
+                                                                      nda::array_const_view<dcomplex, 1> gl, nda::array_const_view<dcomplex, 1> gr,
+                                                                      nda::array_const_view<dcomplex, 3> gc_reg,
+                                                                      nda::array_const_view<dcomplex, 1> gc_sng, int channel) {
+    auto p    = vals_pair(ops, ifops_fer, gl, gr, channel);
+    auto vals = ops.coefs2vals(gc_reg, gc_sng);
+    for (int i = 0; i < vals.size(); ++i) { vals(i) *= p(i); }
+    return ops.vals2coefs(vals);
+  }
+
+  std::tuple<nda::array<dcomplex, 3>, nda::array<dcomplex, 1>> div_if(dlr2d_if_ops const &ops, imfreq_ops const &ifops_fer,
+                                                                      nda::array_const_view<dcomplex, 1> gl, nda::array_const_view<dcomplex, 1> gr,
+                                                                      nda::array_const_view<dcomplex, 3> gc_reg,
+                                                                      nda::array_const_view<dcomplex, 1> gc_sng, int channel) {
+    auto p    = vals_pair(ops, ifops_fer, gl, gr, channel);
+    auto vals = ops.coefs2vals(gc_reg, gc_sng);
+    for (int i = 0; i < vals.size(); ++i) { vals(i) /= p(i); }
+    return ops.vals2coefs(vals);
+  }
+
+  std::tuple<nda::array<dcomplex, 3>, nda::array<dcomplex, 1>> mul_if(dlr2d_if_ops const &ops, nda::array_const_view<dcomplex, 3> f_reg,
+                                                                      nda::array_const_view<dcomplex, 1> f_sng, nda::array_const_view<dcomplex, 3> g_reg,
+                                                                      nda::array_const_view<dcomplex, 1> g_sng) {
+    auto vals = ops.coefs2vals(f_reg, f_sng);
+    auto gv   = ops.coefs2vals(g_reg, g_sng);
+    for (int i = 0; i < vals.size(); ++i) { vals(i) *= gv(i); }
+    return ops.vals2coefs(vals);
+  }
+
+  std::tuple<nda::array<dcomplex, 4>, nda::array<dcomplex, 2>> mul_if_many(dlr2d_if_ops const &ops, imfreq_ops const &ifops_fer,
+                                                                           nda::array_const_view<dcomplex, 1> gl, nda::array_const_view<dcomplex, 1> gr,
+                                                                           nda::array_const_view<dcomplex, 4> gc_reg,
+                                                                           nda::array_const_view<dcomplex, 2> gc_sng, int channel) {
+
+    int nf   = gc_reg.shape(0);
+    auto p   = vals_pair(ops, ifops_fer, gl, gr, channel);
+    auto all = fmatrix(p.size(), nf);
+    for (int j = 0; j < nf; ++j) {
+      auto vals = ops.coefs2vals(gc_reg(j, _, _, _), gc_sng(j, _));
+      for (int i = 0; i < vals.size(); ++i) { all(i, j) = vals(i) * p(i); }
+    }
+
+    return ops.vals2coefs_many(all);
+  }
+
+} // namespace dlr2d
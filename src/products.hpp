@@ -0,0 +1,200 @@
+#pragma once
+
+#include "cf2if_operator.hpp"
+
+namespace dlr2d {
+
+  /*!
+ * \brief Operations on 2D DLR expansions through their values on the 2D DLR
+ * Matsubara frequency grid
+ *
+ * This class holds a fixed 2D DLR Matsubara frequency grid with a cached
+ * factorization of the corresponding least squares problem, in the form of the
+ * pseudoinverse of the matrix returned by \ref build_cf2if, which is computed
+ * once by the same SVD-based solver as \ref vals2coefs_if. Transforming values
+ * on the grid to coefficients then reduces to a matrix-vector product, or to a
+ * single matrix-matrix product for several functions at once, and values on
+ * the grid are obtained from coefficients by a \ref cf2if_operator.
+ *
+ * Pointwise operations on expansions, such as multiplying a vertex function
+ * by G(nu1) G(nu2), are carried out by sampling the factors on the grid and
+ * refitting, at cost O(niom r^2), without passing through a dense box of
+ * Matsubara frequencies (see \ref mul_if). The result is only accurate if the
+ * product is itself representable by a 2D DLR expansion.
+ */
+  class dlr2d_if_ops {
+
+    public:
+    /*!
+   * \brief Constructor
+   *
+   * \param[in] beta     Inverse temperature
+   * \param[in] dlr_rf   1D DLR real frequencies
+   * \param[in] dlr2d_if 2D DLR Matsubara frequency grid
+   */
+    dlr2d_if_ops(double beta, nda::vector<double> dlr_rf, nda::array<int, 2> dlr2d_if);
+
+    /*!
+   * \brief Transform values of a 2D DLR expansion on the 2D DLR grid to its
+   * coefficients
+   *
+   * \param[in] vals Values of 2D DLR expansion on 2D DLR Mat. freq. grid
+   *
+   * \return 2D DLR regular and singular expansion coefficients
+   */
+    std::tuple<nda::array<dcomplex, 3>, nda::array<dcomplex, 1>> vals2coefs(nda::vector_const_view<dcomplex> vals) const;
+
+    /*!
+   * \brief Transform values of multiple 2D DLR expansions on the 2D DLR grid
+   * to their coefficients
+   *
+   * \param[in] vals Values of 2D DLR expansions on 2D DLR Mat. freq. grid, one
+   * per column
+   *
+   * \return 2D DLR regular and singular expansion coefficients, in the format
+   * of \ref vals2coefs_if_many
+   */
+    std::tuple<nda::array<dcomplex, 4>, nda::array<dcomplex, 2>> vals2coefs_many(fmatrix_const_view vals) const;
+
+    /*!
+   * \brief Evaluate a 2D DLR expansion on the 2D DLR grid
+   *
+   * \param[in] gc_reg 2D DLR regular expansion coefficients
+   * \param[in] gc_sng 1D DLR singular expansion coefficients
+   *
+   * \return Values of 2D DLR expansion on 2D DLR Mat. freq. grid
+   */
+    nda::vector<dcomplex> coefs2vals(nda::array_const_view<dcomplex, 3> gc_reg, nda::array_const_view<dcomplex, 1> gc_sng) const {
+      return op.apply(gc_reg, gc_sng);
+    }
+
+    /*!
+   * \brief Evaluate a 1D DLR expansion on one leg of the 2D DLR grid
+   *
+   * Each grid point is labelled by the index pair (m, n) in the convention of
+   * the channel, i.e. the pair at which \ref coefs2eval_if with the same
+   * channel evaluates the expansion at that point: a grid point (a, b) has (m,
+   * n) = (a, b) in the particle-particle channel and (m, n) = (-a-1, b) in the
+   * particle-hole channel. The 1D expansion is evaluated at index m (leg = 0),
+   * n (leg = 1), or at the bosonic frequency of the channel (leg = 2), which
+   * is nu1 + nu2, with index m+n+1, in the particle-particle channel, and nu2
+   * - nu1, with index n-m, in the particle-hole channel. The statistics of the
+   * expansion, fermionic for legs 0 and 1 and bosonic for leg 2, are those of
+   * \p ifops.
+   *
+   * \param[in] ifops   1D DLR imaginary frequency operations object
+   * \param[in] gc      1D DLR expansion coefficients
+   * \param[in] leg     Leg of 2D DLR grid (=0, 1 or 2)
+   * \param[in] channel Channel index (=1 for particle-particle, =2 for
+   * particle-hole)
+   *
+   * \return Values of 1D DLR expansion on 2D DLR Mat. freq. grid
+   */
+    nda::vector<dcomplex> vals_1d(cppdlr::imfreq_ops const &ifops, nda::array_const_view<dcomplex, 1> gc, int leg, int channel) const;
+
+    /*!
+   * \brief Get 2D DLR Matsubara frequency grid
+   *
+   * \return 2D DLR Matsubara frequency grid
+   */
+    nda::array_const_view<int, 2> get_dlr2d_if() const { return dlr2d_if; }
+
+    /*!
+   * \brief Get # basis functions in 1D DLR
+   *
+   * \return # basis functions in 1D DLR
+   */
+    int rank() const { return r; }
+
+    private:
+    double beta;                 ///< Inverse temperature
+    int r;                       ///< # basis functions in 1D DLR
+    nda::array<int, 2> dlr2d_if; ///< 2D DLR Matsubara frequency grid
+    cf2if_operator op;           ///< Coefficients to values operator
+    fmatrix pinv;                ///< Pseudoinverse of coefficients to values matrix
+  };
+
+  /*!
+ * \brief Multiply a 2D DLR expansion by 1D DLR expansions in its two fermionic
+ * arguments
+ *
+ * The coefficients of gl(nu1) gr(nu2) f(nu1, nu2) are obtained by sampling
+ * all three factors on the 2D DLR grid and refitting. For example, with gl =
+ * gr = G and f a vertex function, the product is the vertex function times the
+ * pair propagator Pi(nu1, nu2).
+ *
+ * Here (nu1, nu2) are the frequencies in the convention of the channel, as
+ * passed to \ref coefs2eval_if: in the particle-hole channel, the grid point
+ * with index pair (a, b) is (nu1, nu2) = (i nu_{-a-1}, i nu_b), so gl is
+ * evaluated at index -a-1 (see \ref dlr2d_if_ops::vals_1d).
+ *
+ * \param[in] ops       2D DLR operations object
+ * \param[in] ifops_fer Fermionic 1D DLR imaginary frequency operations object
+ * \param[in] gl        1D DLR coefficients of factor in first argument
+ * \param[in] gr        1D DLR coefficients of factor in second argument
+ * \param[in] gc_reg    2D DLR regular expansion coefficients of f
+ * \param[in] gc_sng    1D DLR singular expansion coefficients of f
+ * \param[in] channel   Channel index (=1 for particle-particle, =2 for
+ * particle-hole)
+ *
+ * \return 2D DLR regular and singular expansion coefficients of product
+ */
+  std::tuple<nda::array<dcomplex, 3>, nda::array<dcomplex, 1>> mul_if(dlr2d_if_ops const &ops, cppdlr::imfreq_ops const &ifops_fer,
+                                                                      nda::array_const_view<dcomplex, 1> gl, nda::array_const_view<dcomplex, 1> gr,
+                                                                      nda::array_const_view<dcomplex, 3> gc_reg,
+                                                                      nda::array_const_view<dcomplex, 1> gc_sng, int channel);
+
+  /*!
+ * \brief Divide a 2D DLR expansion by 1D DLR expansions in its two fermionic
+ * arguments
+ *
+ * This function differs from \ref mul_if in that f(nu1, nu2) / (gl(nu1)
+ * gr(nu2)) is formed, as in passing from a three-point correlator to a
+ * vertex function.
+ */
+  std::tuple<nda::array<dcomplex, 3>, nda::array<dcomplex, 1>> div_if(dlr2d_if_ops const &ops, cppdlr::imfreq_ops const &ifops_fer,
+                                                                      nda::array_const_view<dcomplex, 1> gl, nda::array_const_view<dcomplex, 1> gr,
+                                                                      nda::array_const_view<dcomplex, 3> gc_reg,
+                                                                      nda::array_const_view<dcomplex, 1> gc_sng, int channel);
+
+  /*!
+ * \brief Multiply two 2D DLR expansions in the same channel
+ *
+ * \param[in] ops    2D DLR operations object
+ * \param[in] f_reg  2D DLR regular expansion coefficients of first factor
+ * \param[in] f_sng  1D DLR singular expansion coefficients of first factor
+ * \param[in] g_reg  2D DLR regular expansion coefficients of second factor
+ * \param[in] g_sng  1D DLR singular expansion coefficients of second factor
+ *
+ * \return 2D DLR regular and singular expansion coefficients of product
+ */
+  std::tuple<nda::array<dcomplex, 3>, nda::array<dcomplex, 1>> mul_if(dlr2d_if_ops const &ops, nda::array_const_view<dcomplex, 3> f_reg,
+                                                                      nda::array_const_view<dcomplex, 1> f_sng, nda::array_const_view<dcomplex, 3> g_reg,
+                                                                      nda::array_const_view<dcomplex, 1> g_sng);
+
+  /*!
+ * \brief Multiply several 2D DLR expansions by the same 1D DLR expansions in
+ * their two fermionic arguments
+ *
+ * This function differs from \ref mul_if in that the 1D factors are sampled
+ * once, and all products are refitted by a single matrix-matrix product.
+ *
+ * \param[in] ops       2D DLR operations object
+ * \param[in] ifops_fer Fermionic 1D DLR imaginary frequency operations object
+ * \param[in] gl        1D DLR coefficients of factor in first argument
+ * \param[in] gr        1D DLR coefficients of factor in second argument
+ * \param[in] gc_reg    2D DLR regular expansion coefficients, in the format
+ * of \ref vals2coefs_if_many
+ * \param[in] gc_sng    1D DLR singular expansion coefficients, in the format
+ * of \ref vals2coefs_if_many
+ * \param[in] channel   Channel index (=1 for particle-particle, =2 for
+ * particle-hole)
+ *
+ * \return 2D DLR regular and singular expansion coefficients of products
+ */
+  std::tuple<nda::array<dcomplex, 4>, nda::array<dcomplex, 2>> mul_if_many(dlr2d_if_ops const &ops, cppdlr::imfreq_ops const &ifops_fer,
+                                                                           nda::array_const_view<dcomplex, 1> gl, nda::array_const_view<dcomplex, 1> gr,
+                                                                           nda::array_const_view<dcomplex, 4> gc_reg,
+                                                                           nda::array_const_view<dcomplex, 2> gc_sng, int channel);
+
+} // namespace dlr2d
@@ -0,0 +1,237 @@
+#include "symmetry.hpp"
+
+#include <fmt/format.h>
+#include <set>
+
+namespace dlr2d {
+
+  using namespace cppdlr;
+
+  nda::array<int, 2> build_symidx(int r, symmetry_t sym) {
+
+    if (!sym.exchange) {
+      auto symidx = nda::array<int, 2>(3 * r * r + r, 2);
+      for (int i = 0; i < 3 * r * r + r; ++i) {
+        symidx(i, 0) = i;
+        symidx(i, 1) = -1;
+      }
+      return symidx;
+    }
+
+    auto symidx = nda::array<int, 2>(r * (r + 1) / 2 + r * r + r, 2);
+    int i       = 0;
+
+    // First regular term: symmetric coefficients
+    for (int k = 0; k < r; ++k) {
+      for (int l = k; l < r; ++l) {
+        symidx(i, 0) = k * r + l;
+        symidx(i, 1) = (l == k) ? -1 : l * r + k;
+        ++i;
+      }
+    }
+
+    // Second and third regular terms: equal coefficients
+    for (int k = 0; k < r; ++k) {
+      for (int l = 0; l < r; ++l) {
+        symidx(i, 0) = r * r + k * r + l;
+        symidx(i, 1) = 2 * r * r + k * r + l;
+        ++i;
+      }
+    }
+
+    // Singular term: free coefficients
+    for (int k = 0; k < r; ++k) {
+      symidx(i, 0) = 3 * r * r + k;
+      symidx(i, 1) = -1;
+      ++i;
+    }
+
+    return symidx;
+  }
+
+  nda::array<int, 2> irreducible_if(nda::array_const_view<int, 2> nu2didx, symmetry_t sym) {
+
+    auto seen = std::set<std::pair<int, int>>();
+    auto reps = std::vector<std::pair<int, int>>();
+
+    for (int i = 0; i < nu2didx.shape(0); ++i) {
+      int m = nu2didx(i, 0), n = nu2didx(i, 1);
+
+      // Representative is the lexicographically largest element of the orbit;
+      // exchange and conjugation commute, and exchange does not act on the
+      // anti-diagonal
+      auto rep = std::make_pair(m, n);
+      if (sym.conjugation) rep = std::max(rep, std::make_pair(-m - 1, -n - 1));
+      if (sym.exchange && m != -n - 1) {
+        rep = std::max(rep, std::make_pair(n, m));
+        if (sym.conjugation) rep = std::max(rep, std::make_pair(-n - 1, -m - 1));
+      }
+
+      if (seen.insert(rep).second) reps.push_back(rep);
+    }
+
+    auto irr = nda::array<int, 2>(reps.size(), 2);
+    for (int i = 0; i < irr.shape(0); ++i) {
+      irr(i, 0) = reps[i].first;
+      irr(i, 1) = reps[i].second;
+    }
+
+    return irr;
+  }
+
+  // Transposed kernel matrix in symmetrized basis, from transposed kernel
+  // matrix in ordinary basis (see build_k2d_if_t)
+  static fmatrix symmetrize_k2d_if_t(fmatrix_const_view kmatt, nda::array_const_view<int, 2> symidx) {
+
+    int nsym   = symidx.shape(0);
+    auto ksymt = fmatrix(nsym, kmatt.shape(1));
+
+    for (int i = 0; i < nsym; ++i) {
+      ksymt(i, _) = kmatt(symidx(i, 0), _);
+      if (symidx(i, 1) >= 0) ksymt(i, _) += kmatt(symidx(i, 1), _);
+    }
+
+    return ksymt;
+  }
+
+  nda::array<int, 2> build_dlr2d_if_sym(double lambda, double eps, symmetry_t sym, rankmethod_t rankmethod) {
+
+    // Get DLR frequencies
+    auto dlr_rf = build_dlr_rf(lambda, eps);
+    int r       = dlr_rf.size(); // # DLR basis functions
+
+    fmt::print("\nDLR cutoff Lambda = {}\n", lambda);
+    fmt::print("DLR tolerance epsilon = {}\n", eps);
+    fmt::print("# DLR basis functions = {}\n", r);
+
+    // Get irreducible part of fine 2D Matsubara frequency sampling grid
+    auto nu2didx = irreducible_if(build_dlr2d_if_fine(lambda, dlr_rf), sym);
+    int ncand    = nu2didx.shape(0);
+
+    // Get transposed system matrix in symmetrized basis
+    auto symidx = build_symidx(r, sym);
+    int nsym    = symidx.shape(0);
+    auto kmatt  = symmetrize_k2d_if_t(build_k2d_if_t(dlr_rf, nu2didx), symidx);
+
+    // Coefficients are real under conjugation, so real and imaginary parts of
+    // the values at a node give independent equations, and nodes are selected
+    // by a real pivoted QR
+    auto start = std::chrono::high_resolution_clock::now();
+    auto piv   = nda::zeros<int>(sym.conjugation ? 2 * ncand : ncand);
+    int ncol   = piv.size();
+    blas_thread_scope blas;
+    if (sym.conjugation) {
+      auto kmattri = nda::matrix<double, nda::F_layout>(nsym, ncol);
+      for (int j = 0; j < ncand; ++j) {
+        for (int i = 0; i < nsym; ++i) {
+          kmattri(i, j)         = real(kmatt(i, j));
+          kmattri(i, ncand + j) = imag(kmatt(i, j));
+        }
+      }
+      auto tau = nda::vector<double>(std::min(nsym, ncol));
+      nda::lapack::geqp3(kmattri, piv, tau);
+      kmatt = kmattri; // R factor, for rank estimation
+    } else {
+      auto tau = nda::vector<dcomplex>(std::min(nsym, ncol));
+      nda::lapack::geqp3(kmatt, piv, tau);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    int rank = qr_rank(kmatt, eps, rankmethod);
+
+    // Extract skeleton nodes from pivots, in pivot order
+    auto chosen = std::vector<bool>(ncand, false);
+    auto nodes  = std::vector<int>();
+    for (int k = 0; k < rank; ++k) {
+      int j = piv(k) % ncand;
+      if (!chosen[j]) {
+        chosen[j] = true;
+        nodes.push_back(j);
+      }
+    }
+
+    auto dlr2d_if = nda::array<int, 2>(nodes.size(), 2);
+    for (int k = 0; k < dlr2d_if.shape(0); ++k) {
+      dlr2d_if(k, 0) = nu2didx(nodes[k], 0);
+      dlr2d_if(k, 1) = nu2didx(nodes[k], 1);
+    }
+
+    fmt::print("# symmetrized basis functions = {}\n", nsym);
+    fmt::print("# irreducible fine grid nodes = {}\n", ncand);
+    fmt::print("System matrix rank = {}\n", rank);
+    fmt::print("# 2D DLR nodes = {}\n", dlr2d_if.shape(0));
+    fmt::print("Pivoted QR time = {}\n\n", std::chrono::duration<double>(end - start).count());
+
+    return dlr2d_if;
+  }
+
+  void build_dlr2d_if_sym(double lambda, double eps, symmetry_t sym, std::string path, std::string filename, rankmethod_t rankmethod) {
+    auto dlr2d_if = build_dlr2d_if_sym(lambda, eps, sym, rankmethod);
+
+    // Write dlr2d_if to hdf5 file
+    h5::file file(path + filename, 'w');
+    h5::group mygroup(file);
+    h5::write(mygroup, "dlr2d_if", dlr2d_if);
+  }
+
+  fmatrix build_cf2if_sym(double beta, nda::vector<double> dlr_rf, nda::array<int, 2> dlr2d_if, symmetry_t sym) {
+
+    auto symidx = build_symidx(dlr_rf.size(), sym);
+    auto ksymt  = symmetrize_k2d_if_t(build_k2d_if_t(dlr_rf, dlr2d_if), symidx);
+
+    auto cf2if = fmatrix(transpose(ksymt));
+    cf2if *= beta * beta;
+
+    return cf2if;
+  }
+
+  std::tuple<nda::array<dcomplex, 3>, nda::array<dcomplex, 1>> vals2coefs_if_sym(fmatrix cf2if, nda::vector_const_view<dcomplex> vals, int r,
+                                                                                 symmetry_t sym) {
+
+    int niom    = vals.size();
+    int nsym    = cf2if.shape(1);
+    auto symidx = build_symidx(r, sym);
+    auto csym   = nda::vector<dcomplex>(nsym);
+
+    int rank = 0; // Rank (not needed)
+    if (sym.conjugation) {
+      // Real least squares problem for real coefficients
+      auto a   = nda::matrix<double, nda::F_layout>(2 * niom, nsym);
+      auto tmp = nda::zeros<double>(std::max(2 * niom, nsym));
+      for (int n = 0; n < niom; ++n) {
+        for (int i = 0; i < nsym; ++i) {
+          a(n, i)        = real(cf2if(n, i));
+          a(niom + n, i) = imag(cf2if(n, i));
+        }
+        tmp(n)        = real(vals(n));
+        tmp(niom + n) = imag(vals(n));
+      }
+
+      auto s = nda::vector<double>(std::min(2 * niom, nsym)); // Singular values (not needed)
+      nda::lapack::gelss(a, tmp, s, 0.0, rank);
+      for (int i = 0; i < nsym; ++i) { csym(i) = tmp(i); }
+    } else {
+      auto tmp              = nda::zeros<dcomplex>(std::max(niom, nsym));
+      tmp(nda::range(niom)) = vals;
+
+      auto s = nda::vector<double>(std::min(niom, nsym)); // Singular values (not needed)
+      nda::lapack::gelss(cf2if, tmp, s, 0.0, rank);
+      csym = tmp(nda::range(nsym));
+    }
+
+    // Expand to ordinary 2D DLR coefficients
+    auto coef = nda::zeros<dcomplex>(3 * r * r + r);
+    for (int i = 0; i < nsym; ++i) {
+      coef(symidx(i, 0)) = csym(i);
+      if (symidx(i, 1) >= 0) coef(symidx(i, 1)) = csym(i);
+    }
+
+    auto coefreg                = nda::array<dcomplex, 3>(3, r, r);
+    auto coefsng                = nda::array<dcomplex, 1>(r);
+    reshape(coefreg, 3 * r * r) = coef(nda::range(3 * r * r));
+    coefsng                     = coef(nda::range(3 * r * r, 3 * r * r + r));
+
+    return {coefreg, coefsng};
+  }
+
+} // namespace dlr2d
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "dlr2d.hpp"
+
+namespace dlr2d {
+
+  /*!
+ * \brief Frequency symmetries of a function represented by a 2D DLR expansion
+ *
+ * For a function f of a fermionic/fermionic index pair (m, n), the supported
+ * symmetries are
+ *
+ * - exchange:    f(m, n) = f(n, m)
+ * - conjugation: f(-m-1, -n-1) = conj(f(m, n))
+ *
+ * Under exchange, the coefficients of the first regular term are symmetric,
+ * and those of the second and third regular terms coincide. The singular term
+ * is not closed under exchange, so its coefficients are not tied, and index
+ * pairs on the anti-diagonal m = -n-1 are not identified. Under conjugation,
+ * all 2D DLR basis functions satisfy the symmetry themselves, so the
+ * coefficients are real.
+ */
+  struct symmetry_t {
+    bool exchange    = false; ///< f(m, n) = f(n, m)
+    bool conjugation = false; ///< f(-m-1, -n-1) = conj(f(m, n))
+  };
+
+  /*!
+ * \brief Obtain symmetrized 2D DLR basis
+ *
+ * Row i of the returned nsym x 2 array contains the indices, in the ordering
+ * of the columns of \ref build_cf2if, of the (at most two) 2D DLR basis
+ * functions whose sum is the i-th symmetrized basis function. The second
+ * index is -1 if there is only one.
+ *
+ * \param[in] r   # basis functions in 1D DLR
+ * \param[in] sym Symmetries
+ *
+ * \return Symmetrized basis index pairs
+ */
+  nda::array<int, 2> build_symidx(int r, symmetry_t sym);
+
+  /*!
+ * \brief Map Matsubara frequency index pairs to an irreducible wedge
+ *
+ * Each index pair is replaced by a fixed representative of its orbit under
+ * the given symmetries, and duplicates are removed, keeping the order of
+ * first occurrence.
+ *
+ * \param[in] nu2didx Matsubara frequency index pairs
+ * \param[in] sym     Symmetries
+ *
+ * \return Irreducible Matsubara frequency index pairs
+ */
+  nda::array<int, 2> irreducible_if(nda::array_const_view<int, 2> nu2didx, symmetry_t sym);
+
+  /*!
+ * \brief Obtain symmetry-reduced 2D DLR Matsubara frequency grid
+ *
+ * This function differs from \ref build_dlr2d_if in that the fine grid is
+ * mapped to the irreducible wedge (see \ref irreducible_if) and the system
+ * matrix uses the symmetrized basis (see \ref build_symidx), so only
+ * functions with the given symmetries can be represented, and fewer
+ * Matsubara frequencies need to be sampled. Under conjugation, each node
+ * yields two real equations, and the nodes are selected by a pivoted QR
+ * decomposition of the real and imaginary parts of the system matrix.
+ *
+ * \param[in] lambda      DLR cutoff parameter
+ * \param[in] eps         Error tolerance
+ * \param[in] sym         Symmetries
+ * \param[in] path        Path to directory in which to save 2D DLR Mat. freqs.
+ * \param[in] filename    Name of file in which to save 2D DLR Mat. freqs.
+ * \param[in] rankmethod  Rank estimation strategy (see \ref qr_rank)
+ */
+  void build_dlr2d_if_sym(double lambda, double eps, symmetry_t sym, std::string path, std::string filename,
+                          rankmethod_t rankmethod = DiagThreshold);
+
+  nda::array<int, 2> build_dlr2d_if_sym(double lambda, double eps, symmetry_t sym, rankmethod_t rankmethod = DiagThreshold);
+
+  /*!
+ * \brief Get matrix of symmetrized 2D DLR basis functions evaluated on 2D DLR
+ * Matsubara frequency grid
+ *
+ * \param[in] beta     Inverse temperature
+ * \param[in] dlr_rf   1D DLR real frequencies
+ * \param[in] dlr2d_if 2D DLR Matsubara frequency grid
+ * \param[in] sym      Symmetries
+ *
+ * \return Symmetrized coefficients to values matrix
+ */
+  fmatrix build_cf2if_sym(double beta, nda::vector<double> dlr_rf, nda::array<int, 2> dlr2d_if, symmetry_t sym);
+
+  /*!
+ * \brief Transform values of a symmetric 2D DLR expansion on the 2D DLR
+ * Matsubara frequency grid to its coefficients
+ *
+ * The least squares fit is carried out for the symmetrized coefficients, in
+ * real arithmetic under conjugation, and the result is expanded to the
+ * ordinary 2D DLR coefficient storage format.
+ *
+ * \param[in] cf2if  Coefficients to values matrix
+ * \param[in] vals   Values of 2D DLR expansion on 2D DLR Mat. freq. grid
+ * \param[in] r      # basis functions in 1D DLR
+ * \param[in] sym    Symmetries
+ *
+ * \return 2D DLR regular and singular expansion coefficients
+ *
+ * \note The matrix \p cf2if should be obtained using \ref build_cf2if_sym.
+ */
+  std::tuple<nda::array<dcomplex, 3>, nda::array<dcomplex, 1>> vals2coefs_if_sym(fmatrix cf2if, nda::vector_const_view<dcomplex> vals, int r,
+                                                                                 symmetry_t sym);
+
+} // namespace dlr2d
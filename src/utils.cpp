@@ -1,6 +1,16 @@
 #include "utils.hpp"
 
+#include <algorithm>
+#include <cstdlib>
+#include <fmt/format.h>
 #include <iomanip>
+#include <vector>
+
+#include <dlfcn.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace dlr2d {
 
@@ -30,10 +40,53 @@ namespace dlr2d {
     return filenameStream.str();
   }
 
-  // Estimate rank of a square matrix A for which the full pivoted QR
-  // decomposition has been obtained using the function geqp3. The
-  // upper-triangular matrix R, which is used to estimate the rank, is stored in
-  // the upper-triangular part of A.
+  std::string get_filename_multieps(double lambda, double eps) {
+
+    std::ostringstream filenameStream;
+    filenameStream << "dlr2d_if_multieps_" << lambda << "_" << std::scientific << std::setprecision(2) << eps << ".h5";
+
+    return filenameStream.str();
+  }
+
+  std::string rankmethod_name(rankmethod_t rankmethod) {
+    switch (rankmethod) {
+      case DiagThreshold: return "diagonal threshold";
+      case FrobeniusTail: return "Frobenius tail";
+      case Randomized: return "randomized";
+    }
+    throw std::runtime_error("Invalid rank estimation method.");
+  }
+
+  int qr_rank(fmatrix_const_view a, double eps, rankmethod_t rankmethod) {
+    int m = a.shape(0);
+    int n = a.shape(1);
+    int k = std::min(m, n);
+
+    if (rankmethod == DiagThreshold) {
+      // First k with |R_kk| < eps
+      for (int i = 0; i < k; ++i) {
+        if (abs(a(i, i)) < eps) return i;
+      }
+      return k;
+    } else if (rankmethod == FrobeniusTail) {
+      // ||R(i:, i:)||_F^2 is the sum over rows j >= i of ||R(j, j:)||^2, which
+      // we accumulate from the bottom
+      double errsq = 0;
+      for (int i = k - 1; i >= 0; --i) {
+        for (int j = i; j < n; ++j) { errsq += pow(abs(a(i, j)), 2); }
+        if (sqrt(errsq) > eps) return i + 1;
+      }
+      return 0;
+    } else if (rankmethod == Randomized) {
+      return estimate_rank(a, eps, 2.0, 100);
+    }
+    throw std::runtime_error("Invalid rank estimation method.");
+  }
+
+  // Estimate rank of a matrix A for which the full pivoted QR decomposition has
+  // been obtained using the function geqp3. The upper-triangular matrix R,
+  // which is used to estimate the rank, is stored in the upper-triangular part
+  // of A.
   //
   // We use Eqn. (4.3) from Halko, Martinsson, Tropp, SIAM Rev. 2011 to obtain an
   // efficient randomized algorithm to estimate the rank in a manner which
@@ -44,12 +97,16 @@ namespace dlr2d {
   // proportional to nvec. Larger values of alpha lead to a less optimal estimate
   // of the rank, so the most optimal solution is obtained by choosing alpha close
   // to 1 and a correspondingly large value of nvec.
-  int estimate_rank(fmatrix_const_view a, double eps, double alpha, int nvec) {
-    int n = a.shape(0);
+  //
+  // The cumulative norms computed here give, for each i, an estimate of
+  // ||R(i:, i:)||_2 which exceeds it with very high probability; the rank is the
+  // first i >= 1 at which this estimate drops below eps.
+  static nda::vector<double> estimate_tail_norms(fmatrix_const_view a, double alpha, int nvec, unsigned int seed) {
+    int n = a.shape(1);                   // # columns of R
+    int k = std::min(int(a.shape(0)), n); // # rows of R
 
     // Set up random number generator
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    std::mt19937 gen(seed);
     std::normal_distribution<double> d(0.0, 1.0);
 
     // Generate random Gaussian vectors
@@ -58,9 +115,10 @@ namespace dlr2d {
       for (int j = 0; j < nvec; ++j) { x(i, j) = d(gen) + 1i * d(gen); }
     }
 
-    // Extract upper triangular matrix R
-    auto r = fmatrix(n, n);
-    for (int i = 0; i < n; ++i) {
+    // Extract upper triangular (trapezoidal) matrix R
+    auto r = fmatrix(k, n);
+    r      = 0;
+    for (int i = 0; i < k; ++i) {
       for (int j = i; j < n; ++j) { r(i, j) = a(i, j); }
     }
 
@@ -81,26 +139,165 @@ namespace dlr2d {
     for (int j = 0; j < nvec; ++j) {
       // Compute cumulative sum of squares of elements in column j, starting from
       // bottom
-      ynorm(n - 1, j) = pow(abs(y(n - 1, j)), 2);
-      for (int i = n - 2; i >= 0; --i) { ynorm(i, j) = pow(abs(y(i, j)), 2) + ynorm(i + 1, j); }
+      ynorm(k - 1, j) = pow(abs(y(k - 1, j)), 2);
+      for (int i = k - 2; i >= 0; --i) { ynorm(i, j) = pow(abs(y(i, j)), 2) + ynorm(i + 1, j); }
     }
 
-    ynorm /= xnorm;
+    ynorm /= xnorm(nda::range(k), _);
 
     // Take maximum of cumulative l2 norms over random vectors
-    for (int i = 0; i < n; ++i) { ynorm(i, 0) = max_element(ynorm(i, _)); }
-
-    // Estimate rank
-    int rank     = 0;
-    double epssc = eps / (alpha * sqrt(2 / pi));
-    for (int i = 0; i < n - 1; ++i) {
-      if (ynorm(i + 1, 0) < epssc * epssc) {
-        rank = i + 1;
-        break;
+    auto tail = nda::vector<double>(k);
+    for (int i = 0; i < k; ++i) { tail(i) = alpha * sqrt(2 / pi) * sqrt(max_element(ynorm(i, _))); }
+
+    return tail;
+  }
+
+  int estimate_rank(fmatrix_const_view a, double eps, double alpha, int nvec, unsigned int seed) {
+    auto tail = estimate_tail_norms(a, alpha, nvec, seed);
+    int k     = tail.size();
+    for (int i = 1; i < k; ++i) {
+      if (tail(i) < eps) return i;
+    }
+    return k;
+  }
+
+  nda::vector<double> qr_profile(fmatrix_const_view a, rankmethod_t rankmethod) {
+    int n = a.shape(1);
+    int k = std::min(int(a.shape(0)), n);
+
+    auto prof = nda::vector<double>(k);
+    if (rankmethod == DiagThreshold) {
+      for (int i = 0; i < k; ++i) { prof(i) = abs(a(i, i)); }
+    } else if (rankmethod == FrobeniusTail) {
+      double errsq = 0;
+      for (int i = k - 1; i >= 0; --i) {
+        for (int j = i; j < n; ++j) { errsq += pow(abs(a(i, j)), 2); }
+        prof(i) = sqrt(errsq);
       }
+    } else if (rankmethod == Randomized) {
+      prof = estimate_tail_norms(a, 2.0, 100, 0);
+    } else {
+      throw std::runtime_error("Invalid rank estimation method.");
+    }
+
+    return prof;
+  }
+
+  nda::vector<int> skeletonize_cols(nda::vector_const_view<int> cols, std::function<fmatrix(nda::vector_const_view<int>)> const &getcols, double eps,
+                                    rankmethod_t rankmethod) {
+
+    auto a   = getcols(cols);
+    int m    = a.shape(0);
+    int n    = cols.size();
+    auto piv = nda::zeros<int>(n);
+    auto tau = nda::vector<dcomplex>(std::min(m, n));
+    blas_thread_scope blas;
+    nda::lapack::geqp3(a, piv, tau);
+
+    int rank  = qr_rank(a, eps, rankmethod);
+    auto skel = nda::vector<int>(rank);
+    for (int k = 0; k < rank; ++k) { skel(k) = cols(piv(k)); }
+    return skel;
+  }
+
+  nda::vector<int> tournament_pivot(int ncol, std::function<fmatrix(nda::vector_const_view<int>)> const &getcols, double eps, int nchunk,
+                                    rankmethod_t rankmethod) {
+
+    // Split columns into chunks
+    nchunk    = std::max(1, std::min(nchunk, ncol));
+    auto sets = std::vector<nda::vector<int>>(nchunk);
+    for (int i = 0; i < nchunk; ++i) {
+      int start = (long(i) * ncol) / nchunk;
+      int end   = (long(i + 1) * ncol) / nchunk;
+      sets[i]   = nda::vector<int>(end - start);
+      for (int j = 0; j < end - start; ++j) { sets[i](j) = start + j; }
+    }
+
+    // Reduction tree: skeletonize all sets on the current level in parallel,
+    // then merge pairs of skeletons to form the next level. The pivoted QR
+    // decompositions are small and run concurrently, so each uses a single
+    // BLAS thread.
+    blas_thread_scope blas(1);
+    while (true) {
+      int nset = sets.size();
+
+#pragma omp parallel for schedule(dynamic) num_threads(get_num_threads())
+      for (int i = 0; i < nset; ++i) { sets[i] = skeletonize_cols(sets[i], getcols, eps, rankmethod); }
+
+      if (nset == 1) break;
+
+      // Merge pairs of sets; if # sets is odd, the last three are merged
+      auto merged = std::vector<nda::vector<int>>(nset / 2);
+      for (int i = 0; i < nset / 2; ++i) {
+        int nmerge = (i == nset / 2 - 1) ? nset - 2 * i : 2;
+
+        int len = 0;
+        for (int j = 0; j < nmerge; ++j) { len += sets[2 * i + j].size(); }
+
+        merged[i] = nda::vector<int>(len);
+        int pos   = 0;
+        for (int j = 0; j < nmerge; ++j) {
+          int lenj                               = sets[2 * i + j].size();
+          merged[i](nda::range(pos, pos + lenj)) = sets[2 * i + j];
+          pos += lenj;
+        }
+      }
+      sets = std::move(merged);
+    }
+
+    return sets[0];
+  }
+
+  nda::vector<int> streaming_pivot(int ncol, std::function<fmatrix(nda::vector_const_view<int>)> const &getcols, double eps, int tilesize,
+                                   rankmethod_t rankmethod) {
+
+    tilesize  = std::max(1, std::min(tilesize, ncol));
+    auto skel = nda::vector<int>(0);
+
+    for (int start = 0; start < ncol; start += tilesize) {
+      int end   = std::min(start + tilesize, ncol);
+      int nskel = skel.size();
+
+      // Merge current skeleton with next tile, and skeletonize
+      auto cols               = nda::vector<int>(nskel + end - start);
+      cols(nda::range(nskel)) = skel;
+      for (int j = start; j < end; ++j) { cols(nskel + j - start) = j; }
+      skel = skeletonize_cols(cols, getcols, eps, rankmethod);
     }
 
-    return rank;
+    return skel;
+  }
+
+  nda::vector<int> streaming_pivot_sketch(int nrow, int ncol,
+                                          std::function<fmatrix(nda::vector_const_view<int>, fmatrix_const_view)> const &getcols,
+                                          double eps, int tilesize, int nsketch, rankmethod_t rankmethod) {
+
+    while (true) {
+      bool sketch = (nsketch > 0 && nsketch < nrow);
+      auto omega  = sketch ? gaussian_sketch(nsketch, nrow) : fmatrix(0, 0);
+
+      fmt::print("Streaming pivoting: tile size = {}, sketch dimension = {}\n", tilesize, sketch ? nsketch : nrow);
+
+      auto skel = streaming_pivot(
+         ncol, [&](nda::vector_const_view<int> cols) { return getcols(cols, omega); }, eps, tilesize, rankmethod);
+
+      // Sketch too small to resolve rank: enlarge and repeat
+      if (!sketch || skel.size() < nsketch) return skel;
+      nsketch *= 2;
+    }
+  }
+
+  fmatrix gaussian_sketch(int m, int n, unsigned int seed) {
+
+    std::mt19937 gen(seed);
+    std::normal_distribution<double> d(0.0, 1.0 / sqrt(m));
+
+    auto omega = fmatrix(m, n);
+    for (int j = 0; j < n; ++j) {
+      for (int i = 0; i < m; ++i) { omega(i, j) = d(gen); }
+    }
+
+    return omega;
   }
 
   std::complex<double> ker(std::complex<double> nu, double om) { return 1.0 / (nu - om); }
@@ -141,4 +338,105 @@ namespace dlr2d {
     return {i, j};
   }
 
+  // # threads for library parallel regions (0 for OpenMP default)
+  static int nthreads_lib = 0;
+
+  void set_num_threads(int nthreads) { nthreads_lib = (nthreads > 0) ? nthreads : 0; }
+
+  int get_num_threads() {
+#ifdef _OPENMP
+    return (nthreads_lib > 0) ? nthreads_lib : omp_get_max_threads();
+#else
+    return 1;
+#endif
+  }
+
+  // Thread control functions of BLAS library, looked up at run time so that
+  // the library does not depend on a particular BLAS implementation, and #
+  // BLAS threads specified in the environment (0 if none)
+  struct blas_threads_api {
+    void (*openblas_set)(int) = nullptr;
+    int (*openblas_get)()     = nullptr;
+    int (*mkl_set_local)(int) = nullptr;
+    int (*mkl_get)()          = nullptr;
+    int nenv                  = 0;
+
+    blas_threads_api() {
+      openblas_set  = reinterpret_cast<void (*)(int)>(dlsym(RTLD_DEFAULT, "openblas_set_num_threads"));
+      openblas_get  = reinterpret_cast<int (*)()>(dlsym(RTLD_DEFAULT, "openblas_get_num_threads"));
+      mkl_set_local = reinterpret_cast<int (*)(int)>(dlsym(RTLD_DEFAULT, "MKL_Set_Num_Threads_Local"));
+      mkl_get       = reinterpret_cast<int (*)()>(dlsym(RTLD_DEFAULT, "MKL_Get_Max_Threads"));
+
+      for (auto var : {"MKL_NUM_THREADS", "OPENBLAS_NUM_THREADS"}) {
+        if (auto val = std::getenv(var); val && std::atoi(val) > 0) {
+          nenv = std::atoi(val);
+          break;
+        }
+      }
+    }
+
+    // MKL is preferred, since its setter is local to the calling thread
+    bool is_mkl() const { return mkl_set_local && mkl_get; }
+    bool is_openblas() const { return !is_mkl() && openblas_set && openblas_get; }
+  };
+
+  static blas_threads_api const &get_blas_threads_api() {
+    static blas_threads_api const api;
+    return api;
+  }
+
+  bool set_blas_num_threads(int nthreads) {
+    auto const &api = get_blas_threads_api();
+    if (api.is_mkl()) {
+      api.mkl_set_local(nthreads);
+      return true;
+    }
+    if (api.is_openblas()) {
+      api.openblas_set(nthreads);
+      return true;
+    }
+    return false;
+  }
+
+  int get_blas_num_threads() {
+    auto const &api = get_blas_threads_api();
+    if (api.is_mkl()) return api.mkl_get();
+    if (api.is_openblas()) return api.openblas_get();
+    return 0;
+  }
+
+  blas_thread_scope::blas_thread_scope(int nthreads) {
+#ifdef _OPENMP
+    if (omp_in_parallel()) return;
+#endif
+    auto const &api = get_blas_threads_api();
+    if (nthreads <= 0) nthreads = get_num_threads();
+
+    // Never exceed a # threads specified in the environment
+    if (api.nenv > 0) nthreads = std::min(nthreads, api.nenv);
+
+    if (api.is_mkl()) {
+      // Thread-local setting; returns previous thread-local setting (0 if none)
+      nprev   = api.mkl_set_local(nthreads);
+      changed = true;
+    } else if (api.is_openblas()) {
+      int n = api.openblas_get();
+      if (n != nthreads) {
+        api.openblas_set(nthreads);
+        nprev   = n;
+        changed = true;
+      }
+    }
+  }
+
+  blas_thread_scope::~blas_thread_scope() {
+    if (!changed) return;
+    auto const &api = get_blas_threads_api();
+    if (api.is_mkl()) {
+      api.mkl_set_local(nprev);
+    } else {
+      api.openblas_set(nprev);
+    }
+  }
+
 } // namespace dlr2d
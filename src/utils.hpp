@@ -2,6 +2,7 @@
 #include "cppdlr/cppdlr.hpp"
 #include "nda/nda.hpp"
 
+#include <functional>
 #include <numbers>
 #include <string>
 
@@ -50,12 +51,81 @@ namespace dlr2d {
   std::string get_filename_3term(double lambda, double eps);
 
   /*!
- * \brief Estimate rank of a square matrix from its full pivoted QR
- * decomposition
+ * \brief Get filename used by \ref build_dlr2d_if_multieps to store 2D
+ * Matsubara frequency DLR grid
+ *
+ * These grids are obtained from the 1D DLR basis for the tightest tolerance,
+ * and may differ from those generated by \ref build_dlr2d_if, so they are
+ * stored under a distinct filename.
+ *
+ * \param[in] lambda      DLR cutoff
+ * \param[in] eps         Error tolerance
+ *
+ * \return Filename describing grid parameters
+ */
+  std::string get_filename_multieps(double lambda, double eps);
+
+  /*!
+ * \brief Strategies for estimating the numerical rank of a matrix from its
+ * pivoted QR decomposition A P = Q R; see \ref qr_rank
+ */
+  enum rankmethod_t {
+    DiagThreshold = 1, ///< First k with |R_kk| < eps
+    FrobeniusTail = 2, ///< Smallest k with ||R(k:, k:)||_F <= eps
+    Randomized    = 3  ///< Randomized estimate of ||R(k:, k:)||_2 <= eps, see \ref estimate_rank
+  };
+
+  /*!
+ * \brief Name of a rank estimation strategy, for reporting
+ *
+ * \param[in] rankmethod Rank estimation strategy
+ *
+ * \return Name of strategy
+ */
+  std::string rankmethod_name(rankmethod_t rankmethod);
+
+  /*!
+ * \brief Estimate rank of a matrix from its pivoted QR decomposition
+ *
+ * Assumes QR decomposition was computed using LAPACK geqp3. The
+ * upper-triangular (or trapezoidal) matrix R, which is used to estimate the
+ * rank, is stored in the upper-triangular part of A. All strategies only read
+ * R, and their cost is small compared to that of the QR decomposition:
+ * O(min(m,n)) for \ref DiagThreshold, O(min(m,n) n) for \ref FrobeniusTail,
+ * and O(min(m,n) n nvec) with nvec = 100 for \ref Randomized.
+ *
+ * \param[in] a          Result of geqp3 on A, containing matrix R
+ * \param[in] eps        Error tolerance for rank estimation
+ * \param[in] rankmethod Rank estimation strategy
+ *
+ * \return Estimated rank of matrix A
+ */
+  int qr_rank(fmatrix_const_view a, double eps, rankmethod_t rankmethod = DiagThreshold);
+
+  /*!
+ * \brief Rank profile of a matrix from its pivoted QR decomposition
+ *
+ * Returns, for each k < min(m,n), the quantity which the given strategy
+ * compares against eps: |R_kk| for \ref DiagThreshold, ||R(k:, k:)||_F for
+ * \ref FrobeniusTail, and the randomized estimate of ||R(k:, k:)||_2 for \ref
+ * Randomized. The rank returned by \ref qr_rank for any tolerance eps is then
+ * the first k with profile entry below eps (k >= 1 for \ref Randomized), so a
+ * single profile can be truncated at several tolerances.
+ *
+ * \param[in] a          Result of geqp3 on A, containing matrix R
+ * \param[in] rankmethod Rank estimation strategy
+ *
+ * \return Rank profile of matrix A
+ */
+  nda::vector<double> qr_profile(fmatrix_const_view a, rankmethod_t rankmethod = DiagThreshold);
+
+  /*!
+ * \brief Estimate rank of a matrix from its full pivoted QR decomposition
+ * using a randomized algorithm
  *
  * Assumes QR decomposition was computed using LAPACK geqp3. The
- * upper-triangular matrix R, which is used to estimate the rank, is stored in
- * the upper-triangular part of A.
+ * upper-triangular (or trapezoidal) matrix R, which is used to estimate the
+ * rank, is stored in the upper-triangular part of A.
 
  * We use Eqn. (4.3) from Halko, Martinsson, Tropp, SIAM Rev. 2011 to obtain an
  * efficient randomized algorithm to estimate the rank in a manner which
@@ -67,18 +137,127 @@ namespace dlr2d {
  * of the rank, so the most optimal solution is obtained by choosing alpha close
  * to 1 and a correspondingly large value of nvec.
  *
- * \param[in] a     Result of geqp3 on A, containing upper-triangular matrix R
+ * \param[in] a     Result of geqp3 on A, containing matrix R
  * \param[in] eps   Error tolerance for rank estimation
  * \param[in] alpha Paranoia factor
  * \param[in] nvec  # random vectors used in algorithm
+ * \param[in] seed  Seed for random number generator
  *
  * \return Estimated rank of matrix A
  *
+ * \note The random vectors are generated from a fixed seed, so the result is
+ * reproducible.
+ *
  * \note DESPITE SUPPOSED GUARANTEES, THIS FUNCTION HAS SO FAR YIELDED MIXED
  * RESULTS IN LIMITED TESTING, AND SHOULD BE USED WITH CAUTION UNTIL FURTHER
  * TESTING IS DONE.
  */
-  int estimate_rank(fmatrix_const_view a, double eps, double alpha, int nvec);
+  int estimate_rank(fmatrix_const_view a, double eps, double alpha, int nvec, unsigned int seed = 0);
+
+  /*!
+ * \brief Select skeleton columns from a subset of the columns of a matrix by
+ * pivoted QR decomposition
+ *
+ * \param[in] cols       Indices of columns of A to consider
+ * \param[in] getcols    Function returning the columns of A with given indices
+ * \param[in] eps        Error tolerance
+ * \param[in] rankmethod Rank estimation strategy (see \ref qr_rank)
+ *
+ * \return Indices of the first k pivot columns of A, with k the rank
+ * estimated at tolerance eps, in pivot order
+ */
+  nda::vector<int> skeletonize_cols(nda::vector_const_view<int> cols, std::function<fmatrix(nda::vector_const_view<int>)> const &getcols, double eps,
+                                    rankmethod_t rankmethod = DiagThreshold);
+
+  /*!
+ * \brief Select skeleton columns of a matrix by tournament pivoting
+ *
+ * The columns of an m x n matrix A are split into chunks, and a pivoted QR
+ * decomposition of each chunk selects its local skeleton columns, i.e. those
+ * up to the rank estimated at tolerance eps. Pairs of local skeletons are
+ * then merged and skeletonized again in a binary reduction tree, until a single
+ * set of columns remains. The chunks on each level of the tree are processed in
+ * parallel, and only the columns of A belonging to chunks currently being
+ * processed are held in memory; they are obtained on demand from \p getcols.
+ *
+ * \param[in] ncol       # columns of A
+ * \param[in] getcols    Function returning the columns of A with given indices
+ * \param[in] eps        Error tolerance
+ * \param[in] nchunk     # chunks at the leaves of the reduction tree
+ * \param[in] rankmethod Rank estimation strategy (see \ref qr_rank)
+ *
+ * \return Indices of skeleton columns of A, in pivot order
+ *
+ * \note With nchunk = 1, this reduces to a single pivoted QR decomposition of
+ * A. For nchunk > 1, the selected columns are in general different from, but of
+ * comparable quality to, those obtained from a pivoted QR decomposition of all
+ * of A.
+ */
+  nda::vector<int> tournament_pivot(int ncol, std::function<fmatrix(nda::vector_const_view<int>)> const &getcols, double eps, int nchunk,
+                                    rankmethod_t rankmethod = DiagThreshold);
+
+  /*!
+ * \brief Select skeleton columns of a matrix by streaming pivoting with bounded
+ * memory
+ *
+ * The columns of an m x n matrix A are processed in tiles of \p tilesize
+ * columns. Each tile is merged with the current set of skeleton columns, and
+ * the merged set is skeletonized by pivoted QR (see \ref skeletonize_cols).
+ * At most m x (rank + tilesize) entries of A are held in memory at any time;
+ * they are obtained on demand from \p getcols.
+ *
+ * \param[in] ncol       # columns of A
+ * \param[in] getcols    Function returning the columns of A with given indices
+ * \param[in] eps        Error tolerance
+ * \param[in] tilesize   # columns per tile
+ * \param[in] rankmethod Rank estimation strategy (see \ref qr_rank)
+ *
+ * \return Indices of skeleton columns of A, in pivot order
+ */
+  nda::vector<int> streaming_pivot(int ncol, std::function<fmatrix(nda::vector_const_view<int>)> const &getcols, double eps, int tilesize,
+                                   rankmethod_t rankmethod = DiagThreshold);
+
+  /*!
+ * \brief Select skeleton columns of a matrix by streaming pivoting, optionally
+ * applied to a Gaussian sketch of the matrix
+ *
+ * If 0 < \p nsketch < m, the columns of the m x n matrix A are replaced by
+ * those of Omega A, with Omega an nsketch x m Gaussian sketching matrix (see
+ * \ref gaussian_sketch), before streaming pivoting (see \ref streaming_pivot).
+ * The columns are obtained from \p getcols, which receives the column indices
+ * and Omega (an empty matrix if no sketch is used). To keep the memory bounded
+ * by O(nsketch x tilesize), it should apply Omega to blocks of rows of A as
+ * they are generated, rather than forming the full columns of A. If the
+ * estimated rank reaches the sketch dimension, which is then too small to
+ * resolve it, \p nsketch is doubled and the pivoting is repeated.
+ *
+ * \param[in] nrow       # rows of A
+ * \param[in] ncol       # columns of A
+ * \param[in] getcols    Function returning the (sketched) columns of A with
+ * given indices
+ * \param[in] eps        Error tolerance
+ * \param[in] tilesize   # columns per tile
+ * \param[in] nsketch    Sketch dimension (=0 for no sketching)
+ * \param[in] rankmethod Rank estimation strategy (see \ref qr_rank)
+ *
+ * \return Indices of skeleton columns of A, in pivot order
+ */
+  nda::vector<int> streaming_pivot_sketch(int nrow, int ncol,
+                                          std::function<fmatrix(nda::vector_const_view<int>, fmatrix_const_view)> const &getcols,
+                                          double eps, int tilesize, int nsketch, rankmethod_t rankmethod = DiagThreshold);
+
+  /*!
+ * \brief Gaussian random sketching matrix
+ *
+ * \param[in] m     # rows
+ * \param[in] n     # columns
+ * \param[in] seed  Seed for random number generator
+ *
+ * \return m x n matrix with independent normally distributed entries of
+ * variance 1/m, so that the sketch of a vector preserves its l2 norm in
+ * expectation
+ */
+  fmatrix gaussian_sketch(int m, int n, unsigned int seed = 0);
 
   /*!
  * \brief Simple definition of imaginary frequency analytic continuation kernel
@@ -140,4 +319,97 @@ namespace dlr2d {
  */
   std::tuple<int, int> ind2sub_c(int idx, int n);
 
+  /*!
+ * \brief Set # threads used by the parallel regions of the library
+ *
+ * All OpenMP parallel regions in the library, such as the assembly of kernel
+ * matrices in \ref build_cf2if and the grid builders, use this # threads.
+ * Kernel matrix assembly makes no BLAS or LAPACK calls, and the dense
+ * factorizations which follow it run outside of parallel regions, so these
+ * threads and those of a threaded BLAS do not compete with each other. When
+ * library routines are themselves called from several threads, the # threads
+ * should be reduced accordingly to avoid oversubscription.
+ *
+ * \param[in] nthreads # threads (<= 0 to use the OpenMP default)
+ *
+ * \note Without OpenMP, all parallel regions run on a single thread.
+ */
+  void set_num_threads(int nthreads);
+
+  /*!
+ * \brief Get # threads used by the parallel regions of the library
+ *
+ * \return # threads set by \ref set_num_threads, or the OpenMP default if
+ * none was set
+ */
+  int get_num_threads();
+
+  /*!
+ * \brief Set # threads used by BLAS and LAPACK
+ *
+ * The BLAS library is detected at run time. OpenBLAS and MKL are supported;
+ * for MKL, the setting is local to the calling thread, while for OpenBLAS it
+ * applies to the whole process. With other BLAS libraries, this function has
+ * no effect.
+ *
+ * \param[in] nthreads # threads
+ *
+ * \return true if the # threads was set, false if the BLAS library is not
+ * supported
+ */
+  bool set_blas_num_threads(int nthreads);
+
+  /*!
+ * \brief Get # threads used by BLAS and LAPACK
+ *
+ * \return # threads, or 0 if the BLAS library is not supported (see \ref
+ * set_blas_num_threads)
+ */
+  int get_blas_num_threads();
+
+  /*!
+ * \brief Scope in which BLAS and LAPACK calls use a given # threads
+ *
+ * The # BLAS threads is set on construction and restored on destruction. The
+ * library uses a single BLAS thread around its own parallel regions which
+ * make many small BLAS calls, such as the pivoted QR decompositions in \ref
+ * tournament_pivot, and the library # threads (see \ref set_num_threads)
+ * around large single factorizations, such as those in the grid builders.
+ * Applications which call into the library from their own parallel regions
+ * should likewise open a single-threaded scope outside of those regions.
+ *
+ * A # BLAS threads specified in the environment by MKL_NUM_THREADS or
+ * OPENBLAS_NUM_THREADS is an upper bound: a scope may lower it, but never
+ * raises it.
+ *
+ * Inside an active OpenMP parallel region, a scope has no effect, since the #
+ * BLAS threads may be shared between threads; BLAS libraries built with
+ * OpenMP then run single-threaded in any case.
+ *
+ * \warning With MKL, the scope uses the thread-local setting of MKL and is
+ * thread-safe. With OpenBLAS, the # threads is a process-wide setting which is
+ * saved and restored without synchronization, so scopes must not be opened
+ * concurrently from several threads which are not managed by OpenMP.
+ */
+  class blas_thread_scope {
+
+    public:
+    /*!
+   * \brief Constructor
+   *
+   * \param[in] nthreads # BLAS threads in scope (<= 0 (default) for the
+   * library # threads, see \ref get_num_threads)
+   */
+    explicit blas_thread_scope(int nthreads = 0);
+
+    ~blas_thread_scope();
+
+    blas_thread_scope(blas_thread_scope const &)            = delete;
+    blas_thread_scope &operator=(blas_thread_scope const &) = delete;
+
+    private:
+    int nprev    = 0;     ///< # BLAS threads to restore on destruction
+    bool changed = false; ///< Whether # BLAS threads was changed in scope
+  };
+
 } // namespace dlr2d
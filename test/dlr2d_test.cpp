@@ -0,0 +1,452 @@
+#include "dlr2d.hpp"
+#include "test_utils.hpp"
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+#include <set>
+#include <utility>
+
+using namespace dlr2d;
+
+/*!
+ * \brief Test evaluation of 2D DLR expansion on a box of Matsubara frequency
+ * points against pointwise evaluation, in both channels
+ */
+TEST(dlr2d, box) {
+  double beta   = 8;    // Inverse temperature
+  double lambda = 8;    // DLR cutoff
+  double eps    = 1e-8; // DLR tolerance
+  int nbox      = 16;   // Half-width of box
+
+  auto dlr_rf = build_dlr_rf(lambda, eps);
+  int r       = dlr_rf.size();
+
+  // Arbitrary expansion coefficients
+  auto gc_reg = arbitrary_coefs<3>({3, r, r});
+  auto gc_sng = arbitrary_coefs<1>({r});
+
+  double err = 0;
+  for (int channel = 1; channel <= 2; ++channel) {
+    auto box = coefs2vals_box(beta, dlr_rf, gc_reg, gc_sng, nbox, channel);
+    for (int m = -nbox; m < nbox; ++m) {
+      for (int n = -nbox; n < nbox; ++n) {
+        err = std::max(err, abs(box(m + nbox, n + nbox) - coefs2eval_if(beta, dlr_rf, gc_reg, gc_sng, m, n, channel)));
+      }
+    }
+  }
+
+  fmt::print("Max deviation of box from pointwise evaluation: {}\n\n", err);
+
+  EXPECT_LT(err, 1e-10);
+}
+
+/*!
+ * \brief Test evaluation of 2D DLR expansion in fermion/boson frequency
+ * convention, on a box and at a batch of points, against pointwise evaluation
+ * in fermion/fermion convention
+ */
+TEST(dlr2d, nuom) {
+  double beta   = 8;    // Inverse temperature
+  double lambda = 8;    // DLR cutoff
+  double eps    = 1e-8; // DLR tolerance
+  int nnu       = 12;   // Half-width of box in fermionic frequency
+  int nom       = 9;    // # non-negative bosonic frequencies in box
+
+  auto dlr_rf = build_dlr_rf(lambda, eps);
+  int r       = dlr_rf.size();
+
+  // Arbitrary expansion coefficients
+  auto gc_reg = arbitrary_coefs<3>({3, r, r});
+  auto gc_sng = arbitrary_coefs<1>({r});
+
+  // Points of box, in fermion/boson convention
+  int nfer = 2 * nnu, nbos = 2 * nom - 1;
+  auto idx = nda::array<int, 2>(nfer * nbos, 2);
+  for (int i = 0; i < nfer; ++i) {
+    for (int j = 0; j < nbos; ++j) {
+      idx(i * nbos + j, 0) = i - nnu;
+      idx(i * nbos + j, 1) = j - nom + 1;
+    }
+  }
+
+  double err = 0;
+  for (int channel = 1; channel <= 2; ++channel) {
+    auto box   = coefs2vals_box_nuom(beta, dlr_rf, gc_reg, gc_sng, nnu, nom, channel);
+    auto batch = coefs2eval_if_nuom(beta, dlr_rf, gc_reg, gc_sng, idx, channel);
+    for (int i = 0; i < nfer; ++i) {
+      for (int j = 0; j < nbos; ++j) {
+        int nu = i - nnu, om = j - nom + 1;
+        int n  = (channel == 1) ? om - nu - 1 : nu + om;
+        auto g = coefs2eval_if(beta, dlr_rf, gc_reg, gc_sng, nu, n, channel);
+        err    = std::max(err, abs(box(i, j) - g));
+        err    = std::max(err, abs(batch(i * nbos + j) - g));
+      }
+    }
+  }
+
+  fmt::print("Max deviation of fermion/boson evaluation from pointwise evaluation: {}\n\n", err);
+
+  EXPECT_LT(err, 1e-10);
+}
+
+/*!
+ * \brief Test mixed-statistics 2D DLR: consistency of batched evaluation with
+ * coefficients to values matrix, and recovery of an expansion from its values
+ * on the mixed-statistics 2D DLR grid
+ */
+TEST(dlr2d, mixed) {
+  double beta   = 8;    // Inverse temperature
+  double lambda = 8;    // DLR cutoff
+  double eps    = 1e-8; // DLR tolerance
+  int nbox      = 10;   // Half-width of box of test points
+
+  auto dlr_rf = build_dlr_rf(lambda, eps);
+  int r       = dlr_rf.size();
+
+  // Arbitrary expansion coefficients
+  auto gc_reg = arbitrary_coefs<3>({3, r, r});
+  auto gc_sng = arbitrary_coefs<2>({3, r});
+
+  // Box of test points, which includes points on the singular lines
+  auto idx = box_idx(nbox, 2);
+
+  double errcf = 0, errfit = 0;
+  auto stats   = std::array<std::array<statistic_t, 2>, 3>{{{Boson, Fermion}, {Fermion, Boson}, {Boson, Boson}}};
+  for (auto [stat1, stat2] : stats) {
+    auto dlr2d_if = build_dlr2d_if(lambda, eps, DiagThreshold, stat1, stat2);
+    auto cf2if    = build_cf2if(beta, dlr_rf, dlr2d_if, stat1, stat2);
+    auto vals     = coefs2eval_if_mixed(beta, dlr_rf, gc_reg, gc_sng, dlr2d_if, stat1, stat2);
+
+    // Coefficients of singular terms which are present, in column order of
+    // cf2if
+    int nsng  = (stat1 == Boson) + (stat2 == Boson) + (stat1 == stat2);
+    auto coef = nda::vector<dcomplex>(3 * r * r + nsng * r);
+
+    coef(nda::range(3 * r * r)) = reshape(gc_reg, 3 * r * r);
+    int j                       = 3 * r * r;
+    if (stat1 == stat2) {
+      coef(nda::range(j, j + r)) = gc_sng(0, _);
+      j += r;
+    }
+    if (stat1 == Boson) {
+      coef(nda::range(j, j + r)) = gc_sng(1, _);
+      j += r;
+    }
+    if (stat2 == Boson) { coef(nda::range(j, j + r)) = gc_sng(2, _); }
+
+    auto vals_mat = nda::vector<dcomplex>(cf2if * coef);
+    errcf         = std::max(errcf, max_element(abs(vals - vals_mat)) / max_element(abs(vals)));
+
+    // Recover expansion from values on grid, and compare on box
+    auto [fc_reg, fc_sng] = vals2coefs_if_mixed(cf2if, vals, r, stat1, stat2);
+
+    auto gtru = coefs2eval_if_mixed(beta, dlr_rf, gc_reg, gc_sng, idx, stat1, stat2);
+    auto gfit = coefs2eval_if_mixed(beta, dlr_rf, fc_reg, fc_sng, idx, stat1, stat2);
+    errfit    = std::max(errfit, max_element(abs(gtru - gfit)) / max_element(abs(gtru)));
+  }
+
+  fmt::print("Relative deviation of batched evaluation from coefficients to values matrix: {}\n", errcf);
+  fmt::print("Relative error of mixed-statistics 2D DLR fit on box: {}\n\n", errfit);
+
+  EXPECT_LT(errcf, 1e-12);
+  EXPECT_LT(errfit, 100 * eps);
+}
+
+/*!
+ * \brief Test mixed-statistics 2D DLR fit of a three-point function given by
+ * its Lehmann representation with explicit poles, including the singular
+ * terms of its bosonic frequencies
+ */
+TEST(dlr2d, mixed_lehmann) {
+  double beta   = 8;    // Inverse temperature
+  double lambda = 8;    // DLR cutoff
+  double eps    = 1e-8; // DLR tolerance
+  int nbox      = 10;   // Half-width of box of test points
+
+  auto dlr_rf = build_dlr_rf(lambda, eps);
+  int r       = dlr_rf.size();
+
+  // Box of test points, which includes points on the singular lines
+  auto idx = box_idx(nbox, 2);
+
+  double errfit = 0;
+  auto stats    = std::array<std::array<statistic_t, 2>, 3>{{{Boson, Fermion}, {Fermion, Boson}, {Boson, Boson}}};
+  for (auto [stat1, stat2] : stats) {
+
+    // Three-point function with poles |beta * omega| < lambda in each pair of
+    // frequencies, plus a term for each bosonic frequency supported where it
+    // vanishes
+    auto gtru = [&](nda::array_const_view<int, 2> id) {
+      auto vals = nda::vector<dcomplex>(id.shape(0));
+      for (int j = 0; j < id.shape(0); ++j) {
+        int m       = id(j, 0);
+        int n       = id(j, 1);
+        dcomplex z1 = dcomplex(0, (2 * m + (stat1 == Fermion)) * pi / beta);
+        dcomplex z2 = dcomplex(0, (2 * n + (stat2 == Fermion)) * pi / beta);
+
+        dcomplex v = lehmann3(z1, z2);
+        if (stat1 == Boson && m == 0) v += 0.4 / (z2 - 0.6);
+        if (stat2 == Boson && n == 0) v += 0.3 / (z1 + 0.35);
+        if (stat1 == stat2 && std::abs(z1 + z2) < 1e-12) v += 0.2 / (z1 - 0.25);
+        vals(j) = v;
+      }
+      return vals;
+    };
+
+    // Fit on mixed-statistics 2D DLR grid, and compare on box
+    auto dlr2d_if         = build_dlr2d_if(lambda, eps, DiagThreshold, stat1, stat2);
+    auto cf2if            = build_cf2if(beta, dlr_rf, dlr2d_if, stat1, stat2);
+    auto [fc_reg, fc_sng] = vals2coefs_if_mixed(cf2if, gtru(dlr2d_if), r, stat1, stat2);
+
+    auto tru = gtru(idx);
+    auto fit = coefs2eval_if_mixed(beta, dlr_rf, fc_reg, fc_sng, idx, stat1, stat2);
+    errfit   = std::max(errfit, max_element(abs(tru - fit)) / max_element(abs(tru)));
+  }
+
+  fmt::print("Relative error of mixed-statistics 2D DLR fit of Lehmann three-point function on box: {}\n\n", errfit);
+
+  EXPECT_LT(errfit, 100 * eps);
+}
+
+/*!
+ * \brief Test evaluation of 2D DLR expansion at complex frequencies against
+ * Matsubara frequency evaluation, on a box of Matsubara frequency points
+ */
+TEST(dlr2d, coefs2eval_z) {
+  double beta   = 8;    // Inverse temperature
+  double lambda = 8;    // DLR cutoff
+  double eps    = 1e-8; // DLR tolerance
+  int nbox      = 10;   // Half-width of box of test points
+
+  auto dlr_rf = build_dlr_rf(lambda, eps);
+  int r       = dlr_rf.size();
+
+  // Arbitrary expansion coefficients
+  auto gc_reg = arbitrary_coefs<3>({3, r, r});
+  auto gc_sng = arbitrary_coefs<1>({r});
+
+  // Box of Matsubara frequency points, as index pairs and as complex
+  // frequencies
+  auto idx = box_idx(nbox, 2);
+  auto z   = nda::array<dcomplex, 2>(idx.shape(0), 2);
+  for (int i = 0; i < idx.shape(0); ++i) {
+    z(i, 0) = (2 * idx(i, 0) + 1) * pi * 1i / beta;
+    z(i, 1) = (2 * idx(i, 1) + 1) * pi * 1i / beta;
+  }
+
+  double err = 0;
+  for (int channel = 1; channel <= 2; ++channel) {
+    auto gif = coefs2eval_if(beta, dlr_rf, gc_reg, gc_sng, idx, channel);
+    auto gz  = coefs2eval_z(beta, dlr_rf, gc_reg, gc_sng, z, channel);
+    err      = std::max(err, max_element(abs(gif - gz)) / max_element(abs(gif)));
+  }
+
+  fmt::print("Relative deviation of complex frequency evaluation from Matsubara evaluation: {}\n\n", err);
+
+  EXPECT_LT(err, 1e-12);
+}
+
+/*!
+ * \brief Test evaluation of 2D DLR expansion at complex frequencies off the
+ * imaginary axis, for the fit of a three-point function given by its Lehmann
+ * representation with explicit poles
+ */
+TEST(dlr2d, coefs2eval_z_lehmann) {
+  double beta   = 8;    // Inverse temperature
+  double lambda = 8;    // DLR cutoff
+  double eps    = 1e-8; // DLR tolerance
+  int nbox      = 10;   // Half-width of box of test points
+  double del1   = 0.25; // Real shift of first frequency
+  double del2   = 0.05; // Real shift of second frequency
+
+  auto dlr_rf = build_dlr_rf(lambda, eps);
+  int r       = dlr_rf.size();
+
+  // Fit of Lehmann three-point function (see lehmann3) on 2D DLR grid
+  auto dlr2d_if         = build_dlr2d_if(lambda, eps);
+  auto cf2if            = build_cf2if(beta, dlr_rf, dlr2d_if);
+  auto [gc_reg, gc_sng] = vals2coefs_if(cf2if, lehmann3_if(beta, dlr2d_if), r);
+
+  // Box of points z = i nu + delta off the imaginary axis; the shifts keep
+  // |beta (z1 + z2)| away from zero, so the singular part is not included
+  auto idx = box_idx(nbox, 2);
+  auto z   = nda::array<dcomplex, 2>(idx.shape(0), 2);
+  auto tru = nda::vector<dcomplex>(idx.shape(0));
+  for (int i = 0; i < idx.shape(0); ++i) {
+    z(i, 0) = (2 * idx(i, 0) + 1) * pi * 1i / beta + del1;
+    z(i, 1) = (2 * idx(i, 1) + 1) * pi * 1i / beta + del2;
+    tru(i)  = lehmann3(z(i, 0), z(i, 1));
+  }
+
+  auto gz    = coefs2eval_z(beta, dlr_rf, gc_reg, gc_sng, z, 1);
+  double err = max_element(abs(gz - tru)) / max_element(abs(tru));
+
+  fmt::print("Relative error of off-axis evaluation of 2D DLR fit of Lehmann three-point function: {}\n\n", err);
+
+  EXPECT_LT(err, 1000 * eps);
+}
+
+/*!
+ * \brief Test closed-form partial Matsubara summation of 2D DLR expansion
+ * against extrapolated truncated box summation, and 1D DLR fit of result
+ */
+TEST(dlr2d, sum_if) {
+  double beta   = 8;    // Inverse temperature
+  double lambda = 8;    // DLR cutoff
+  double eps    = 1e-8; // DLR tolerance
+  int nsum      = 2000; // Half-width of box for truncated summation
+  int ny        = 6;    // Half-width of range of remaining index
+
+  auto dlr_rf = build_dlr_rf(lambda, eps);
+  int r       = dlr_rf.size();
+
+  // Arbitrary expansion coefficients
+  auto gc_reg = arbitrary_coefs<3>({3, r, r});
+  auto gc_sng = arbitrary_coefs<1>({r});
+
+  auto y = nda::vector<int>(2 * ny);
+  for (int i = 0; i < 2 * ny; ++i) { y(i) = i - ny; }
+
+  // Truncated box sums over -nsum <= x < nsum and -2 nsum <= x < 2 nsum,
+  // combined by Richardson extrapolation to remove O(1/nsum) truncation error
+  auto idx = nda::array<int, 2>(4 * nsum, 2);
+
+  double err = 0, errfit = 0;
+  auto ifops = imfreq_ops(2 * lambda, build_dlr_rf(2 * lambda, eps), Fermion);
+  for (int channel = 1; channel <= 2; ++channel) {
+    for (int arg = 1; arg <= 2; ++arg) {
+      auto s = sum_if_vals(beta, dlr_rf, gc_reg, gc_sng, y, arg, channel);
+      for (int i = 0; i < 2 * ny; ++i) {
+        for (int x = 0; x < 4 * nsum; ++x) {
+          idx(x, arg - 1) = x - 2 * nsum;
+          idx(x, 2 - arg) = y(i);
+        }
+        auto g  = coefs2eval_if(beta, dlr_rf, gc_reg, gc_sng, idx, channel);
+        auto s1 = sum(g(nda::range(nsum, 3 * nsum))) / beta;
+        auto s2 = sum(g) / beta;
+        err     = std::max(err, abs(s(i) - (2.0 * s2 - s1)) / abs(s(i)));
+      }
+
+      // 1D DLR fit of partial sum
+      auto sc = sum_if(beta, dlr_rf, gc_reg, gc_sng, ifops, arg, channel);
+      for (int i = 0; i < 2 * ny; ++i) { errfit = std::max(errfit, abs(s(i) - ifops.coefs2eval(beta, sc, y(i))) / max_element(abs(s))); }
+    }
+  }
+
+  fmt::print("Max relative deviation of closed-form partial sum from extrapolated box sum: {}\n", err);
+  fmt::print("Max relative error of 1D DLR fit of partial sum: {}\n\n", errfit);
+
+  EXPECT_LT(err, 1e-5);
+  EXPECT_LT(errfit, 100 * eps);
+}
+
+/*!
+ * \brief Test that the grid selected by tournament pivoting fits a Lehmann
+ * three-point function to the DLR tolerance
+ */
+TEST(dlr2d, tournament) {
+  double beta   = 8;    // Inverse temperature
+  double lambda = 8;    // DLR cutoff
+  double eps    = 1e-8; // DLR tolerance
+
+  auto dlr2d_if = build_dlr2d_if_tournament(lambda, eps, 4);
+  double err    = lehmann_fit_error(beta, lambda, eps, dlr2d_if, 10);
+
+  fmt::print("Grid sizes: tournament {}, reference {}\n", dlr2d_if.shape(0), build_dlr2d_if(lambda, eps).shape(0));
+  fmt::print("Relative error of fit on tournament grid: {}\n\n", err);
+
+  EXPECT_LT(err, 100 * eps);
+}
+
+/*!
+ * \brief Test that the grids selected by streaming pivoting, with and without
+ * a Gaussian sketch, fit a Lehmann three-point function to the DLR tolerance
+ */
+TEST(dlr2d, streaming) {
+  double beta   = 8;    // Inverse temperature
+  double lambda = 8;    // DLR cutoff
+  double eps    = 1e-8; // DLR tolerance
+  int tilesize  = 128;  // # fine grid nodes per tile
+
+  // Sketch dimension 64 is below the rank, so the sketch is also enlarged
+  auto dlr2d_if     = build_dlr2d_if_streaming(lambda, eps, tilesize, 0);
+  auto dlr2d_if_skt = build_dlr2d_if_streaming(lambda, eps, tilesize, 64);
+  double err        = lehmann_fit_error(beta, lambda, eps, dlr2d_if, 10);
+  double errskt     = lehmann_fit_error(beta, lambda, eps, dlr2d_if_skt, 10);
+
+  fmt::print("Grid sizes: streaming {}, sketched streaming {}\n", dlr2d_if.shape(0), dlr2d_if_skt.shape(0));
+  fmt::print("Relative error of fit on streaming grid: {}\n", err);
+  fmt::print("Relative error of fit on sketched streaming grid: {}\n\n", errskt);
+
+  EXPECT_LT(err, 100 * eps);
+  EXPECT_LT(errskt, 100 * eps);
+}
+
+/*!
+ * \brief Test that the grids of a lambda ladder are nested, each containing
+ * the previous one as its first rows, that they contain no repeated index
+ * pairs, and that each yields an accurate fit at its own cutoff
+ */
+TEST(dlr2d, ladder) {
+  double beta  = 2;    // Inverse temperature (beta * pole <= smallest cutoff)
+  double eps   = 1e-8; // DLR tolerance
+  auto lambdas = nda::vector<double>({2.0, 4.0, 8.0});
+
+  auto dlr2d_ifs = build_dlr2d_if_ladder(lambdas, eps);
+
+  ASSERT_EQ(long(dlr2d_ifs.size()), lambdas.size());
+  for (int i = 0; i < lambdas.size(); ++i) {
+    auto &dlr2d_if = dlr2d_ifs[i];
+    int niom       = dlr2d_if.shape(0);
+
+    if (i > 0) {
+      int nprev = dlr2d_ifs[i - 1].shape(0);
+      ASSERT_GE(niom, nprev);
+      EXPECT_TRUE(dlr2d_if(nda::range(nprev), _) == dlr2d_ifs[i - 1]);
+    }
+
+    auto pairs = std::set<std::pair<int, int>>();
+    for (int j = 0; j < niom; ++j) { pairs.insert({dlr2d_if(j, 0), dlr2d_if(j, 1)}); }
+    EXPECT_EQ(long(pairs.size()), niom);
+
+    double err = lehmann_fit_error(beta, lambdas(i), eps, dlr2d_if, 10);
+    fmt::print("Lambda = {}: grid size {}, relative error of fit {}\n", lambdas(i), niom, err);
+    EXPECT_LT(err, 100 * eps);
+  }
+  fmt::print("\n");
+}
+
+/*!
+ * \brief Test that the grids obtained for several tolerances from a single
+ * pivoted QR decomposition are prefixes of one another, that each yields a fit
+ * accurate to its own tolerance, and that the grid for the tightest tolerance
+ * is that obtained by \ref build_dlr2d_if
+ */
+TEST(dlr2d, multieps) {
+  double beta   = 8; // Inverse temperature
+  double lambda = 8; // DLR cutoff
+  auto epss     = nda::vector<double>({1e-8, 1e-4, 1e-6});
+
+  auto dlr2d_ifs = build_dlr2d_if_multieps(lambda, epss);
+
+  // Order grids by decreasing tolerance
+  auto order = std::array<int, 3>{1, 2, 0};
+  for (int i = 1; i < 3; ++i) {
+    auto &loose = dlr2d_ifs[order[i - 1]];
+    auto &tight = dlr2d_ifs[order[i]];
+    int nloose  = loose.shape(0);
+    ASSERT_LE(nloose, tight.shape(0));
+    EXPECT_TRUE(tight(nda::range(nloose), _) == loose);
+  }
+
+  for (int i = 0; i < epss.size(); ++i) {
+    double err = lehmann_fit_error(beta, lambda, epss(i), dlr2d_ifs[i], 10);
+    fmt::print("Epsilon = {}: grid size {}, relative error of fit {}\n", epss(i), dlr2d_ifs[i].shape(0), err);
+    EXPECT_LT(err, 100 * epss(i));
+  }
+  fmt::print("\n");
+
+  auto dlr2d_if = build_dlr2d_if(lambda, epss(0));
+  ASSERT_EQ(dlr2d_ifs[0].shape(0), dlr2d_if.shape(0));
+  EXPECT_TRUE(dlr2d_ifs[0] == dlr2d_if);
+}
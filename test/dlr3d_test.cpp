@@ -0,0 +1,105 @@
+#include "dlr3d.hpp"
+#include "test_utils.hpp"
+
+#include <array>
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+using namespace dlr2d;
+
+/*!
+ * \brief Test 3D DLR: consistency of batched evaluation with coefficients to
+ * values matrix, and recovery of an expansion from its values on the 3D DLR
+ * grid
+ */
+TEST(dlr3d, fit) {
+  double beta   = 2;    // Inverse temperature
+  double lambda = 2;    // DLR cutoff
+  double eps    = 1e-5; // DLR tolerance
+  int nbox      = 4;    // Half-width of box of test points
+
+  auto dlr_rf = build_dlr_rf(lambda, eps);
+  int r       = dlr_rf.size();
+
+  // Arbitrary expansion coefficients
+  auto gc_reg = arbitrary_coefs<4>({12, r, r, r});
+  auto gc_sng = arbitrary_coefs<3>({3, r, r});
+
+  // Values on 3D DLR grid, by batched evaluation and by coefficients to values
+  // matrix
+  auto dlr3d_if = build_dlr3d_if(lambda, eps);
+  auto cf3if    = build_cf3if(beta, dlr_rf, dlr3d_if);
+  auto vals     = coefs2eval_if3d(beta, dlr_rf, gc_reg, gc_sng, dlr3d_if);
+
+  int nreg  = 12 * r * r * r;
+  auto coef = nda::vector<dcomplex>(nreg + 3 * r * r);
+
+  coef(nda::range(nreg))                   = reshape(gc_reg, nreg);
+  coef(nda::range(nreg, nreg + 3 * r * r)) = reshape(gc_sng, 3 * r * r);
+
+  auto vals_mat = nda::vector<dcomplex>(cf3if * coef);
+  double errcf  = max_element(abs(vals - vals_mat)) / max_element(abs(vals));
+
+  // Recover expansion from values on grid, and compare on a box of test
+  // points, which includes points on the singular planes
+  auto [fc_reg, fc_sng] = vals2coefs_if3d(cf3if, vals, r);
+
+  auto idx = box_idx(nbox, 3);
+  auto gtru     = coefs2eval_if3d(beta, dlr_rf, gc_reg, gc_sng, idx);
+  auto gfit     = coefs2eval_if3d(beta, dlr_rf, fc_reg, fc_sng, idx);
+  double errfit = max_element(abs(gtru - gfit)) / max_element(abs(gtru));
+
+  fmt::print("Relative deviation of batched evaluation from coefficients to values matrix: {}\n", errcf);
+  fmt::print("Relative error of 3D DLR fit on box: {}\n\n", errfit);
+
+  EXPECT_LT(errcf, 1e-12);
+  EXPECT_LT(errfit, 100 * eps);
+}
+
+/*!
+ * \brief Test 3D DLR fit of a four-point function given by its Lehmann
+ * representation with explicit poles, including a singular term
+ */
+TEST(dlr3d, lehmann) {
+  double beta   = 2;    // Inverse temperature
+  double lambda = 1;    // DLR cutoff
+  double eps    = 1e-6; // DLR tolerance
+  int nbox      = 4;    // Half-width of box of test points
+
+  auto dlr_rf = build_dlr_rf(lambda, eps);
+  int r       = dlr_rf.size();
+
+  // Four-point function with one regular term in each pair partition, with
+  // poles |beta * omega| < lambda, and a term supported on nu_1 + nu_2 = 0
+  auto gtru = [&](nda::array_const_view<int, 2> idx) {
+    auto vals = nda::vector<dcomplex>(idx.shape(0));
+    for (int j = 0; j < idx.shape(0); ++j) {
+      auto z = std::array<dcomplex, 4>{};
+      int n4 = -idx(j, 0) - idx(j, 1) - idx(j, 2) - 2;
+      for (int q = 0; q < 4; ++q) { z[q] = dcomplex(0, (2 * (q < 3 ? idx(j, q) : n4) + 1) * pi / beta); }
+
+      dcomplex v = 1.0 / ((z[0] - 0.2) * (z[0] + z[1] - 0.3) * (z[2] + 0.35));
+      v += 0.5 / ((z[2] + 0.1) * (z[0] + z[2] + 0.25) * (z[3] - 0.4));
+      v -= 0.8 / ((z[3] - 0.15) * (z[0] + z[3] + 0.2) * (z[1] - 0.3));
+      if (idx(j, 0) + idx(j, 1) + 1 == 0) v += 0.6 / ((z[0] - 0.45) * (z[2] + 0.2));
+      vals(j) = v;
+    }
+    return vals;
+  };
+
+  // Fit on 3D DLR grid
+  auto dlr3d_if         = build_dlr3d_if(lambda, eps);
+  auto cf3if            = build_cf3if(beta, dlr_rf, dlr3d_if);
+  auto [fc_reg, fc_sng] = vals2coefs_if3d(cf3if, gtru(dlr3d_if), r);
+
+  // Compare on a box of test points, which includes points on the singular
+  // planes
+  auto idx = box_idx(nbox, 3);
+  auto tru      = gtru(idx);
+  auto fit      = coefs2eval_if3d(beta, dlr_rf, fc_reg, fc_sng, idx);
+  double errfit = max_element(abs(tru - fit)) / max_element(abs(tru));
+
+  fmt::print("Relative error of 3D DLR fit of Lehmann four-point function on box: {}\n\n", errfit);
+
+  EXPECT_LT(errfit, 100 * eps);
+}
@@ -0,0 +1,51 @@
+#include "parameters.hpp"
+#include "test_utils.hpp"
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+using namespace dlr2d;
+
+/*!
+ * \brief Test choice of DLR tolerance for representative noise levels,
+ * including noise below, and absent beyond, the 1e-14 floor
+ */
+TEST(parameters, choose_eps) {
+  EXPECT_DOUBLE_EQ(choose_eps(0.5), 1e-1);
+  EXPECT_DOUBLE_EQ(choose_eps(1e-3), 1e-3);
+  EXPECT_DOUBLE_EQ(choose_eps(3e-5), 1e-5);
+  EXPECT_DOUBLE_EQ(choose_eps(9.9e-9), 1e-9);
+  EXPECT_DOUBLE_EQ(choose_eps(2e-14), 1e-14);
+  EXPECT_DOUBLE_EQ(choose_eps(1e-16), 1e-14);
+  EXPECT_DOUBLE_EQ(choose_eps(0), 1e-14);
+}
+
+/*!
+ * \brief Test choice of DLR cutoff from a bound on the spectral support, and
+ * from samples of a Green's function with a single pole
+ */
+TEST(parameters, choose_lambda) {
+  double beta = 10;   // Inverse temperature
+  double eps  = 1e-8; // DLR tolerance
+
+  // From bound on spectral support: rounded up to a power of 2, at least 1
+  EXPECT_EQ(choose_lambda(beta, 3.0), 32);
+  EXPECT_EQ(choose_lambda(beta, 1.6), 16);
+  EXPECT_EQ(choose_lambda(beta, 0.01), 1);
+
+  // From samples: a pole at omega with beta * omega = 15 requires lambda > 1,
+  // and is resolved by the cutoff chosen from its spectral support
+  double om  = 1.5;
+  auto g     = [&](int n) { return 1.0 / ((2 * n + 1) * pi * 1i / beta - om); };
+  double lam = choose_lambda(beta, g, eps, 64);
+  fmt::print("Lambda chosen for pole at beta * omega = {}: {}\n", beta * om, lam);
+
+  EXPECT_GT(lam, 1);
+  EXPECT_LE(lam, choose_lambda(beta, om));
+  EXPECT_EQ(lam, choose_lambda(lam, 1.0)); // Power of 2
+
+  // A pole beyond the largest cutoff considered is never resolved
+  auto gfar = [&](int n) { return 1.0 / ((2 * n + 1) * pi * 1i / beta - 100.0); };
+  EXPECT_EQ(choose_lambda(beta, gfar, eps, 8), 8);
+  fmt::print("\n");
+}
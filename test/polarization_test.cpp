@@ -0,0 +1,99 @@
+#include "polarization.hpp"
+#include "test_utils.hpp"
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+using namespace dlr2d;
+
+/*!
+ * \brief Test polarization plan against direct computation of polarization,
+ * for repeated calls with different inputs
+ */
+TEST(polarization, plan) {
+  double beta   = 8;    // Inverse temperature
+  double lambda = 8;    // DLR cutoff
+  double eps    = 1e-8; // DLR tolerance
+
+  auto dlr_rf    = build_dlr_rf(lambda, eps);
+  int r          = dlr_rf.size();
+  auto itops     = imtime_ops(lambda, dlr_rf);
+  auto ifops_fer = imfreq_ops(lambda, dlr_rf, Fermion);
+  auto ifops_bos = imfreq_ops(lambda, dlr_rf, Boson);
+  auto plan      = polarization_plan(beta, lambda, eps, ifops_fer, ifops_bos);
+
+  auto fc    = nda::array<dcomplex, 1>(r);
+  auto gc    = nda::array<dcomplex, 1>(r);
+  auto lambc = nda::array<dcomplex, 3>(3, r, r);
+  auto lsng  = nda::array<dcomplex, 1>(r);
+
+  double err = 0;
+  for (int rep = 0; rep < 2; ++rep) {
+
+    // Arbitrary inputs, different for each repetition
+    for (int k = 0; k < r; ++k) {
+      fc(k)   = dcomplex(1.0 / (1 + k + rep), 0.5 / (2 + k));
+      gc(k)   = dcomplex(0.5 / (1 + k), -1.0 / (3 + k + rep));
+      lsng(k) = dcomplex(1.0 / (2 + k), rep);
+      for (int t = 0; t < 3; ++t) {
+        for (int l = 0; l < r; ++l) { lambc(t, k, l) = dcomplex(1.0 / (1 + t + k + l + rep), 1.0 / (2 + t * l + k)); }
+      }
+    }
+
+    auto pol     = polarization(beta, lambda, eps, itops, ifops_fer, ifops_bos, fc, gc, lambc, lsng);
+    auto pol_pln = plan.execute(fc, gc, lambc, lsng);
+    err          = std::max(err, max_element(abs(pol - pol_pln)) / max_element(abs(pol)));
+
+    auto lambc3   = nda::array<dcomplex, 3>(lambc(nda::range(2), _, _));
+    auto pol3     = polarization_3term(beta, lambda, eps, itops, ifops_fer, ifops_bos, fc, gc, lambc3, lsng);
+    auto pol3_pln = plan.execute_3term(fc, gc, lambc3, lsng);
+    err           = std::max(err, max_element(abs(pol3 - pol3_pln)) / max_element(abs(pol3)));
+  }
+
+  fmt::print("Max relative deviation of plan from direct polarization: {}\n\n", err);
+
+  EXPECT_LT(err, 1e-10);
+}
+
+/*!
+ * \brief Test residue calculus-based polarization plan against direct
+ * computation, for repeated calls with different inputs
+ */
+TEST(polarization, res_plan) {
+  double beta   = 8;    // Inverse temperature
+  double lambda = 8;    // DLR cutoff
+  double eps    = 1e-8; // DLR tolerance
+
+  auto dlr_rf    = build_dlr_rf(lambda, eps);
+  int r          = dlr_rf.size();
+  auto ifops_fer = imfreq_ops(lambda, dlr_rf, Fermion);
+  auto ifops_bos = imfreq_ops(lambda, dlr_rf, Boson);
+  auto plan      = polarization_res_plan(beta, ifops_fer, ifops_bos);
+
+  auto fc    = nda::array<dcomplex, 1>(r);
+  auto gc    = nda::array<dcomplex, 1>(r);
+  auto lambc = nda::array<dcomplex, 3>(3, r, r);
+  auto lsng  = nda::array<dcomplex, 1>(r);
+
+  double err = 0;
+  for (int rep = 0; rep < 2; ++rep) {
+
+    // Arbitrary inputs, different for each repetition
+    for (int k = 0; k < r; ++k) {
+      fc(k)   = dcomplex(1.0 / (1 + k + rep), 0.5 / (2 + k));
+      gc(k)   = dcomplex(0.5 / (1 + k), -1.0 / (3 + k + rep));
+      lsng(k) = dcomplex(1.0 / (2 + k), rep);
+      for (int t = 0; t < 3; ++t) {
+        for (int l = 0; l < r; ++l) { lambc(t, k, l) = dcomplex(1.0 / (1 + t + k + l + rep), 1.0 / (2 + t * l + k)); }
+      }
+    }
+
+    auto pol     = polarization_res(beta, ifops_fer, ifops_bos, fc, gc, lambc, lsng);
+    auto pol_pln = plan.execute(fc, gc, lambc, lsng);
+    err          = std::max(err, max_element(abs(pol - pol_pln)) / max_element(abs(pol)));
+  }
+
+  fmt::print("Max relative deviation of plan from direct residue calculus-based polarization: {}\n\n", err);
+
+  EXPECT_LT(err, 1e-10);
+}
@@ -0,0 +1,126 @@
+#include "products.hpp"
+#include "test_utils.hpp"
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+using namespace dlr2d;
+
+/*!
+ * \brief Test evaluation of 1D DLR expansions on the legs of the 2D DLR grid
+ * against pointwise evaluation at the frequencies of each grid point, in both
+ * channels
+ */
+TEST(products, vals_1d) {
+  double beta   = 8;     // Inverse temperature
+  double lambda = 8;     // DLR cutoff
+  double eps    = 1e-10; // DLR tolerance
+
+  auto dlr_rf    = build_dlr_rf(lambda, eps);
+  int r          = dlr_rf.size();
+  auto dlr2d_if  = build_dlr2d_if(lambda, eps);
+  auto ops       = dlr2d_if_ops(beta, dlr_rf, dlr2d_if);
+  auto ifops_fer = imfreq_ops(lambda, dlr_rf, Fermion);
+  auto ifops_bos = imfreq_ops(lambda, dlr_rf, Boson);
+  auto gc        = arbitrary_coefs<1>({r});
+
+  double err = 0;
+  for (int channel = 1; channel <= 2; ++channel) {
+    auto v0 = ops.vals_1d(ifops_fer, gc, 0, channel);
+    auto v1 = ops.vals_1d(ifops_fer, gc, 1, channel);
+    auto v2 = ops.vals_1d(ifops_bos, gc, 2, channel);
+    for (int i = 0; i < dlr2d_if.shape(0); ++i) {
+      // Frequencies (nu1, nu2) of grid point, as evaluated by coefs2eval_if,
+      // and bosonic frequency of channel
+      int m  = (channel == 1) ? dlr2d_if(i, 0) : -dlr2d_if(i, 0) - 1;
+      int n  = dlr2d_if(i, 1);
+      int om = (channel == 1) ? (2 * m + 1) + (2 * n + 1) : (2 * n + 1) - (2 * m + 1);
+      err    = std::max(err, abs(v0(i) - ifops_fer.coefs2eval(beta, gc, m)));
+      err    = std::max(err, abs(v1(i) - ifops_fer.coefs2eval(beta, gc, n)));
+      err    = std::max(err, abs(v2(i) - ifops_bos.coefs2eval(beta, gc, om / 2)));
+    }
+  }
+
+  fmt::print("Max deviation of leg values from pointwise evaluation: {}\n\n", err);
+
+  EXPECT_LT(err, 1e-12);
+}
+
+/*!
+ * \brief Test products and quotients of 2D DLR expansions with 1D DLR
+ * expansions in both fermionic arguments against pointwise products, in both
+ * channels
+ */
+TEST(products, mul_div) {
+  double beta   = 4;     // Inverse temperature
+  double lambda = 4;     // DLR cutoff
+  double eps    = 1e-12; // DLR tolerance
+  int nbox      = 12;    // Half-width of box of test points
+
+  auto dlr_rf    = build_dlr_rf(lambda, eps);
+  int r          = dlr_rf.size();
+  auto dlr2d_if  = build_dlr2d_if(lambda, eps);
+  auto ops       = dlr2d_if_ops(beta, dlr_rf, dlr2d_if);
+  auto ifops_fer = imfreq_ops(lambda, dlr_rf, Fermion);
+
+  // 1D factors with single poles between the DLR real frequencies
+  auto dlr_if = ifops_fer.get_ifnodes();
+  auto glv    = nda::vector<dcomplex>(r);
+  auto grv    = nda::vector<dcomplex>(r);
+  for (int k = 0; k < r; ++k) {
+    auto nu = (2 * dlr_if(k) + 1) * pi * 1i / beta;
+    glv(k)  = 1.0 / (nu - 0.37);
+    grv(k)  = 1.0 / (nu + 0.61);
+  }
+  auto gl = nda::array<dcomplex, 1>(ifops_fer.vals2coefs(beta, glv));
+  auto gr = nda::array<dcomplex, 1>(ifops_fer.vals2coefs(beta, grv));
+
+  // 2D expansion with first regular term only, so that its products with the
+  // 1D factors are again 2D DLR expansions
+  auto f_reg                    = arbitrary_coefs<3>({3, r, r});
+  auto f_sng                    = nda::zeros<dcomplex>(r);
+  f_reg(nda::range(1, 3), _, _) = 0;
+
+  // Stack of two expansions for mul_if_many
+  auto f_reg2 = nda::array<dcomplex, 4>(2, 3, r, r);
+  auto f_sng2 = nda::array<dcomplex, 2>(2, r);
+  for (int j = 0; j < 2; ++j) {
+    f_reg2(j, _, _, _) = dcomplex(j + 1) * f_reg;
+    f_sng2(j, _)       = f_sng;
+  }
+
+  double errmul = 0, errdiv = 0, errmany = 0;
+  for (int channel = 1; channel <= 2; ++channel) {
+    auto [p_reg, p_sng]   = mul_if(ops, ifops_fer, gl, gr, f_reg, f_sng, channel);
+    auto [q_reg, q_sng]   = div_if(ops, ifops_fer, gl, gr, p_reg, p_sng, channel);
+    auto [p_reg2, p_sng2] = mul_if_many(ops, ifops_fer, gl, gr, f_reg2, f_sng2, channel);
+
+    double pmax = 0, fmax = 0, emul = 0, ediv = 0, emany = 0;
+    for (int m = -nbox; m < nbox; ++m) {
+      for (int n = -nbox; n < nbox; ++n) {
+        auto f   = coefs2eval_if(beta, dlr_rf, f_reg, f_sng, m, n, channel);
+        auto p   = f * ifops_fer.coefs2eval(beta, gl, m) * ifops_fer.coefs2eval(beta, gr, n);
+        auto pm  = coefs2eval_if(beta, dlr_rf, p_reg, p_sng, m, n, channel);
+        auto pm2 = coefs2eval_if(beta, dlr_rf, p_reg2(1, _, _, _), p_sng2(1, _), m, n, channel);
+        pmax     = std::max(pmax, abs(p));
+        fmax     = std::max(fmax, abs(f));
+        emul     = std::max(emul, abs(p - pm));
+        ediv     = std::max(ediv, abs(f - coefs2eval_if(beta, dlr_rf, q_reg, q_sng, m, n, channel)));
+        emany    = std::max(emany, abs(pm2 - 2.0 * pm));
+      }
+    }
+    errmul  = std::max(errmul, emul / pmax);
+    errdiv  = std::max(errdiv, ediv / fmax);
+    errmany = std::max(errmany, emany / pmax);
+  }
+
+  fmt::print("Relative error of product: {}\n", errmul);
+  fmt::print("Relative error of quotient: {}\n", errdiv);
+  fmt::print("Max relative deviation of batched from single product: {}\n\n", errmany);
+
+  // Division by the decaying 1D factors amplifies the fitting error of the
+  // product at high frequencies
+  EXPECT_LT(errmul, 1e-8);
+  EXPECT_LT(errdiv, 1e-6);
+  EXPECT_LT(errmany, 1e-10);
+}
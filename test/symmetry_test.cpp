@@ -0,0 +1,89 @@
+#include "symmetry.hpp"
+#include "test_utils.hpp"
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+using namespace dlr2d;
+
+/*!
+ * \brief Test that the number of irreducible index pairs in a box, which is
+ * closed under both symmetries, is the number of orbits
+ */
+TEST(symmetry, irreducible_if) {
+  int nbox = 10; // Half-width of box
+
+  int n2   = 2 * nbox;
+  auto idx = box_idx(nbox, 2);
+
+  // Exchange and conjugation each halve the box, except on the diagonal,
+  // which is fixed by exchange, and the anti-diagonal, on which exchange does
+  // not act
+  auto irr = irreducible_if(idx, {.exchange = true, .conjugation = true});
+  EXPECT_EQ(irr.shape(0), nbox * nbox + nbox);
+
+  // Irreducible index pairs are their own representatives
+  EXPECT_TRUE(irreducible_if(irr, {.exchange = true, .conjugation = true}) == irr);
+
+  // Conjugation alone pairs up all index pairs
+  EXPECT_EQ(irreducible_if(idx, {.exchange = false, .conjugation = true}).shape(0), n2 * n2 / 2);
+}
+
+/*!
+ * \brief Test symmetry-reduced 2D DLR fit of a three-point function symmetric
+ * under exchange and conjugation against the ordinary fit, and check that the
+ * symmetry-reduced grids are smaller than the ordinary one, and at most half
+ * its size under both symmetries
+ */
+TEST(symmetry, fit) {
+  double beta   = 8;    // Inverse temperature
+  double lambda = 8;    // DLR cutoff
+  double eps    = 1e-8; // DLR tolerance
+  int nbox      = 10;   // Half-width of box of test points
+
+  auto dlr_rf = build_dlr_rf(lambda, eps);
+  int r       = dlr_rf.size();
+
+  // Lehmann three-point function (see lehmann3), which has real poles and
+  // weights and so satisfies conjugation, symmetrized under exchange
+  auto gtru = [&](nda::array_const_view<int, 2> id) {
+    auto idt  = nda::array<int, 2>(id.shape(0), 2);
+    idt(_, 0) = id(_, 1);
+    idt(_, 1) = id(_, 0);
+    return nda::vector<dcomplex>(lehmann3_if(beta, id) + lehmann3_if(beta, idt));
+  };
+
+  // Box of test points
+  auto idx = box_idx(nbox, 2);
+  auto tru = gtru(idx);
+
+  // Ordinary fit
+  auto dlr2d_if         = build_dlr2d_if(lambda, eps);
+  auto cf2if            = build_cf2if(beta, dlr_rf, dlr2d_if);
+  auto [gc_reg, gc_sng] = vals2coefs_if(cf2if, gtru(dlr2d_if), r);
+  auto fit              = coefs2eval_if(beta, dlr_rf, gc_reg, gc_sng, idx, 1);
+
+  double errfull = max_element(abs(tru - fit)) / max_element(abs(tru));
+  fmt::print("Relative error of ordinary fit: {}\n", errfull);
+  EXPECT_LT(errfull, 100 * eps);
+
+  // Symmetry-reduced fits
+  auto syms = std::array<symmetry_t, 2>{{{.exchange = true, .conjugation = false}, {.exchange = true, .conjugation = true}}};
+  for (auto sym : syms) {
+    auto dlr2d_if_sym       = build_dlr2d_if_sym(lambda, eps, sym);
+    auto cf2if_sym          = build_cf2if_sym(beta, dlr_rf, dlr2d_if_sym, sym);
+    auto [gcs_reg, gcs_sng] = vals2coefs_if_sym(cf2if_sym, gtru(dlr2d_if_sym), r, sym);
+    auto fit_sym            = coefs2eval_if(beta, dlr_rf, gcs_reg, gcs_sng, idx, 1);
+    double errsym           = max_element(abs(tru - fit_sym)) / max_element(abs(tru));
+    double diff             = max_element(abs(fit - fit_sym)) / max_element(abs(tru));
+
+    fmt::print("Symmetries (exchange = {}, conjugation = {}): grid size {} (ordinary {}), relative error {}, deviation from ordinary fit {}\n",
+               sym.exchange, sym.conjugation, dlr2d_if_sym.shape(0), dlr2d_if.shape(0), errsym, diff);
+
+    EXPECT_LT(errsym, 100 * eps);
+    EXPECT_LT(diff, 100 * eps);
+    EXPECT_LT(dlr2d_if_sym.shape(0), dlr2d_if.shape(0));
+    if (sym.conjugation) { EXPECT_LE(2 * dlr2d_if_sym.shape(0), dlr2d_if.shape(0)); }
+  }
+  fmt::print("\n");
+}
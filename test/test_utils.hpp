@@ -0,0 +1,113 @@
+#pragma once
+
+#include "dlr2d.hpp"
+
+#include <array>
+
+/*!
+ * \brief Arbitrary expansion coefficients for tests
+ *
+ * \param[in] shape Shape of coefficient array
+ *
+ * \return Coefficient array whose entries are smooth, nonvanishing functions
+ * of the indices
+ */
+template <int R> nda::array<std::complex<double>, R> arbitrary_coefs(std::array<long, R> const &shape) {
+  auto c    = nda::array<std::complex<double>, R>(shape);
+  auto flat = reshape(c, c.size());
+  for (long i = 0; i < c.size(); ++i) {
+    // Multi-index (j_0, ..., j_{R-1}) of i, and weighted sums of its entries
+    long j = i, s = 0, p = 0;
+    for (int d = R - 1; d >= 0; --d) {
+      long jd = j % shape[d];
+      j /= shape[d];
+      s += (d + 1) * jd;
+      p += jd * jd;
+    }
+    flat(i) = std::complex<double>(1.0 / (1 + s), 1.0 / (2 + p));
+  }
+  return c;
+}
+
+/*!
+ * \brief Box of Matsubara frequency index tuples for tests
+ *
+ * \param[in] nbox Half-width of box
+ * \param[in] dim  # indices per tuple
+ *
+ * \return (2 nbox)^dim x dim array of all tuples with entries -nbox <= n <
+ * nbox, with the last index varying fastest
+ */
+inline nda::array<int, 2> box_idx(int nbox, int dim) {
+  int n2   = 2 * nbox;
+  int npts = 1;
+  for (int d = 0; d < dim; ++d) { npts *= n2; }
+
+  auto idx = nda::array<int, 2>(npts, dim);
+  for (int i = 0; i < npts; ++i) {
+    int j = i;
+    for (int d = dim - 1; d >= 0; --d) {
+      idx(i, d) = j % n2 - nbox;
+      j /= n2;
+    }
+  }
+  return idx;
+}
+
+/*!
+ * \brief Three-point function for tests, given by its Lehmann representation
+ * with explicit poles, one term in each of the three terms of the 2D DLR
+ *
+ * The poles satisfy |beta * omega| < 8 for beta <= 8, so the function is
+ * represented by the 2D DLR with lambda = 8.
+ *
+ * \param[in] z1 First complex frequency
+ * \param[in] z2 Second complex frequency
+ *
+ * \return Value of three-point function
+ */
+inline std::complex<double> lehmann3(std::complex<double> z1, std::complex<double> z2) {
+  return 1.0 / ((z1 - 0.3) * (z2 + 0.5)) + 0.5 / ((z2 - 0.7) * (z1 + z2 + 0.2)) - 0.7 / ((z1 + 0.8) * (z1 + z2 - 0.45));
+}
+
+/*!
+ * \brief Sample \ref lehmann3 at fermionic/fermionic Matsubara frequency index
+ * pairs
+ *
+ * \param[in] beta Inverse temperature
+ * \param[in] idx  Matsubara frequency index pairs
+ *
+ * \return Values of three-point function
+ */
+inline nda::vector<std::complex<double>> lehmann3_if(double beta, nda::array_const_view<int, 2> idx) {
+  auto vals = nda::vector<std::complex<double>>(idx.shape(0));
+  for (int j = 0; j < idx.shape(0); ++j) {
+    vals(j) = lehmann3((2 * idx(j, 0) + 1) * dlr2d::pi * 1i / beta, (2 * idx(j, 1) + 1) * dlr2d::pi * 1i / beta);
+  }
+  return vals;
+}
+
+/*!
+ * \brief Relative error on a box of the 2D DLR fit of \ref lehmann3 from its
+ * values on a given grid
+ *
+ * \param[in] beta     Inverse temperature
+ * \param[in] lambda   DLR cutoff
+ * \param[in] eps      DLR tolerance
+ * \param[in] dlr2d_if 2D DLR Matsubara frequency grid
+ * \param[in] nbox     Half-width of box of test points
+ *
+ * \return Maximum error on box, relative to maximum of function on box
+ */
+inline double lehmann_fit_error(double beta, double lambda, double eps, nda::array_const_view<int, 2> dlr2d_if, int nbox) {
+  auto dlr_rf           = cppdlr::build_dlr_rf(lambda, eps);
+  int r                 = dlr_rf.size();
+  auto cf2if            = dlr2d::build_cf2if(beta, dlr_rf, dlr2d_if);
+  auto [gc_reg, gc_sng] = dlr2d::vals2coefs_if(cf2if, lehmann3_if(beta, dlr2d_if), r);
+
+  auto idx = box_idx(nbox, 2);
+  auto tru = lehmann3_if(beta, idx);
+  auto fit = dlr2d::coefs2eval_if(beta, dlr_rf, gc_reg, gc_sng, idx, 1);
+
+  return max_element(abs(tru - fit)) / max_element(abs(tru));
+}